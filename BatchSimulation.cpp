@@ -0,0 +1,385 @@
+// BatchSimulation.cpp
+#include "BatchSimulation.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// LANES cells of one plane; GCC and Clang map the operators to SIMD instructions
+typedef uint8_t Lanes __attribute__((vector_size(BatchSimulation::LANES)));
+
+static Lanes loadLanes(const uint8_t *cells)
+{
+    Lanes lanes;
+    std::memcpy(&lanes, cells, sizeof(lanes));
+    return lanes;
+}
+
+static void storeLanes(uint8_t *cells, Lanes lanes)
+{
+    std::memcpy(cells, &lanes, sizeof(lanes));
+}
+
+static int sumLanes(Lanes lanes)
+{
+    int sum = 0;
+    for (int lane = 0; lane < BatchSimulation::LANES; lane++)
+        sum += lanes[lane];
+    return sum;
+}
+
+static bool anyLanes(Lanes lanes)
+{
+    uint64_t halves[2];
+    std::memcpy(halves, &lanes, sizeof(halves));
+    return (halves[0] | halves[1]) != 0;
+}
+
+// Call visit(lane) for each lane that is not zero, in lane order
+template <typename Visit>
+static void forEachLane(Lanes lanes, Visit visit)
+{
+    uint64_t halves[2];
+    std::memcpy(halves, &lanes, sizeof(halves));
+    for (int half = 0; half < 2; half++)
+    {
+        for (uint64_t bits = halves[half]; bits != 0;)
+        {
+            int lane = __builtin_ctzll(bits) / 8;
+            bits &= ~(0xffull << (lane * 8));
+            visit(half * 8 + lane);
+        }
+    }
+}
+
+static int roundUp(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+BatchSimulation::BatchSimulation()
+    : tileWidth(0), tileHeight(0), tileCells(0), pollutionWidth(0), pollutionHeight(0), pollutionCells(0),
+      offsets{0, 0, 0, 0, 0, 0, 0, 0}
+{
+}
+
+void BatchSimulation::load(const std::vector<std::shared_ptr<const Layout>> &regions)
+{
+    layouts = regions;
+    int maxWidth = 0, maxHeight = 0;
+    for (const std::shared_ptr<const Layout> &layout : layouts)
+    {
+        maxWidth = std::max(maxWidth, layout->getWidth());
+        maxHeight = std::max(maxHeight, layout->getHeight());
+    }
+
+    tileWidth = maxWidth + 2;
+    tileHeight = maxHeight + 2;
+    // Room for the last kernel pass to run past the bottom border
+    tileCells = roundUp(tileWidth * tileHeight + LANES, LANES);
+    pollutionWidth = maxWidth + 2 * POLLUTION_RADIUS;
+    pollutionHeight = maxHeight + 2 * POLLUTION_RADIUS;
+    pollutionCells = pollutionWidth * pollutionHeight;
+    for (int k = 0; k < 8; k++)
+        offsets[k] = Layout::NEIGHBOUR_DY[k] * tileWidth + Layout::NEIGHBOUR_DX[k];
+
+    size_t count = layouts.size();
+    size_t planeCells = count * tileCells + 2 * LANES;
+    population.assign(planeCells, 0);
+    sameType.assign(planeCells, 0);
+    limit.assign(planeCells, 0);
+    powered.assign(planeCells, 0);
+    pollution.assign(count * pollutionCells, 0);
+    totals.assign(3 * count, 0);
+    availableWorkers.assign(count, 0);
+    availableGoods.assign(count, 0);
+    steps.assign(count, 0);
+    converged.assign(count, 0);
+    hasPlants.assign(count, 0);
+    grow.assign(tileCells, 0);
+    bucket.assign(tileCells, 0);
+
+    active.clear();
+    for (size_t region = 0; region < count; region++)
+    {
+        const Layout &layout = *layouts[region];
+        int base = tileBase(region);
+        for (int y = 0; y < layout.getHeight(); y++)
+        {
+            for (int x = 0; x < layout.getWidth(); x++)
+            {
+                int index = layout.indexOf(x, y);
+                int cell = (y + 1) * tileWidth + x + 1;
+                char type = layout.getType(index);
+                uint8_t zoneLimit = type == 'R' ? RESIDENTIAL_LIMIT
+                                  : (type == 'I' ? INDUSTRIAL_LIMIT : (type == 'C' ? COMMERCIAL_LIMIT : 0));
+                if (zoneLimit > 0)
+                {
+                    limit[base + cell] = zoneLimit;
+                    sameType[base + cell] = layout.getSameTypeNeighbours(index);
+                    powered[base + cell] = layout.isPowered(index) ? 0xff : 0;
+                }
+                else if (type == 'P')
+                {
+                    hasPlants[region] = 1;
+                    for (int level = 0; level < PLANT_POLLUTION; level++)
+                        raiseSquare(region, cell, level);
+                }
+            }
+        }
+        active.push_back(region);
+    }
+}
+
+// Same-type neighbours at or above each cell's threshold, unrolled over
+// the eight offsets; neighbour bit K of mask selects offset K
+template <size_t... K>
+static Lanes countAdjacent(const uint8_t *cells, const int offsets[8], Lanes mask, Lanes threshold,
+                           std::index_sequence<K...>)
+{
+    // A lane that is all ones counts as one when subtracted
+    return Lanes{} - ((((Lanes)(loadLanes(cells + offsets[K]) >= threshold) &
+                        (Lanes)((mask & (uint8_t)(1 << K)) != 0))) + ...);
+}
+
+void BatchSimulation::findCandidates(int base, int counts[3])
+{
+    const uint8_t *pop = &population[base];
+    const Lanes one = Lanes{} + 1;
+    Lanes residential = {}, industrial = {}, commercial = {};
+    counts[0] = counts[1] = counts[2] = 0;
+
+    int chunks = roundUp(tileWidth * (tileHeight - 2), LANES) / LANES;
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        int i = tileWidth + chunk * LANES;
+        Lanes current = loadLanes(pop + i);
+        Lanes zoneLimit = loadLanes(&limit[base + i]);
+
+        // Each rule counts neighbours with at least the cell's own
+        // population, and at least 1 for empty cells
+        Lanes threshold = current + ((Lanes)(current == 0) & one);
+        Lanes adjacent = countAdjacent(pop + i, offsets, loadLanes(&sameType[base + i]), threshold,
+                                       std::make_index_sequence<8>());
+
+        // The zone systems' growth rules, below the zone's maximum population
+        Lanes rule = ((Lanes)(current == 0) & (loadLanes(&powered[base + i]) | (Lanes)(adjacent >= 1))) |
+                     ((Lanes)(current == 1) & (Lanes)(adjacent >= 2)) |
+                     ((Lanes)(current == 2) & (Lanes)(adjacent >= 4)) |
+                     ((Lanes)(current == 3) & (Lanes)(adjacent >= 6));
+        Lanes candidate = rule & (Lanes)(current < zoneLimit) & one;
+        storeLanes(&grow[i], candidate);
+
+        residential += candidate & (Lanes)(zoneLimit == RESIDENTIAL_LIMIT);
+        industrial += candidate & (Lanes)(zoneLimit == INDUSTRIAL_LIMIT);
+        commercial += candidate & (Lanes)(zoneLimit == COMMERCIAL_LIMIT);
+
+        // Lane counters hold up to 255
+        if (chunk % 255 == 254 || chunk == chunks - 1)
+        {
+            counts[0] += sumLanes(residential);
+            counts[1] += sumLanes(industrial);
+            counts[2] += sumLanes(commercial);
+            residential = industrial = commercial = Lanes{};
+        }
+    }
+}
+
+void BatchSimulation::selectCandidates(int base, uint8_t zoneLimit, int affordable)
+{
+    const Lanes one = Lanes{} + 1;
+    const Lanes zone = Lanes{} + zoneLimit;
+    int chunks = roundUp(tileWidth * (tileHeight - 2), LANES) / LANES;
+
+    // Highest priority in bucket 0: population, then populated same-type
+    // neighbours, which the kernel counted against each cell's own population
+    int counts[BUCKETS] = {};
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        int i = tileWidth + chunk * LANES;
+        Lanes candidate = (Lanes)(loadLanes(&grow[i]) != 0) & (Lanes)(loadLanes(&limit[base + i]) == zone);
+        if (!anyLanes(candidate))
+            continue;
+        Lanes current = loadLanes(&population[base + i]);
+        Lanes adjacent = countAdjacent(&population[base + i], offsets, loadLanes(&sameType[base + i]), one,
+                                       std::make_index_sequence<8>());
+        storeLanes(&bucket[i], (Lanes{} + (BUCKETS - 1)) - (current * 9 + adjacent));
+        forEachLane(candidate, [&](int lane) { counts[bucket[i + lane]]++; });
+    }
+
+    // Buckets before cutoff grow entirely, the cutoff bucket in row-major order
+    int cutoff = BUCKETS;
+    int quota = affordable;
+    for (int b = 0; b < BUCKETS; b++)
+    {
+        if (counts[b] > quota)
+        {
+            cutoff = b;
+            break;
+        }
+        quota -= counts[b];
+    }
+
+    const Lanes cutoffLanes = Lanes{} + static_cast<uint8_t>(cutoff);
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        int i = tileWidth + chunk * LANES;
+        Lanes growing = loadLanes(&grow[i]);
+        Lanes candidate = (Lanes)(growing != 0) & (Lanes)(loadLanes(&limit[base + i]) == zone);
+        if (!anyLanes(candidate))
+            continue;
+        Lanes priority = loadLanes(&bucket[i]);
+        Lanes drop = candidate & (Lanes)(priority > cutoffLanes);
+        storeLanes(&grow[i], growing & ~drop);
+        forEachLane(candidate & (Lanes)(priority == cutoffLanes), [&](int lane) {
+            if (quota-- <= 0)
+                grow[i + lane] = 0;
+        });
+    }
+}
+
+void BatchSimulation::raiseSquare(int region, int index, int level)
+{
+    int x = index % tileWidth - 1;
+    int y = index / tileWidth - 1;
+    for (int dy = -level; dy <= level; dy++)
+    {
+        uint16_t *row = &pollution[pollutionBase(region) + (y + dy + POLLUTION_RADIUS) * pollutionWidth + x +
+                                   POLLUTION_RADIUS];
+        for (int dx = -level; dx <= level; dx++)
+            row[dx]++;
+    }
+}
+
+void BatchSimulation::stepRegion(int region)
+{
+    int base = tileBase(region);
+    int *total = &totals[3 * region];
+    int workers = total[0];
+    int goods = total[1];
+
+    int counts[3];
+    findCandidates(base, counts);
+
+    // Commercial before industrial; ordering only matters when resources run short
+    int commercial = std::min(counts[2], std::min(workers, goods));
+    if (commercial < counts[2])
+        selectCandidates(base, COMMERCIAL_LIMIT, commercial);
+    workers -= commercial;
+    goods -= commercial;
+
+    int industrial = std::min(counts[1], workers / 2);
+    if (industrial < counts[1])
+        selectCandidates(base, INDUSTRIAL_LIMIT, industrial);
+    workers -= 2 * industrial;
+    goods += industrial;
+
+    int chunks = roundUp(tileWidth * (tileHeight - 2), LANES) / LANES;
+    const Lanes industrialLimit = Lanes{} + INDUSTRIAL_LIMIT;
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        int i = tileWidth + chunk * LANES;
+        Lanes growing = loadLanes(&grow[i]);
+        Lanes current = loadLanes(&population[base + i]);
+
+        // A source of level p reaches distance p - 1; one more level reaches one cell further
+        if (industrial > 0)
+        {
+            forEachLane(growing & (Lanes)(loadLanes(&limit[base + i]) == industrialLimit),
+                        [&](int lane) { raiseSquare(region, i + lane, population[base + i + lane]); });
+        }
+        storeLanes(&population[base + i], current + growing);
+    }
+
+    total[0] += counts[0];
+    total[1] += industrial;
+    total[2] += commercial;
+    availableWorkers[region] = workers;
+    availableGoods[region] = goods;
+
+    // Pollution only changes with industrial growth, apart from plants in the first step
+    bool changed = counts[0] + industrial + commercial > 0 || (steps[region] == 0 && hasPlants[region]);
+    steps[region]++;
+    if (!changed)
+        converged[region] = 1;
+}
+
+int BatchSimulation::step()
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < active.size(); i++)
+    {
+        int region = active[i];
+        stepRegion(region);
+        if (!converged[region])
+            active[kept++] = region;
+    }
+    active.resize(kept);
+    return static_cast<int>(kept);
+}
+
+int BatchSimulation::run(int maxSteps)
+{
+    int sweeps = 0;
+    while (sweeps < maxSteps && !active.empty())
+    {
+        step();
+        sweeps++;
+    }
+    return sweeps;
+}
+
+BatchResult BatchSimulation::getResult(int region) const
+{
+    BatchResult result;
+    result.steps = steps[region];
+    result.converged = converged[region] != 0;
+    result.residentialPopulation = totals[3 * region];
+    result.industrialPopulation = totals[3 * region + 1];
+    result.commercialPopulation = totals[3 * region + 2];
+    result.availableWorkers = availableWorkers[region];
+    result.availableGoods = availableGoods[region];
+
+    result.totalPollution = 0;
+    if (steps[region] > 0)
+    {
+        const Layout &layout = *layouts[region];
+        for (int y = 0; y < layout.getHeight(); y++)
+        {
+            const uint16_t *row = &pollution[pollutionBase(region) + (y + POLLUTION_RADIUS) * pollutionWidth +
+                                             POLLUTION_RADIUS];
+            for (int x = 0; x < layout.getWidth(); x++)
+                result.totalPollution += row[x];
+        }
+    }
+    return result;
+}
+
+void BatchSimulation::readCells(int region, std::vector<Cell> &cells) const
+{
+    const Layout &layout = *layouts[region];
+    int base = tileBase(region);
+    cells.resize(layout.getCellCount());
+    for (int y = 0; y < layout.getHeight(); y++)
+    {
+        for (int x = 0; x < layout.getWidth(); x++)
+        {
+            Cell &cell = cells[layout.indexOf(x, y)];
+            cell.setType(layout.getType(layout.indexOf(x, y)));
+            cell.setPopulation(population[base + (y + 1) * tileWidth + x + 1]);
+            // Pollution is first computed by the first step
+            cell.setPollution(steps[region] == 0 ? 0
+                                                 : pollution[pollutionBase(region) +
+                                                             (y + POLLUTION_RADIUS) * pollutionWidth + x +
+                                                             POLLUTION_RADIUS]);
+        }
+    }
+}
+
+size_t BatchSimulation::getMemoryBytes() const
+{
+    return population.capacity() + sameType.capacity() + limit.capacity() + powered.capacity() +
+           pollution.capacity() * sizeof(uint16_t) +
+           (totals.capacity() + availableWorkers.capacity() + availableGoods.capacity() + steps.capacity() +
+            active.capacity()) * sizeof(int) +
+           converged.capacity() + hasPlants.capacity() + grow.capacity() + bucket.capacity();
+}
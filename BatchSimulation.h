@@ -0,0 +1,117 @@
+// BatchSimulation.h
+// Steps many small independent regions together, for workloads that run
+// thousands of little cities instead of one big one. All regions share one
+// structure-of-arrays block: each plane (population, neighbour masks, zone
+// limits, power, pollution) holds one tile per region, region after
+// region, and every tile has the shape of the largest region plus a border
+// of empty cells. With one tile shape the neighbour offsets are the same
+// for every region, so a sweep runs the growth rules over each tile 16
+// cells at a time. Regions that stop changing leave the active set and
+// cost nothing in later sweeps. Results are identical to the reference
+// engine's; regions start unpopulated, as loaded from a region file.
+#ifndef BATCH_SIMULATION_H
+#define BATCH_SIMULATION_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "Cell.h"
+#include "Layout.h"
+
+struct BatchResult
+{
+    int steps;      // Steps taken, including the one that changed nothing
+    bool converged; // Whether the region stopped changing
+    int residentialPopulation;
+    int industrialPopulation;
+    int commercialPopulation;
+    int totalPollution;
+    int availableWorkers; // Resources left over after the last step
+    int availableGoods;
+};
+
+class BatchSimulation
+{
+public:
+    // Cells the growth kernel handles at once
+    static const int LANES = 16;
+
+    BatchSimulation();
+
+    // Pack the regions into tiles; regions of similar size waste the least
+    // space, since every tile is as large as the largest region
+    void load(const std::vector<std::shared_ptr<const Layout>> &layouts);
+
+    // Advance every active region one step; returns the regions still active
+    int step();
+
+    // Sweep until no region is active or maxSteps sweeps were made; returns
+    // the number of sweeps
+    int run(int maxSteps);
+
+    int getRegionCount() const { return static_cast<int>(layouts.size()); }
+    int getActiveCount() const { return static_cast<int>(active.size()); }
+    int getTileWidth() const { return tileWidth; }
+    int getTileHeight() const { return tileHeight; }
+
+    BatchResult getResult(int region) const;
+
+    // The region's cells in row-major order
+    void readCells(int region, std::vector<Cell> &cells) const;
+
+    size_t getMemoryBytes() const;
+
+private:
+    static const int POLLUTION_RADIUS = 3;
+    static const int PLANT_POLLUTION = 4;
+    static const int BUCKETS = 3 * 9; // Population 0..2 by 0..8 populated neighbours
+
+    // Zone limits double as zone codes: a cell grows while below its limit
+    static const uint8_t RESIDENTIAL_LIMIT = 4;
+    static const uint8_t INDUSTRIAL_LIMIT = 3;
+    static const uint8_t COMMERCIAL_LIMIT = 2;
+
+    int tileBase(int region) const { return LANES + region * tileCells; }
+    int pollutionBase(int region) const { return region * pollutionCells; }
+
+    // Run the growth rules over one tile into grow; counts
+    // receives the residential, industrial and commercial candidates
+    void findCandidates(int base, int counts[3]);
+
+    // Keep only the affordable candidates of one zone, in priority order
+    void selectCandidates(int base, uint8_t zoneLimit, int affordable);
+
+    void stepRegion(int region);
+
+    // Add 1 to the region's pollution within distance level of tile cell index
+    void raiseSquare(int region, int index, int level);
+
+    std::vector<std::shared_ptr<const Layout>> layouts;
+    int tileWidth, tileHeight; // Growth tiles, with a 1-cell border
+    int tileCells;             // Tile stride, rounded so a kernel pass never leaves its tile
+    int pollutionWidth, pollutionHeight, pollutionCells; // With a 3-cell border
+    int offsets[8];
+
+    // One tile per region; LANES padding cells before the first tile
+    std::vector<uint8_t> population;
+    std::vector<uint8_t> sameType; // Bit k: neighbour k has the same zone type
+    std::vector<uint8_t> limit;    // Zone's maximum population, 0 outside zones
+    std::vector<uint8_t> powered;  // 0xff next to power, else 0
+    std::vector<uint16_t> pollution; // As implied by the current populations
+
+    // Per-region state
+    std::vector<int> totals; // Residential, industrial, commercial per region
+    std::vector<int> availableWorkers;
+    std::vector<int> availableGoods;
+    std::vector<int> steps;
+    std::vector<uint8_t> converged;
+    std::vector<uint8_t> hasPlants;
+    std::vector<int> active;
+
+    // Kernel output and candidate priorities for the tile being stepped
+    std::vector<uint8_t> grow;
+    std::vector<uint8_t> bucket;
+};
+
+#endif // BATCH_SIMULATION_H
@@ -0,0 +1,398 @@
+// CApi.cpp
+// The C interface in simcity.h, as a thin layer over Simulation and
+// Snapshot. No exception crosses the interface: failures become error
+// codes with a message kept on the handle.
+#include "simcity.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include <sstream>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstring>
+#include <algorithm>
+
+struct simcity_sim
+{
+    Simulation simulation;
+    bool loaded = false;
+    std::string error;
+    std::vector<const void *> rows[3]; // Row tables handed out by simcity_get_plane, per field
+};
+
+struct simcity_snapshot
+{
+    Snapshot snapshot;
+};
+
+static int fail(simcity_sim *sim, int code, const std::string &message)
+{
+    if (sim)
+        sim->error = message;
+    return code;
+}
+
+// Run body, turning exceptions into SIMCITY_ERROR_INTERNAL
+template <typename Body>
+static int guarded(simcity_sim *sim, Body body)
+{
+    if (!sim)
+        return SIMCITY_ERROR_ARGUMENT;
+    try
+    {
+        sim->error.clear();
+        return body();
+    }
+    catch (const std::exception &e)
+    {
+        return fail(sim, SIMCITY_ERROR_INTERNAL, e.what());
+    }
+    catch (...)
+    {
+        return fail(sim, SIMCITY_ERROR_INTERNAL, "Unknown error");
+    }
+}
+
+static int requireLoaded(simcity_sim *sim)
+{
+    return sim->loaded ? SIMCITY_OK : fail(sim, SIMCITY_ERROR_STATE, "No region loaded");
+}
+
+// Struct sizes as of ABI 2, the first with struct_size; callers built
+// against that header or a later one have at least these
+static const uint32_t MIN_SUMMARY_SIZE = sizeof(simcity_step_summary);
+static const uint32_t MIN_AREA_SIZE = sizeof(simcity_area);
+static const uint32_t MIN_PLANE_SIZE = sizeof(simcity_plane);
+
+// Whether the caller's struct is null or has all fields of the first version
+template <typename Struct>
+static bool hasRoom(const Struct *to, uint32_t minimumSize)
+{
+    return !to || to->struct_size >= minimumSize;
+}
+
+// Write out, all fields filled in, into the caller's struct; a struct
+// from an older header only receives the fields it has
+template <typename Struct>
+static void copyOut(Struct &out, Struct *to)
+{
+    out.struct_size = to->struct_size;
+    std::memcpy(to, &out, std::min<size_t>(to->struct_size, sizeof(Struct)));
+}
+
+static void copySummary(const StepSummary &from, simcity_step_summary *to)
+{
+    if (!to)
+        return;
+    simcity_step_summary out;
+    std::memset(&out, 0, sizeof(out));
+    out.step = from.step;
+    out.changed = from.changed ? 1 : 0;
+    out.period = from.period;
+    out.workers = from.workers;
+    out.goods = from.goods;
+    out.workers_used = from.workersUsed;
+    out.goods_used = from.goodsUsed;
+    out.available_workers = from.availableWorkers;
+    out.available_goods = from.availableGoods;
+    out.changes = from.changes;
+    out.duration_ns = from.durationNs;
+    out.hash = from.hash;
+    copyOut(out, to);
+}
+
+static void copyArea(const AreaStats &from, simcity_area *to)
+{
+    simcity_area out;
+    std::memset(&out, 0, sizeof(out));
+    out.residential = from.residential;
+    out.industrial = from.industrial;
+    out.commercial = from.commercial;
+    out.pollution = from.pollution;
+    copyOut(out, to);
+}
+
+extern "C" {
+
+int simcity_abi_version(void)
+{
+    return SIMCITY_ABI_VERSION;
+}
+
+simcity_sim *simcity_create(void)
+{
+    return new (std::nothrow) simcity_sim();
+}
+
+void simcity_destroy(simcity_sim *sim)
+{
+    delete sim;
+}
+
+const char *simcity_last_error(const simcity_sim *sim)
+{
+    return sim ? sim->error.c_str() : "Null handle";
+}
+
+int simcity_load(simcity_sim *sim, const char *path)
+{
+    return guarded(sim, [&]() -> int
+    {
+        if (!path)
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Null path");
+        std::string error;
+        if (!sim->simulation.load(path, error))
+            return fail(sim, SIMCITY_ERROR_LOAD, error);
+        sim->loaded = true;
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_load_buffer(simcity_sim *sim, const char *data, size_t length)
+{
+    return guarded(sim, [&]() -> int
+    {
+        if (!data && length > 0)
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Null data");
+        std::istringstream in(std::string(data ? data : "", length));
+        std::string error;
+        if (!sim->simulation.load(in, error))
+            return fail(sim, SIMCITY_ERROR_LOAD, error);
+        sim->loaded = true;
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_set_engine(simcity_sim *sim, const char *engine)
+{
+    return guarded(sim, [&]() -> int
+    {
+        StepEngine parsed;
+        if (!engine || !Simulation::parseEngine(engine, parsed))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Engine must be reference, sparse or adaptive");
+        sim->simulation.setEngine(parsed);
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_set_cycle_window(simcity_sim *sim, int32_t steps)
+{
+    return guarded(sim, [&]() -> int
+    {
+        if (steps <= 0)
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Cycle window must be positive");
+        sim->simulation.setCycleWindow(steps);
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_enable_history(simcity_sim *sim)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status == SIMCITY_OK && !sim->simulation.enableHistory())
+            return fail(sim, SIMCITY_ERROR_STATE, "Region too large for the history budget");
+        return status;
+    });
+}
+
+int simcity_step(simcity_sim *sim, simcity_step_summary *summary)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status != SIMCITY_OK)
+            return status;
+        if (!hasRoom(summary, MIN_SUMMARY_SIZE))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Summary struct_size is too small");
+        copySummary(sim->simulation.step(), summary);
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_run(simcity_sim *sim, int32_t max_steps, int32_t *steps_taken, simcity_step_summary *last)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status != SIMCITY_OK)
+            return status;
+        if (!hasRoom(last, MIN_SUMMARY_SIZE))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Summary struct_size is too small");
+        int32_t taken = 0;
+        StepSummary summary;
+        StepGenerator steps = sim->simulation.steps(max_steps);
+        while (steps.next(summary))
+        {
+            taken++;
+            copySummary(summary, last);
+        }
+        if (steps_taken)
+            *steps_taken = taken;
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_set_cell_type(simcity_sim *sim, int32_t x, int32_t y, char type)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status == SIMCITY_OK && !sim->simulation.setCellType(x, y, type))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Bad position or cell type");
+        return status;
+    });
+}
+
+int32_t simcity_width(const simcity_sim *sim)
+{
+    return sim ? sim->simulation.getWidth() : 0;
+}
+
+int32_t simcity_height(const simcity_sim *sim)
+{
+    return sim ? sim->simulation.getHeight() : 0;
+}
+
+int32_t simcity_step_count(const simcity_sim *sim)
+{
+    return sim ? sim->simulation.getStepCount() : 0;
+}
+
+int64_t simcity_total_population(const simcity_sim *sim, char type)
+{
+    return sim ? sim->simulation.getTotalPopulation(type) : 0;
+}
+
+int64_t simcity_total_pollution(const simcity_sim *sim)
+{
+    return sim ? sim->simulation.getTotalPollution() : 0;
+}
+
+int simcity_get_plane(simcity_sim *sim, simcity_plane_field field, simcity_plane *plane)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status != SIMCITY_OK)
+            return status;
+        if (!plane)
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Null plane");
+        if (!hasRoom(plane, MIN_PLANE_SIZE))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Plane struct_size is too small");
+
+        int offset;
+        switch (field)
+        {
+        case SIMCITY_PLANE_TYPE:
+            offset = Cell::typeOffset();
+            break;
+        case SIMCITY_PLANE_POPULATION:
+            offset = Cell::populationOffset();
+            break;
+        case SIMCITY_PLANE_POLLUTION:
+            offset = Cell::pollutionOffset();
+            break;
+        default:
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Unknown plane");
+        }
+
+        // Point straight into the grid; the sparse engine copies its chunks back first
+        const std::vector<std::vector<Cell>> &grid = sim->simulation.getGrid();
+        std::vector<const void *> &rows = sim->rows[field];
+        rows.resize(grid.size());
+        for (size_t y = 0; y < grid.size(); y++)
+            rows[y] = reinterpret_cast<const char *>(grid[y].data()) + offset;
+        simcity_plane out;
+        std::memset(&out, 0, sizeof(out));
+        out.width = sim->simulation.getWidth();
+        out.height = sim->simulation.getHeight();
+        out.element_size = field == SIMCITY_PLANE_TYPE ? 1 : 4;
+        out.stride = sizeof(Cell);
+        out.rows = rows.data();
+        copyOut(out, plane);
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_analyze_area(simcity_sim *sim, int32_t x1, int32_t y1, int32_t x2, int32_t y2, simcity_area *area)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status != SIMCITY_OK)
+            return status;
+        if (!hasRoom(area, MIN_AREA_SIZE))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Area struct_size is too small");
+        AreaStats stats;
+        if (!area || !sim->simulation.analyzeArea(x1, y1, x2, y2, stats))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Area is not inside the region");
+        copyArea(stats, area);
+        return SIMCITY_OK;
+    });
+}
+
+int simcity_analyze_area_at(simcity_sim *sim, int32_t step, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                            simcity_area *area)
+{
+    return guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status != SIMCITY_OK)
+            return status;
+        if (!hasRoom(area, MIN_AREA_SIZE))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Area struct_size is too small");
+        const HistoryStore *history = sim->simulation.getHistory();
+        if (!history || !history->hasStep(step))
+            return fail(sim, SIMCITY_ERROR_STATE, "Step is not in the history");
+        AreaStats stats;
+        if (!area || !sim->simulation.analyzeAreaAt(step, x1, y1, x2, y2, stats))
+            return fail(sim, SIMCITY_ERROR_ARGUMENT, "Area is not inside the region");
+        copyArea(stats, area);
+        return SIMCITY_OK;
+    });
+}
+
+simcity_snapshot *simcity_snapshot_create(simcity_sim *sim)
+{
+    simcity_snapshot *snapshot = nullptr;
+    int status = guarded(sim, [&]() -> int
+    {
+        int status = requireLoaded(sim);
+        if (status != SIMCITY_OK)
+            return status;
+        snapshot = new simcity_snapshot();
+        snapshot->snapshot.build(sim->simulation);
+        return SIMCITY_OK;
+    });
+    if (status != SIMCITY_OK)
+    {
+        delete snapshot;
+        return nullptr;
+    }
+    return snapshot;
+}
+
+void simcity_snapshot_destroy(simcity_snapshot *snapshot)
+{
+    delete snapshot;
+}
+
+int32_t simcity_snapshot_step(const simcity_snapshot *snapshot)
+{
+    return snapshot ? snapshot->snapshot.getStep() : 0;
+}
+
+int simcity_snapshot_area(const simcity_snapshot *snapshot, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                          simcity_area *area)
+{
+    AreaStats stats;
+    if (!snapshot || !area || !hasRoom(area, MIN_AREA_SIZE) ||
+        !snapshot->snapshot.analyzeArea(x1, y1, x2, y2, stats))
+        return SIMCITY_ERROR_ARGUMENT;
+    copyArea(stats, area);
+    return SIMCITY_OK;
+}
+
+} // extern "C"
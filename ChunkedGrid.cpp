@@ -0,0 +1,583 @@
+// ChunkedGrid.cpp
+#include "ChunkedGrid.h"
+#include "RegionReader.h"
+#include "Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+const int ChunkedGrid::CHUNK_SHIFT;
+const int ChunkedGrid::CHUNK_SIZE;
+const int ChunkedGrid::CHUNK_MASK;
+const int ChunkedGrid::POLLUTION_RADIUS;
+const int ChunkedGrid::PLANT_POLLUTION;
+
+ChunkedGrid::ChunkedGrid()
+    : width(0), height(0), chunksX(0), chunksY(0), timeStep(0),
+      totals{0, 0, 0}, totalPollution(0), availableWorkers(0), availableGoods(0) {}
+
+int ChunkedGrid::zoneSlot(char type)
+{
+    switch (type)
+    {
+    case 'R':
+        return 0;
+    case 'C':
+        return 1;
+    case 'I':
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+bool ChunkedGrid::loadFromFile(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open region file: " << filename << std::endl;
+        return false;
+    }
+
+    try
+    {
+        RegionReader reader(file);
+        beginLoad(reader.getWidth(), reader.getHeight());
+        std::vector<char> row;
+        for (int y = 0; y < height; y++)
+        {
+            reader.readRow(y, row);
+            setRow(y, row);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading region file: " << e.what() << std::endl;
+        return false;
+    }
+
+    finishLoad(0);
+    return true;
+}
+
+void ChunkedGrid::loadFromGrid(const std::vector<std::vector<Cell>> &grid, int startStep)
+{
+    int newHeight = grid.size();
+    int newWidth = newHeight > 0 ? grid[0].size() : 0;
+    beginLoad(newWidth, newHeight);
+
+    std::vector<char> row(newWidth);
+    for (int y = 0; y < newHeight; y++)
+    {
+        for (int x = 0; x < newWidth; x++)
+            row[x] = grid[y][x].getType();
+        setRow(y, row);
+    }
+    finishLoad(startStep);
+
+    // Bring over any state the grid already has
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const Cell &cell = grid[y][x];
+            int slot = zoneSlot(cell.getType());
+            if (slot >= 0 && cell.getPopulation() > 0)
+            {
+                chunks[chunkIndex(x, y)]->population[localOffset(x, y)] = cell.getPopulation();
+                totals[slot] += cell.getPopulation();
+            }
+            if (cell.getPollution() > 0)
+                addPollution(x, y, cell.getPollution(), nullptr);
+        }
+    }
+}
+
+void ChunkedGrid::storeToGrid(std::vector<std::vector<Cell>> &grid) const
+{
+    grid.assign(height, std::vector<Cell>(width));
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            Cell &cell = grid[y][x];
+            cell.setType(getType(x, y));
+            cell.setPopulation(getPopulation(x, y));
+            cell.setPollution(getPollution(x, y));
+        }
+    }
+}
+
+void ChunkedGrid::beginLoad(int newWidth, int newHeight)
+{
+    width = newWidth;
+    height = newHeight;
+    chunksX = (width + CHUNK_MASK) >> CHUNK_SHIFT;
+    chunksY = (height + CHUNK_MASK) >> CHUNK_SHIFT;
+
+    chunks.clear();
+    chunks.resize(static_cast<size_t>(chunksX) * chunksY);
+    fillTypes.assign(chunks.size(), '-');
+    band.assign(static_cast<size_t>(CHUNK_SIZE) * width, '-');
+}
+
+void ChunkedGrid::setRow(int y, const std::vector<char> &row)
+{
+    std::copy(row.begin(), row.begin() + width, band.begin() + static_cast<size_t>(y & CHUNK_MASK) * width);
+    if ((y & CHUNK_MASK) == CHUNK_MASK || y == height - 1)
+        flushBand(y >> CHUNK_SHIFT);
+}
+
+// Turn the buffered rows of one chunk row into chunks
+void ChunkedGrid::flushBand(int chunkRow)
+{
+    int rows = std::min(CHUNK_SIZE, height - (chunkRow << CHUNK_SHIFT));
+
+    for (int cx = 0; cx < chunksX; cx++)
+    {
+        int x0 = cx << CHUNK_SHIFT;
+        int columns = std::min(CHUNK_SIZE, width - x0);
+        char first = band[x0];
+        bool uniform = true;
+        for (int ly = 0; ly < rows && uniform; ly++)
+        {
+            for (int lx = 0; lx < columns; lx++)
+            {
+                if (band[static_cast<size_t>(ly) * width + x0 + lx] != first)
+                {
+                    uniform = false;
+                    break;
+                }
+            }
+        }
+
+        int c = chunkRow * chunksX + cx;
+        fillTypes[c] = uniform ? first : 0;
+        if (uniform && zoneSlot(first) < 0 && first != 'P')
+            continue; // Inert and uniform: nothing to allocate
+
+        std::unique_ptr<Chunk> chunk(new Chunk());
+        if (!uniform)
+            chunk->types.assign(CHUNK_SIZE * CHUNK_SIZE, '-');
+
+        for (int ly = 0; ly < rows; ly++)
+        {
+            for (int lx = 0; lx < columns; lx++)
+            {
+                char type = band[static_cast<size_t>(ly) * width + x0 + lx];
+                int offset = (ly << CHUNK_SHIFT) | lx;
+                if (!uniform)
+                    chunk->types[offset] = type;
+                if (zoneSlot(type) >= 0)
+                    chunk->zoneCells.push_back(offset);
+                else if (type == 'P')
+                    chunk->plants.push_back(offset);
+            }
+        }
+
+        if (!chunk->zoneCells.empty())
+            chunk->population.assign(CHUNK_SIZE * CHUNK_SIZE, 0);
+        chunks[c] = std::move(chunk);
+    }
+}
+
+void ChunkedGrid::finishLoad(int startStep)
+{
+    std::vector<char>().swap(band);
+    timeStep = startStep;
+    totals[0] = totals[1] = totals[2] = 0;
+    totalPollution = 0;
+    availableWorkers = availableGoods = 0;
+
+    // Every chunk with zone cells is evaluated in the first step
+    active.assign(chunks.size(), 0);
+    activeNext.assign(chunks.size(), 0);
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        if (chunks[c] && !chunks[c]->zoneCells.empty())
+            active[c] = 1;
+    }
+}
+
+char ChunkedGrid::getType(int x, int y) const
+{
+    int c = chunkIndex(x, y);
+    const Chunk *chunk = chunks[c].get();
+    if (chunk && !chunk->types.empty())
+        return chunk->types[localOffset(x, y)];
+    return fillTypes[c];
+}
+
+int ChunkedGrid::getPopulation(int x, int y) const
+{
+    const Chunk *chunk = chunks[chunkIndex(x, y)].get();
+    if (chunk && !chunk->population.empty())
+        return chunk->population[localOffset(x, y)];
+    return 0;
+}
+
+int ChunkedGrid::getPollution(int x, int y) const
+{
+    const Chunk *chunk = chunks[chunkIndex(x, y)].get();
+    if (chunk && !chunk->pollution.empty())
+        return chunk->pollution[localOffset(x, y)];
+    return 0;
+}
+
+int ChunkedGrid::getTotalPopulation(char type) const
+{
+    int slot = zoneSlot(type);
+    return slot >= 0 ? totals[slot] : 0;
+}
+
+int ChunkedGrid::getAllocatedChunks() const
+{
+    int count = 0;
+    for (const auto &chunk : chunks)
+    {
+        if (chunk)
+            count++;
+    }
+    return count;
+}
+
+int ChunkedGrid::getActiveChunks() const
+{
+    int count = 0;
+    for (size_t c = 0; c < active.size(); c++)
+    {
+        if (active[c] && chunks[c] && !chunks[c]->zoneCells.empty())
+            count++;
+    }
+    return count;
+}
+
+size_t ChunkedGrid::getMemoryBytes() const
+{
+    size_t bytes = sizeof(*this) + chunks.capacity() * sizeof(chunks[0]) +
+                   fillTypes.capacity() + active.capacity() + activeNext.capacity();
+    for (const auto &chunk : chunks)
+    {
+        if (!chunk)
+            continue;
+        bytes += sizeof(Chunk) + chunk->types.capacity() + chunk->population.capacity() +
+                 (chunk->pollution.capacity() + chunk->zoneCells.capacity() + chunk->plants.capacity()) * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+bool ChunkedGrid::isPowered(int x, int y) const
+{
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int newX = x + dx;
+            int newY = y + dy;
+            if ((dx == 0 && dy == 0) || newX < 0 || newX >= width || newY < 0 || newY >= height)
+                continue;
+
+            char type = getType(newX, newY);
+            if (type == 'T' || type == '#' || type == 'P')
+                return true;
+        }
+    }
+    return false;
+}
+
+int ChunkedGrid::countAdjacentPopulation(int x, int y, char type, int minPop) const
+{
+    int count = 0;
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int newX = x + dx;
+            int newY = y + dy;
+            if ((dx == 0 && dy == 0) || newX < 0 || newX >= width || newY < 0 || newY >= height)
+                continue;
+
+            if (getType(newX, newY) == type && getPopulation(newX, newY) >= minPop)
+                count++;
+        }
+    }
+    return count;
+}
+
+// Same growth rules as the three zone systems
+bool ChunkedGrid::canGrow(int x, int y, char type) const
+{
+    int pop = getPopulation(x, y);
+    int maxPop = type == 'R' ? 4 : (type == 'I' ? 3 : 2);
+    if (pop >= maxPop)
+        return false;
+
+    switch (pop)
+    {
+    case 0:
+        return isPowered(x, y) || countAdjacentPopulation(x, y, type, 1) >= 1;
+    case 1:
+        return countAdjacentPopulation(x, y, type, 1) >= 2;
+    case 2:
+        return countAdjacentPopulation(x, y, type, 2) >= 4;
+    case 3:
+        return countAdjacentPopulation(x, y, type, 3) >= 6;
+    default:
+        return false;
+    }
+}
+
+void ChunkedGrid::collectCandidates(char type, const std::vector<int> &activeList)
+{
+    candidates.clear();
+    for (int c : activeList)
+    {
+        const Chunk &chunk = *chunks[c];
+        int x0 = (c % chunksX) << CHUNK_SHIFT;
+        int y0 = (c / chunksX) << CHUNK_SHIFT;
+        for (uint16_t offset : chunk.zoneCells)
+        {
+            int x = x0 + (offset & CHUNK_MASK);
+            int y = y0 + (offset >> CHUNK_SHIFT);
+            char cellType = chunk.types.empty() ? fillTypes[c] : chunk.types[offset];
+            if (cellType == type && canGrow(x, y, type))
+            {
+                candidates.push_back({x, y, chunk.population[offset],
+                                      type == 'R' ? 0 : countAdjacentPopulation(x, y, type, 1), c});
+            }
+        }
+    }
+    PROFILE_COUNT(COUNTER_CANDIDATES, candidates.size());
+
+    if (type == 'R')
+        return; // Residential growth is not resource limited
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate &a, const Candidate &b)
+              {
+                  if (a.population != b.population)
+                      return a.population > b.population;
+                  if (a.adjacentPop != b.adjacentPop)
+                      return a.adjacentPop > b.adjacentPop;
+                  if (a.y != b.y)
+                      return a.y < b.y;
+                  return a.x < b.x;
+              });
+}
+
+// Wake every chunk whose cells could see (x, y) as a neighbour
+void ChunkedGrid::markChanged(int x, int y, std::vector<uint8_t> &flags)
+{
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int newX = x + dx;
+            int newY = y + dy;
+            if (newX >= 0 && newX < width && newY >= 0 && newY < height)
+                flags[chunkIndex(newX, newY)] = 1;
+        }
+    }
+}
+
+void ChunkedGrid::grow(const Candidate &cell, StateHash *hash)
+{
+    Chunk &chunk = *chunks[cell.chunk];
+    chunk.population[localOffset(cell.x, cell.y)] = cell.population + 1;
+    if (hash)
+        hash->updatePopulation(cell.x, cell.y, cell.population, cell.population + 1);
+    markChanged(cell.x, cell.y, activeNext);
+    PROFILE_COUNT(COUNTER_CELLS_GROWN, 1);
+    PROFILE_COUNT(COUNTER_VALUES_CHANGED, 1);
+}
+
+void ChunkedGrid::addPollution(int x, int y, int delta, StateHash *hash)
+{
+    int c = chunkIndex(x, y);
+    if (!chunks[c])
+        chunks[c].reset(new Chunk());
+    Chunk &chunk = *chunks[c];
+    if (chunk.pollution.empty())
+        chunk.pollution.assign(CHUNK_SIZE * CHUNK_SIZE, 0);
+
+    uint16_t &value = chunk.pollution[localOffset(x, y)];
+    if (hash)
+        hash->updatePollution(x, y, value, value + delta);
+    value += delta;
+    totalPollution += delta;
+    PROFILE_COUNT(COUNTER_VALUES_CHANGED, 1);
+}
+
+// Pollution is linear in its sources, so only the change of one source is applied
+void ChunkedGrid::spreadPollution(int x, int y, int oldSource, int newSource, StateHash *hash)
+{
+    for (int dy = -POLLUTION_RADIUS; dy <= POLLUTION_RADIUS; dy++)
+    {
+        int newY = y + dy;
+        if (newY < 0 || newY >= height)
+            continue;
+        for (int dx = -POLLUTION_RADIUS; dx <= POLLUTION_RADIUS; dx++)
+        {
+            int newX = x + dx;
+            if (newX < 0 || newX >= width)
+                continue;
+
+            int distance = std::max(std::abs(dx), std::abs(dy));
+            int delta = std::max(0, newSource - distance) - std::max(0, oldSource - distance);
+            if (delta != 0)
+                addPollution(newX, newY, delta, hash);
+        }
+    }
+}
+
+void ChunkedGrid::setType(int x, int y, char type, StateHash *hash)
+{
+    char oldType = getType(x, y);
+    if (type == oldType)
+        return;
+
+    // Give the chunk its own type array before it stops being uniform
+    int c = chunkIndex(x, y);
+    if (!chunks[c])
+        chunks[c].reset(new Chunk());
+    Chunk &chunk = *chunks[c];
+    if (chunk.types.empty())
+    {
+        chunk.types.assign(CHUNK_SIZE * CHUNK_SIZE, fillTypes[c]);
+        fillTypes[c] = 0;
+    }
+
+    uint16_t offset = localOffset(x, y);
+    chunk.types[offset] = type;
+
+    // Offset lists stay sorted, as the loader builds them
+    int oldSlot = zoneSlot(oldType);
+    int oldSource = 0;
+    if (oldSlot >= 0)
+    {
+        int oldPop = chunk.population[offset];
+        if (oldPop > 0)
+        {
+            if (hash)
+                hash->updatePopulation(x, y, oldPop, 0);
+            totals[oldSlot] -= oldPop;
+            chunk.population[offset] = 0;
+        }
+        if (oldType == 'I')
+            oldSource = oldPop;
+        chunk.zoneCells.erase(std::lower_bound(chunk.zoneCells.begin(), chunk.zoneCells.end(), offset));
+    }
+    else if (oldType == 'P')
+    {
+        oldSource = PLANT_POLLUTION;
+        chunk.plants.erase(std::lower_bound(chunk.plants.begin(), chunk.plants.end(), offset));
+    }
+
+    int newSource = 0;
+    if (zoneSlot(type) >= 0)
+    {
+        if (chunk.population.empty())
+            chunk.population.assign(CHUNK_SIZE * CHUNK_SIZE, 0);
+        chunk.zoneCells.insert(std::lower_bound(chunk.zoneCells.begin(), chunk.zoneCells.end(), offset), offset);
+    }
+    else if (type == 'P')
+    {
+        newSource = PLANT_POLLUTION;
+        chunk.plants.insert(std::lower_bound(chunk.plants.begin(), chunk.plants.end(), offset), offset);
+    }
+
+    // Before the first step no pollution has been applied yet; plants are picked up then
+    if (timeStep > 0 && oldSource != newSource)
+        spreadPollution(x, y, oldSource, newSource, hash);
+
+    // The type change can alter power and adjacency for the cell and its neighbours
+    markChanged(x, y, active);
+}
+
+bool ChunkedGrid::step(StateHash *hash)
+{
+    availableWorkers = totals[0];
+    availableGoods = totals[2];
+
+    // Neighbour wake-ups may flag chunks without zone cells; those have nothing to step
+    std::vector<int> activeList;
+    for (size_t c = 0; c < active.size(); c++)
+    {
+        if (active[c] && chunks[c] && !chunks[c]->zoneCells.empty())
+            activeList.push_back(c);
+    }
+    std::fill(activeNext.begin(), activeNext.end(), 0);
+
+    int grown = 0;
+
+    // Commercial, then industrial, in priority order; unserved candidates keep their chunk awake
+    collectCandidates('C', activeList);
+    for (const auto &cell : candidates)
+    {
+        if (availableWorkers >= 1 && availableGoods >= 1)
+        {
+            grow(cell, hash);
+            totals[1]++;
+            availableWorkers--;
+            availableGoods--;
+            grown++;
+            PROFILE_COUNT(COUNTER_WORKERS_CONSUMED, 1);
+            PROFILE_COUNT(COUNTER_GOODS_CONSUMED, 1);
+        }
+        else
+        {
+            activeNext[cell.chunk] = 1;
+        }
+    }
+
+    collectCandidates('I', activeList);
+    for (const auto &cell : candidates)
+    {
+        if (availableWorkers >= 2)
+        {
+            grow(cell, hash);
+            spreadPollution(cell.x, cell.y, cell.population, cell.population + 1, hash);
+            totals[2]++;
+            availableWorkers -= 2;
+            availableGoods++;
+            grown++;
+            PROFILE_COUNT(COUNTER_WORKERS_CONSUMED, 2);
+        }
+        else
+        {
+            activeNext[cell.chunk] = 1;
+        }
+    }
+
+    collectCandidates('R', activeList);
+    for (const auto &cell : candidates)
+    {
+        grow(cell, hash);
+        totals[0]++;
+        grown++;
+    }
+
+    // Plants start polluting in the first step
+    bool plantsChanged = false;
+    if (timeStep == 0)
+    {
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            if (!chunks[c])
+                continue;
+            int x0 = (c % chunksX) << CHUNK_SHIFT;
+            int y0 = (c / chunksX) << CHUNK_SHIFT;
+            for (uint16_t offset : chunks[c]->plants)
+            {
+                spreadPollution(x0 + (offset & CHUNK_MASK), y0 + (offset >> CHUNK_SHIFT), 0, PLANT_POLLUTION, hash);
+                plantsChanged = true;
+            }
+        }
+    }
+
+    active.swap(activeNext);
+    timeStep++;
+    return grown > 0 || plantsChanged;
+}
@@ -0,0 +1,113 @@
+// ChunkedGrid.h
+// Sparse region storage in 64x64 chunks with per-chunk occupancy metadata,
+// and a step engine that only visits chunks that can change.
+//
+// A chunk whose cells all share one type is stored without a type array;
+// chunks without zone cells never get a population array, and pollution
+// arrays are only allocated once pollution reaches the chunk. A chunk is
+// stepped only while it holds a pending growth candidate or a population in
+// it (or in the one-cell border around it) changed in the previous step.
+// Results are identical to Region's reference step.
+#ifndef CHUNKED_GRID_H
+#define CHUNKED_GRID_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "Cell.h"
+#include "StateHash.h"
+
+class ChunkedGrid
+{
+public:
+    static const int CHUNK_SHIFT = 6;
+    static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static const int CHUNK_MASK = CHUNK_SIZE - 1;
+    static const int POLLUTION_RADIUS = 3;
+    static const int PLANT_POLLUTION = 4;
+
+    ChunkedGrid();
+
+    // Stream a region file straight into chunks (no dense grid is built)
+    bool loadFromFile(const std::string &filename);
+
+    // Import a grid; timeStep > 0 means plant pollution is already applied
+    void loadFromGrid(const std::vector<std::vector<Cell>> &grid, int timeStep = 0);
+    void storeToGrid(std::vector<std::vector<Cell>> &grid) const;
+
+    // Advance one time step; returns true if any value changed
+    bool step(StateHash *hash = nullptr);
+
+    // Change one cell's type between steps. The cell's population is
+    // cleared, its pollution contribution is adjusted, and only the chunks
+    // whose cells can see it are woken for the next step.
+    void setType(int x, int y, char type, StateHash *hash = nullptr);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    char getType(int x, int y) const;
+    int getPopulation(int x, int y) const;
+    int getPollution(int x, int y) const;
+
+    int getTotalPopulation(char type) const;
+    long long getTotalPollution() const { return totalPollution; }
+    int getAvailableWorkers() const { return availableWorkers; }
+    int getAvailableGoods() const { return availableGoods; }
+
+    int getChunkCount() const { return chunksX * chunksY; }
+    int getAllocatedChunks() const;
+    int getActiveChunks() const;
+    size_t getMemoryBytes() const;
+
+private:
+    struct Chunk
+    {
+        std::vector<char> types;         // Empty when every cell has the chunk's fill type
+        std::vector<uint8_t> population; // Empty when the chunk has no zone cells
+        std::vector<uint16_t> pollution; // Empty until pollution reaches the chunk
+        std::vector<uint16_t> zoneCells; // Local offsets of R, C and I cells
+        std::vector<uint16_t> plants;    // Local offsets of power plants
+    };
+
+    struct Candidate
+    {
+        int x, y;
+        int population;
+        int adjacentPop;
+        int chunk;
+    };
+
+    int chunkIndex(int x, int y) const { return (y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT); }
+    static int localOffset(int x, int y) { return ((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK); }
+    static int zoneSlot(char type);
+
+    void beginLoad(int newWidth, int newHeight);
+    void setRow(int y, const std::vector<char> &row);
+    void flushBand(int chunkRow);
+    void finishLoad(int startStep);
+
+    bool isPowered(int x, int y) const;
+    int countAdjacentPopulation(int x, int y, char type, int minPop) const;
+    bool canGrow(int x, int y, char type) const;
+    void collectCandidates(char type, const std::vector<int> &activeList);
+    void grow(const Candidate &cell, StateHash *hash);
+    void markChanged(int x, int y, std::vector<uint8_t> &flags);
+    void addPollution(int x, int y, int delta, StateHash *hash);
+    void spreadPollution(int x, int y, int oldSource, int newSource, StateHash *hash);
+
+    int width, height, chunksX, chunksY;
+    std::vector<std::unique_ptr<Chunk>> chunks; // Null for uniform, untouched chunks
+    std::vector<char> fillTypes;                // Per chunk: the shared type, or 0 if mixed
+    std::vector<uint8_t> active, activeNext;
+    std::vector<char> band;                     // Rows of the chunk row being loaded
+    std::vector<Candidate> candidates;
+
+    int timeStep;
+    int totals[3]; // Residential, commercial, industrial population
+    long long totalPollution;
+    int availableWorkers, availableGoods;
+};
+
+#endif // CHUNKED_GRID_H
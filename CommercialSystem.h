@@ -1,19 +1,27 @@
-#ifndef COMMERCIAL_SYSTEM_H
-#define COMMERCIAL_SYSTEM_H
-
-#include <vector>
-#include <algorithm>
-#include "Cell.h"
-
-class CommercialSystem {
-public:
-    static void update(std::vector<std::vector<Cell>>& grid, int& availableWorkers, int& availableGoods);
-    static int getTotalPopulation(const std::vector<std::vector<Cell>>& grid);
-
-private:
-    static bool isPowered(const std::vector<std::vector<Cell>>& grid, int x, int y);
-    static int countAdjacentPopulation(const std::vector<std::vector<Cell>>& grid, int x, int y, int minPop);
-    static bool canGrow(const std::vector<std::vector<Cell>>& grid, int x, int y);
-};
-
+#ifndef COMMERCIAL_SYSTEM_H
+#define COMMERCIAL_SYSTEM_H
+
+#include <vector>
+#include <algorithm>
+#include "Cell.h"
+#include "StateHash.h"
+#include "CommuteSystem.h"
+#include "LandValue.h"
+
+class CommercialSystem {
+public:
+    // Returns the number of cells that grew; with commute, workers and
+    // goods must also be reachable over the roads, and with landValue the
+    // land value must reach its minimum
+    static int update(std::vector<std::vector<Cell>>& grid, int& availableWorkers, int& availableGoods,
+                      StateHash* hash = nullptr, CommuteSystem* commute = nullptr,
+                      const LandValue* landValue = nullptr);
+    static int getTotalPopulation(const std::vector<std::vector<Cell>>& grid);
+
+private:
+    static bool isPowered(const std::vector<std::vector<Cell>>& grid, int x, int y);
+    static int countAdjacentPopulation(const std::vector<std::vector<Cell>>& grid, int x, int y, int minPop);
+    static bool canGrow(const std::vector<std::vector<Cell>>& grid, int x, int y, const LandValue* landValue);
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,411 @@
+// CommuteSystem.cpp
+#include "CommuteSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+const int CommuteSystem::MAX_LOCAL_EDITS;
+
+CommuteSystem::CommuteSystem(int maxDistance, int threads)
+    : maxDistance(maxDistance), threads(threads > 0 ? threads : 1), stale(true), width(0), height(0),
+      distanceCapacity(0) {}
+
+int CommuteSystem::accessNodes(int cell, int nodes[8]) const
+{
+    int x = cell % width;
+    int y = cell / width;
+    int count = 0;
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        int newY = y + dy;
+        if (newY < 0 || newY >= height)
+            continue;
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int newX = x + dx;
+            if ((dx != 0 || dy != 0) && newX >= 0 && newX < width && roads.nodeAt(newX, newY) >= 0)
+                nodes[count++] = roads.nodeAt(newX, newY);
+        }
+    }
+    if (count == 0)
+        return 0;
+
+    // Keep the network of the first road cell only; usually all are in one
+    int network = roads.getNetwork(nodes[0]);
+    bool mixed = false;
+    for (int i = 1; i < count; i++)
+        mixed = mixed || roads.getNetwork(nodes[i]) != network;
+    if (!mixed)
+        return count;
+    int first = nodes[0];
+    for (int i = 1; i < count; i++)
+    {
+        if (roads.getCell(nodes[i]) < roads.getCell(first))
+            first = nodes[i];
+    }
+    network = roads.getNetwork(first);
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (roads.getNetwork(nodes[i]) == network)
+            nodes[kept++] = nodes[i];
+    }
+    return kept;
+}
+
+int CommuteSystem::networkOf(int cell) const
+{
+    int nodes[8];
+    return accessNodes(cell, nodes) > 0 ? roads.getNetwork(nodes[0]) : -1;
+}
+
+void CommuteSystem::rebuild(const std::vector<std::vector<Cell>> &grid)
+{
+    PROFILE_SCOPE("CommuteSystem::rebuild");
+    roads.build(grid);
+    height = grid.size();
+    width = height > 0 ? grid[0].size() : 0;
+
+    homes.clear();
+    factories.clear();
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            char type = grid[y][x].getType();
+            if (type != 'R' && type != 'I')
+                continue;
+            int cell = y * width + x;
+            int network = networkOf(cell);
+            if (network >= 0)
+                (type == 'R' ? homes : factories).push_back({cell, network, false});
+        }
+    }
+
+    int nodes = roads.getNodeCount();
+    workerDistance.reset(new std::atomic<int>[nodes]);
+    goodsDistance.reset(new std::atomic<int>[nodes]);
+    distanceCapacity = nodes;
+    for (int node = 0; node < nodes; node++)
+    {
+        workerDistance[node].store(RoadNetwork::UNREACHED, std::memory_order_relaxed);
+        goodsDistance[node].store(RoadNetwork::UNREACHED, std::memory_order_relaxed);
+    }
+    workers.assign(roads.getNetworkCount(), 0);
+    goods.assign(roads.getNetworkCount(), 0);
+    pendingEdits.clear();
+    stale = false;
+}
+
+// Make room for nodes distances in each field; new nodes start unreached
+void CommuteSystem::growDistances(int nodes)
+{
+    if (nodes <= distanceCapacity)
+        return;
+    int capacity = std::max(nodes, 2 * distanceCapacity);
+    for (std::unique_ptr<std::atomic<int>[]> *field : {&workerDistance, &goodsDistance})
+    {
+        std::unique_ptr<std::atomic<int>[]> grown(new std::atomic<int>[capacity]);
+        for (int node = 0; node < capacity; node++)
+        {
+            int value = node < distanceCapacity ? (*field)[node].load(std::memory_order_relaxed) : RoadNetwork::UNREACHED;
+            grown[node].store(value, std::memory_order_relaxed);
+        }
+        field->swap(grown);
+    }
+    distanceCapacity = capacity;
+}
+
+void CommuteSystem::cellChanged(int x, int y)
+{
+    if (stale)
+        return;
+    if (pendingEdits.size() >= static_cast<size_t>(MAX_LOCAL_EDITS))
+    {
+        stale = true;
+        pendingEdits.clear();
+        return;
+    }
+    pendingEdits.push_back(y * width + x);
+}
+
+// Take cell out of the zone lists and put it back if it is still a
+// residential or industrial cell with road access
+void CommuteSystem::refreshZone(int cell, char type)
+{
+    for (std::vector<Zone> *zones : {&homes, &factories})
+    {
+        auto zone = std::lower_bound(zones->begin(), zones->end(), cell, beforeCell);
+        if (zone != zones->end() && zone->cell == cell)
+            zones->erase(zone);
+    }
+    int network = type == 'R' || type == 'I' ? networkOf(cell) : -1;
+    if (network < 0)
+        return;
+    std::vector<Zone> &zones = type == 'R' ? homes : factories;
+    zones.insert(std::lower_bound(zones.begin(), zones.end(), cell, beforeCell), {cell, network, false});
+}
+
+bool CommuteSystem::applyEdits(const std::vector<std::vector<Cell>> &grid)
+{
+    PROFILE_SCOPE("CommuteSystem::applyEdits");
+
+    // Distances can change within maxDistance of the roads an edit touched
+    std::vector<int> seeds;
+    std::vector<int> zoneCells;
+    for (int cell : pendingEdits)
+    {
+        int x = cell % width;
+        int y = cell / width;
+        bool road = RoadNetwork::isRoad(grid[y][x].getType());
+        int node = roads.nodeAt(x, y);
+        bool roadEdit = road != (node >= 0);
+        if (road && node < 0)
+        {
+            node = roads.addNode(x, y);
+            if (node < 0)
+                return false;
+            growDistances(roads.getNodeCount());
+            seeds.push_back(node);
+        }
+        else if (!road && node >= 0)
+        {
+            const int *links = roads.linksOf(node);
+            int around[RoadNetwork::LINKS];
+            std::copy(links, links + RoadNetwork::LINKS, around);
+            if (!roads.removeNode(x, y))
+                return false;
+            workerDistance[node].store(RoadNetwork::UNREACHED, std::memory_order_relaxed);
+            goodsDistance[node].store(RoadNetwork::UNREACHED, std::memory_order_relaxed);
+            for (int k = 0; k < RoadNetwork::LINKS; k++)
+            {
+                if (around[k] >= 0)
+                    seeds.push_back(around[k]);
+            }
+        }
+
+        // Road edits change the access of the zones around them
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int newX = x + dx;
+                int newY = y + dy;
+                if ((roadEdit || (dx == 0 && dy == 0)) && newX >= 0 && newX < width && newY >= 0 && newY < height)
+                    zoneCells.push_back(newY * width + newX);
+            }
+        }
+    }
+    pendingEdits.clear();
+    workers.resize(roads.getNetworkCount(), 0);
+    goods.resize(roads.getNetworkCount(), 0);
+
+    std::sort(zoneCells.begin(), zoneCells.end());
+    zoneCells.erase(std::unique(zoneCells.begin(), zoneCells.end()), zoneCells.end());
+    for (int cell : zoneCells)
+    {
+        refreshZone(cell, grid[cell / width][cell % width].getType());
+
+        // The zone's old and new access nodes are all among the roads around it
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int newX = cell % width + dx;
+                int newY = cell / width + dy;
+                if (newX >= 0 && newX < width && newY >= 0 && newY < height && roads.nodeAt(newX, newY) >= 0)
+                    seeds.push_back(roads.nodeAt(newX, newY));
+            }
+        }
+    }
+
+    std::vector<char> inRegion(roads.getNodeCount(), 0);
+    std::vector<int> region;
+    for (int node : seeds)
+    {
+        if (!inRegion[node])
+        {
+            inRegion[node] = 1;
+            region.push_back(node);
+        }
+    }
+    size_t levelEnd = region.size();
+    for (size_t i = 0, level = 0; i < region.size(); i++)
+    {
+        if (i == levelEnd)
+        {
+            level++;
+            levelEnd = region.size();
+        }
+        if (level >= static_cast<size_t>(maxDistance))
+            break;
+        const int *links = roads.linksOf(region[i]);
+        for (int k = 0; k < RoadNetwork::LINKS; k++)
+        {
+            if (links[k] >= 0 && !inRegion[links[k]])
+            {
+                inRegion[links[k]] = 1;
+                region.push_back(links[k]);
+            }
+        }
+    }
+
+    repair(region, inRegion, homes, workerDistance.get());
+    repair(region, inRegion, factories, goodsDistance.get());
+    return true;
+}
+
+void CommuteSystem::repair(const std::vector<int> &region, const std::vector<char> &inRegion,
+                           const std::vector<Zone> &zones, std::atomic<int> *distance)
+{
+    for (int node : region)
+        distance[node].store(RoadNetwork::UNREACHED, std::memory_order_relaxed);
+
+    // Sources start at 0; nodes just outside keep their distances and
+    // join the search at them
+    std::vector<std::pair<int, int>> boundary;
+    frontier.clear();
+    for (int node : region)
+    {
+        int cell = roads.getCell(node);
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int x = cell % width + dx;
+                int y = cell / width + dy;
+                if (x < 0 || x >= width || y < 0 || y >= height)
+                    continue;
+                auto zone = std::lower_bound(zones.begin(), zones.end(), y * width + x, beforeCell);
+                if (zone == zones.end() || zone->cell != y * width + x || !zone->isSource)
+                    continue;
+                int nodes[8];
+                int count = accessNodes(zone->cell, nodes);
+                if (std::find(nodes, nodes + count, node) != nodes + count &&
+                    distance[node].load(std::memory_order_relaxed) != 0)
+                {
+                    distance[node].store(0, std::memory_order_relaxed);
+                    frontier.push_back(node);
+                }
+            }
+        }
+        const int *links = roads.linksOf(node);
+        for (int k = 0; k < RoadNetwork::LINKS; k++)
+        {
+            int outside = links[k] >= 0 && !inRegion[links[k]] ? distance[links[k]].load(std::memory_order_relaxed)
+                                                               : RoadNetwork::UNREACHED;
+            if (outside < maxDistance)
+                boundary.push_back({outside, links[k]});
+        }
+    }
+    std::sort(boundary.begin(), boundary.end());
+
+    std::vector<int> next;
+    size_t joined = 0;
+    for (int level = 0; level < maxDistance && (!frontier.empty() || joined < boundary.size()); level++)
+    {
+        for (; joined < boundary.size() && boundary[joined].first == level; joined++)
+            frontier.push_back(boundary[joined].second);
+        next.clear();
+        for (int node : frontier)
+        {
+            const int *links = roads.linksOf(node);
+            for (int k = 0; k < RoadNetwork::LINKS; k++)
+            {
+                int n = links[k];
+                if (n >= 0 && inRegion[n] && distance[n].load(std::memory_order_relaxed) > level + 1)
+                {
+                    distance[n].store(level + 1, std::memory_order_relaxed);
+                    next.push_back(n);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+}
+
+// Pool the population of zones per network and search outwards from those
+// that became populated since the last step
+void CommuteSystem::addSources(std::vector<Zone> &zones, const std::vector<std::vector<Cell>> &grid,
+                               std::vector<int> &pool, std::atomic<int> *distance)
+{
+    std::fill(pool.begin(), pool.end(), 0);
+    frontier.clear();
+    for (Zone &zone : zones)
+    {
+        int population = grid[zone.cell / width][zone.cell % width].getPopulation();
+        pool[zone.network] += population;
+        if (population == 0 || zone.isSource)
+            continue;
+
+        zone.isSource = true;
+        int nodes[8];
+        int count = accessNodes(zone.cell, nodes);
+        for (int i = 0; i < count; i++)
+        {
+            if (distance[nodes[i]].load(std::memory_order_relaxed) != 0)
+            {
+                distance[nodes[i]].store(0, std::memory_order_relaxed);
+                frontier.push_back(nodes[i]);
+            }
+        }
+    }
+    roads.expand(frontier, 0, maxDistance, distance, threads);
+}
+
+void CommuteSystem::beginStep(const std::vector<std::vector<Cell>> &grid)
+{
+    if (!stale && !pendingEdits.empty() && !applyEdits(grid))
+        stale = true;
+    if (stale)
+        rebuild(grid);
+
+    PROFILE_SCOPE("CommuteSystem::beginStep");
+    addSources(homes, grid, workers, workerDistance.get());
+    addSources(factories, grid, goods, goodsDistance.get());
+}
+
+int CommuteSystem::nearest(int x, int y, const std::atomic<int> *distance) const
+{
+    int nodes[8];
+    int count = stale ? 0 : accessNodes(y * width + x, nodes);
+    int best = RoadNetwork::UNREACHED;
+    for (int i = 0; i < count; i++)
+        best = std::min(best, distance[nodes[i]].load(std::memory_order_relaxed));
+    return best;
+}
+
+bool CommuteSystem::tryStaff(int x, int y, char type)
+{
+    int network = networkOf(y * width + x);
+    if (network < 0)
+        return false;
+
+    if (type == 'C')
+    {
+        if (workers[network] < 1 || goods[network] < 1 || getWorkerDistance(x, y) > maxDistance ||
+            getGoodsDistance(x, y) > maxDistance)
+            return false;
+        workers[network]--;
+        goods[network]--;
+        return true;
+    }
+
+    // Industrial: two workers per level, and the new goods stay in this network
+    if (workers[network] < 2 || getWorkerDistance(x, y) > maxDistance)
+        return false;
+    workers[network] -= 2;
+    goods[network]++;
+    return true;
+}
+
+int CommuteSystem::getNetworkWorkers(int x, int y) const
+{
+    int network = stale ? -1 : networkOf(y * width + x);
+    return network < 0 ? 0 : workers[network];
+}
+
+int CommuteSystem::getNetworkGoods(int x, int y) const
+{
+    int network = stale ? -1 : networkOf(y * width + x);
+    return network < 0 ? 0 : goods[network];
+}
@@ -0,0 +1,115 @@
+// CommuteSystem.h
+// Limits who can staff a job to the road network. A zone cell reaches the
+// roads through the road cells around it and belongs to the network of
+// the one that comes first in row-major order. Workers and goods are pooled per network, and a
+// commercial or industrial cell only grows when a populated residential
+// cell (and, for commercial, a populated industrial cell) is within the
+// commute distance over the roads. Cells without road access get no
+// workers or goods; residential growth is not affected.
+//
+// The distance fields are kept between steps: populations only grow, so a
+// step only adds sources and a breadth-first search from the new ones
+// updates the distances. An edit to a road or zone patches the graph and
+// recomputes the distances within the commute distance of it; edits that
+// join or split road networks rebuild everything.
+#ifndef COMMUTE_SYSTEM_H
+#define COMMUTE_SYSTEM_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "Cell.h"
+#include "RoadNetwork.h"
+
+class CommuteSystem
+{
+public:
+    // More pending edits than this rebuild everything instead
+    static const int MAX_LOCAL_EDITS = 64;
+
+    CommuteSystem(int maxDistance, int threads = 1);
+
+    int getMaxDistance() const { return maxDistance; }
+
+    // Rebuild the graph and distance fields at the next step
+    void invalidate() { stale = true; }
+
+    // Whether edits to or from this cell type require cellChanged()
+    static bool affectedBy(char type)
+    {
+        return RoadNetwork::isRoad(type) || type == 'R' || type == 'I' || type == 'C';
+    }
+
+    // The type of the cell at (x, y) changed to or from a road or zone type
+    void cellChanged(int x, int y);
+
+    // Start of a step: pool the resources of each network and bring the
+    // distance fields up to date with the grid
+    void beginStep(const std::vector<std::vector<Cell>> &grid);
+
+    // Take the workers (and goods) for one level of growth of the job cell
+    // at (x, y) from its network; false if it cannot be staffed
+    bool tryStaff(int x, int y, char type);
+
+    const RoadNetwork &getRoads() const { return roads; }
+
+    // Road distance from (x, y) to the nearest populated residential or
+    // industrial cell as of the last beginStep; UNREACHED beyond the limit
+    int getWorkerDistance(int x, int y) const { return nearest(x, y, workerDistance.get()); }
+    int getGoodsDistance(int x, int y) const { return nearest(x, y, goodsDistance.get()); }
+
+    // Resources left in the network of (x, y); 0 without road access
+    int getNetworkWorkers(int x, int y) const;
+    int getNetworkGoods(int x, int y) const;
+
+private:
+    // A residential or industrial cell with road access
+    struct Zone
+    {
+        int cell;      // Row-major index
+        int network;
+        bool isSource; // Populated, so its road cells are at distance 0
+    };
+
+    // Zones are kept in row-major order
+    static bool beforeCell(const Zone &zone, int cell) { return zone.cell < cell; }
+
+    // Road nodes around cell that are in the cell's network; returns how many
+    int accessNodes(int cell, int nodes[8]) const;
+    int networkOf(int cell) const;
+    void rebuild(const std::vector<std::vector<Cell>> &grid);
+    void growDistances(int nodes);
+
+    // Patch the graph and zones for the pending edits and recompute the
+    // distances around them; false if an edit joins or splits networks
+    bool applyEdits(const std::vector<std::vector<Cell>> &grid);
+    void refreshZone(int cell, char type);
+
+    // Recompute distance for the nodes of region from the sources among
+    // zones and the unchanged distances around the region
+    void repair(const std::vector<int> &region, const std::vector<char> &inRegion, const std::vector<Zone> &zones,
+                std::atomic<int> *distance);
+    void addSources(std::vector<Zone> &zones, const std::vector<std::vector<Cell>> &grid,
+                    std::vector<int> &pool, std::atomic<int> *distance);
+    int nearest(int x, int y, const std::atomic<int> *distance) const;
+
+    int maxDistance;
+    int threads;
+    bool stale;
+    int width, height;
+    std::vector<int> pendingEdits; // Row-major cell indices
+
+    RoadNetwork roads;
+    std::vector<Zone> homes;
+    std::vector<Zone> factories;
+
+    std::unique_ptr<std::atomic<int>[]> workerDistance; // Per node
+    std::unique_ptr<std::atomic<int>[]> goodsDistance;
+    int distanceCapacity;
+    std::vector<int> workers; // Per network
+    std::vector<int> goods;
+    std::vector<int> frontier;
+};
+
+#endif // COMMUTE_SYSTEM_H
@@ -0,0 +1,52 @@
+// CounterRng.h
+// Philox4x32-10 counter-based random numbers (Salmon et al., "Parallel
+// random numbers: as easy as 1, 2, 3"). Each value is a pure function of a
+// key and a counter, so draws need no generator state: the same (seed,
+// step, x, y) gives the same number on any thread, in any order and with
+// any split of the region into tiles.
+#ifndef COUNTER_RNG_H
+#define COUNTER_RNG_H
+
+#include <cstdint>
+
+class CounterRng
+{
+public:
+    // Encrypt counter in place with key
+    static void philox(uint32_t counter[4], const uint32_t key[2])
+    {
+        const uint32_t MULTIPLIER_0 = 0xD2511F53u;
+        const uint32_t MULTIPLIER_1 = 0xCD9E8D57u;
+        const uint32_t WEYL_0 = 0x9E3779B9u;
+        const uint32_t WEYL_1 = 0xBB67AE85u;
+
+        uint32_t key0 = key[0];
+        uint32_t key1 = key[1];
+        for (int round = 0; round < 10; round++)
+        {
+            uint64_t product0 = static_cast<uint64_t>(MULTIPLIER_0) * counter[0];
+            uint64_t product1 = static_cast<uint64_t>(MULTIPLIER_1) * counter[2];
+            uint32_t next0 = static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0;
+            uint32_t next2 = static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1;
+            counter[0] = next0;
+            counter[1] = static_cast<uint32_t>(product1);
+            counter[2] = next2;
+            counter[3] = static_cast<uint32_t>(product0);
+            key0 += WEYL_0;
+            key1 += WEYL_1;
+        }
+    }
+
+    // Uniform double in [0, 1) for one cell of one step of one run
+    static double uniform(uint64_t seed, uint32_t step, uint32_t x, uint32_t y)
+    {
+        uint32_t counter[4] = {x, y, step, 0};
+        const uint32_t key[2] = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+        philox(counter, key);
+        // 53 random bits, the full precision of a double
+        uint64_t bits = (static_cast<uint64_t>(counter[0]) << 21) ^ (counter[1] >> 11);
+        return static_cast<double>(bits) * (1.0 / 9007199254740992.0);
+    }
+};
+
+#endif // COUNTER_RNG_H
@@ -0,0 +1,82 @@
+// CowPlane.h
+// A width x height plane of small integers stored as 64x64 tiles. Every tile
+// starts out pointing at one shared all-zero tile and is copied the first
+// time a non-zero value is written to it, so untouched areas cost nothing.
+#ifndef COW_PLANE_H
+#define COW_PLANE_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+template <typename T>
+class CowPlane
+{
+public:
+    static const int TILE_SHIFT = 6;
+    static const int TILE_SIZE = 1 << TILE_SHIFT;
+    static const int TILE_MASK = TILE_SIZE - 1;
+
+    CowPlane() : width(0), height(0), tilesX(0) {}
+
+    CowPlane(int width, int height)
+        : width(width), height(height), tilesX((width + TILE_MASK) >> TILE_SHIFT)
+    {
+        int tilesY = (height + TILE_MASK) >> TILE_SHIFT;
+        tiles.assign(static_cast<size_t>(tilesX) * tilesY, zeroTile());
+    }
+
+    T get(int index) const
+    {
+        int x = index % width;
+        int y = index / width;
+        return (*tiles[tileOf(x, y)])[offsetOf(x, y)];
+    }
+
+    void set(int index, T value)
+    {
+        int x = index % width;
+        int y = index / width;
+        std::shared_ptr<std::vector<T>> &tile = tiles[tileOf(x, y)];
+        T &slot = (*tile)[offsetOf(x, y)];
+        if (slot == value)
+            return;
+
+        // Another plane (or the zero tile pool) still sees this tile
+        if (tile.use_count() > 1)
+        {
+            tile = std::make_shared<std::vector<T>>(*tile);
+            (*tile)[offsetOf(x, y)] = value;
+            return;
+        }
+        slot = value;
+    }
+
+    // Bytes owned by this plane (shared tiles are not counted)
+    size_t getOwnedBytes() const
+    {
+        size_t bytes = tiles.capacity() * sizeof(tiles[0]);
+        for (const auto &tile : tiles)
+        {
+            if (tile.use_count() == 1)
+                bytes += TILE_SIZE * TILE_SIZE * sizeof(T);
+        }
+        return bytes;
+    }
+
+private:
+    static const std::shared_ptr<std::vector<T>> &zeroTile()
+    {
+        static const std::shared_ptr<std::vector<T>> zero =
+            std::make_shared<std::vector<T>>(TILE_SIZE * TILE_SIZE, T());
+        return zero;
+    }
+
+    size_t tileOf(int x, int y) const { return static_cast<size_t>(y >> TILE_SHIFT) * tilesX + (x >> TILE_SHIFT); }
+    int offsetOf(int x, int y) const { return ((y & TILE_MASK) << TILE_SHIFT) | (x & TILE_MASK); }
+
+    int width, height, tilesX;
+    std::vector<std::shared_ptr<std::vector<T>>> tiles;
+};
+
+#endif // COW_PLANE_H
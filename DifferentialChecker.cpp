@@ -0,0 +1,503 @@
+// DifferentialChecker.cpp
+#include "DifferentialChecker.h"
+#include "Simulation.h"
+#include "Layout.h"
+#include "StepKernel.h"
+#include "SweepRunner.h"
+#include "TileStore.h"
+#include "TiledSimulation.h"
+#include "BatchSimulation.h"
+#include "CounterRng.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+
+// The sparse, adaptive and fixed-size engines, through Simulation like every other caller
+class SimulationEngine : public CheckedEngine
+{
+public:
+    SimulationEngine(StepEngine engine, const CheckOptions &options) : engine(engine), options(options) {}
+
+    bool load(const LayoutRows &, const std::string &regionText, std::string &error) override
+    {
+        std::istringstream in(regionText);
+        if (!simulation.load(in, error))
+            return false;
+        simulation.setEngine(engine);
+        simulation.setPollutionDeferred(options.deferPollution);
+        if (options.commuteDistance > 0)
+            simulation.setCommuteDistance(options.commuteDistance);
+        if (options.landValue)
+            simulation.enableLandValue(options.minimumLandValue);
+        return true;
+    }
+
+    void step() override { simulation.step(); }
+
+    bool edit(int x, int y, char type) override { return simulation.setCellType(x, y, type); }
+
+    void read(std::vector<Cell> &cells) override
+    {
+        // Deferred pollution is compared once caught up
+        if (simulation.isPollutionPending())
+            simulation.catchUpPollution();
+        cells.clear();
+        for (const std::vector<Cell> &row : simulation.getGrid())
+            cells.insert(cells.end(), row.begin(), row.end());
+    }
+
+private:
+    StepEngine engine;
+    CheckOptions options;
+    Simulation simulation;
+};
+
+// StepKernel over a shared Layout, as used by sweeps and Monte Carlo runs
+class KernelEngine : public CheckedEngine
+{
+public:
+    bool load(const LayoutRows &rows, const std::string &, std::string &) override
+    {
+        std::vector<std::vector<Cell>> grid(rows.size(), std::vector<Cell>(rows[0].size()));
+        for (size_t y = 0; y < rows.size(); y++)
+        {
+            for (size_t x = 0; x < rows[y].size(); x++)
+                grid[y][x].setType(rows[y][x]);
+        }
+        layout = Layout::fromGrid(grid);
+        state.reset(new VariantState(layout->getWidth(), layout->getHeight()));
+        timeStep = 0;
+        return true;
+    }
+
+    void step() override { StepKernel<VariantState>::step(*layout, *state, rules, timeStep++, scratch); }
+
+    void read(std::vector<Cell> &cells) override
+    {
+        cells.resize(layout->getCellCount());
+        for (int index = 0; index < layout->getCellCount(); index++)
+        {
+            cells[index].setType(layout->getType(index));
+            cells[index].setPopulation(state->getPopulation(index));
+            cells[index].setPollution(state->getPollution(index));
+        }
+    }
+
+private:
+    std::shared_ptr<const Layout> layout;
+    std::unique_ptr<VariantState> state;
+    RuleParams rules;
+    StepScratch scratch;
+    int timeStep = 0;
+};
+
+// TiledSimulation over a scratch tile file, with tiles small enough that
+// even small regions span several of them
+class TiledEngine : public CheckedEngine
+{
+public:
+    static const int TILE_SIZE = 16;
+
+    explicit TiledEngine(const std::string &workDir) : filename(workDir + "/diffcheck.tiles") {}
+
+    ~TiledEngine() override
+    {
+        simulation.reset();
+        store.close();
+        std::remove(filename.c_str());
+    }
+
+    bool load(const LayoutRows &rows, const std::string &, std::string &error) override
+    {
+        simulation.reset();
+        store.close();
+        width = static_cast<int>(rows[0].size());
+        height = static_cast<int>(rows.size());
+        TileWriter writer(filename, width, height, TILE_SIZE);
+        if (!writer.isOpen())
+        {
+            error = "Cannot write tile file " + filename;
+            return false;
+        }
+        std::vector<char> types;
+        for (const std::string &row : rows)
+        {
+            types.assign(row.begin(), row.end());
+            writer.writeRow(types);
+        }
+        if (!writer.finish() || !store.open(filename, 1u << 20))
+        {
+            error = "Cannot prepare tile file " + filename;
+            return false;
+        }
+        simulation.reset(new TiledSimulation(store));
+        return true;
+    }
+
+    void step() override { simulation->step(); }
+
+    void read(std::vector<Cell> &cells) override
+    {
+        std::vector<char> types(width);
+        std::vector<uint8_t> population(width);
+        std::vector<uint16_t> pollution(width);
+        cells.resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; y++)
+        {
+            store.readTypes(y, types.data());
+            store.readPopulation(y, population.data());
+            store.readPollution(y, pollution.data());
+            for (int x = 0; x < width; x++)
+            {
+                Cell &cell = cells[static_cast<size_t>(y) * width + x];
+                cell.setType(types[x]);
+                cell.setPopulation(population[x]);
+                cell.setPollution(pollution[x]);
+            }
+        }
+    }
+
+private:
+    std::string filename;
+    TileStore store;
+    std::unique_ptr<TiledSimulation> simulation;
+    int width = 0, height = 0;
+};
+
+// BatchSimulation with the region as its only member, padded to a tile
+// like any region of a batch
+class BatchEngine : public CheckedEngine
+{
+public:
+    bool load(const LayoutRows &rows, const std::string &, std::string &) override
+    {
+        std::vector<std::vector<Cell>> grid(rows.size(), std::vector<Cell>(rows[0].size()));
+        for (size_t y = 0; y < rows.size(); y++)
+        {
+            for (size_t x = 0; x < rows[y].size(); x++)
+                grid[y][x].setType(rows[y][x]);
+        }
+        batch.load({Layout::fromGrid(grid)});
+        return true;
+    }
+
+    void step() override { batch.step(); }
+
+    void read(std::vector<Cell> &cells) override { batch.readCells(0, cells); }
+
+private:
+    BatchSimulation batch;
+};
+
+static bool sameCell(const Cell &a, const Cell &b)
+{
+    return a.getType() == b.getType() && a.getPopulation() == b.getPopulation() &&
+           a.getPollution() == b.getPollution();
+}
+
+static bool isBlank(const LayoutRows &rows)
+{
+    for (const std::string &row : rows)
+    {
+        if (row.find_first_not_of('-') != std::string::npos)
+            return false;
+    }
+    return true;
+}
+
+const std::vector<std::string> &DifferentialChecker::engineNames()
+{
+    static const std::vector<std::string> names = {"sparse", "adaptive", "kernel", "tiled", "fixed", "batch"};
+    return names;
+}
+
+bool DifferentialChecker::isKnownEngine(const std::string &name)
+{
+    const std::vector<std::string> &names = engineNames();
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool DifferentialChecker::supports(const std::string &engine, int width, int height)
+{
+    return engine != "fixed" || FixedGridEngine::isSupported(width, height);
+}
+
+bool DifferentialChecker::supports(const std::string &engine, const CheckOptions &options)
+{
+    return options.isPlain() || engine == "sparse" || engine == "adaptive" || engine == "fixed";
+}
+
+DifferentialChecker::DifferentialChecker(const std::string &engine, const std::string &workDir,
+                                         const CheckOptions &options)
+    : engine(engine), workDir(workDir), options(options), comparisons(0)
+{
+}
+
+std::unique_ptr<CheckedEngine> DifferentialChecker::createEngine() const
+{
+    if (engine == "sparse")
+        return std::unique_ptr<CheckedEngine>(new SimulationEngine(ENGINE_SPARSE, options));
+    if (engine == "adaptive")
+        return std::unique_ptr<CheckedEngine>(new SimulationEngine(ENGINE_ADAPTIVE, options));
+    if (engine == "kernel")
+        return std::unique_ptr<CheckedEngine>(new KernelEngine());
+    if (engine == "tiled")
+        return std::unique_ptr<CheckedEngine>(new TiledEngine(workDir));
+    if (engine == "fixed")
+        return std::unique_ptr<CheckedEngine>(new SimulationEngine(ENGINE_REFERENCE, options));
+    if (engine == "batch")
+        return std::unique_ptr<CheckedEngine>(new BatchEngine());
+    return nullptr;
+}
+
+bool DifferentialChecker::compare(const LayoutRows &rows, int maxSteps, Divergence &divergence, std::string &error)
+{
+    divergence = Divergence();
+    comparisons++;
+
+    std::string regionText = toRegionText(rows);
+    std::unique_ptr<CheckedEngine> checked = createEngine();
+    if (!checked)
+    {
+        error = "Unknown engine " + engine;
+        return false;
+    }
+    Simulation reference;
+    std::istringstream in(regionText);
+    if (!reference.load(in, error) || !checked->load(rows, regionText, error))
+        return false;
+    reference.setEngine(ENGINE_REFERENCE);
+    reference.setFixedSizeDispatch(false);
+    if (options.commuteDistance > 0)
+        reference.setCommuteDistance(options.commuteDistance);
+    if (options.landValue)
+        reference.enableLandValue(options.minimumLandValue);
+
+    int width = reference.getWidth();
+    int height = reference.getHeight();
+    std::vector<Cell> expected, actual;
+    for (int step = 0; step <= maxSteps; step++)
+    {
+        if (step > 0 && options.editsPerStep > 0)
+        {
+            static const char types[] = {'-', 'R', 'I', 'C', 'T', '#', 'P'};
+            for (int edit = 0; edit < options.editsPerStep; edit++)
+            {
+                auto draw = [&](int field, int count)
+                {
+                    return static_cast<int>(CounterRng::uniform(options.editSeed, step, edit, field) * count);
+                };
+                int x = draw(0, width), y = draw(1, height);
+                char type = types[draw(2, sizeof(types))];
+                reference.setCellType(x, y, type);
+                if (!checked->edit(x, y, type))
+                {
+                    error = engine + " cannot edit cells";
+                    return false;
+                }
+            }
+
+            // The reference rebuilds its road graph and land values from
+            // scratch, so local patches are checked against a full rebuild
+            if (options.commuteDistance > 0)
+                reference.setCommuteDistance(options.commuteDistance);
+            if (options.landValue)
+                reference.enableLandValue(options.minimumLandValue);
+        }
+        if (step > 0)
+        {
+            reference.step();
+            checked->step();
+        }
+
+        expected.clear();
+        for (const std::vector<Cell> &row : reference.getGrid())
+            expected.insert(expected.end(), row.begin(), row.end());
+        checked->read(actual);
+        for (size_t index = 0; index < expected.size(); index++)
+        {
+            if (!sameCell(expected[index], actual[index]))
+            {
+                divergence.found = true;
+                divergence.step = step;
+                divergence.x = static_cast<int>(index % width);
+                divergence.y = static_cast<int>(index / width);
+                divergence.expected = expected[index];
+                divergence.actual = actual[index];
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+bool DifferentialChecker::diverges(const LayoutRows &rows, int maxSteps, Divergence &divergence)
+{
+    std::string error;
+    return !rows.empty() && !rows[0].empty() && compare(rows, maxSteps, divergence, error) && divergence.found;
+}
+
+// Keep candidate if the engines still differ on it by the same step or earlier
+bool DifferentialChecker::tryCandidate(LayoutRows &rows, const LayoutRows &candidate, Divergence &divergence)
+{
+    Divergence result;
+    if (!diverges(candidate, divergence.step, result))
+        return false;
+    rows = candidate;
+    divergence = result;
+    return true;
+}
+
+LayoutRows DifferentialChecker::minimize(const LayoutRows &original, Divergence &divergence)
+{
+    LayoutRows rows = original;
+    if (!divergence.found)
+        return rows;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // Crop from each edge and each corner, in halving chunks; corners
+        // keep a square region square
+        bool cropped = true;
+        while (cropped)
+        {
+            cropped = false;
+            int height = static_cast<int>(rows.size());
+            int width = static_cast<int>(rows[0].size());
+            for (int chunk = std::max(width, height) / 2; chunk >= 1 && !cropped; chunk /= 2)
+            {
+                // Rows and columns to drop: top, bottom, left, right
+                const int cuts[8][4] = {{chunk, 0, 0, 0}, {0, chunk, 0, 0}, {0, 0, chunk, 0}, {0, 0, 0, chunk},
+                                        {chunk, 0, chunk, 0}, {chunk, 0, 0, chunk}, {0, chunk, chunk, 0},
+                                        {0, chunk, 0, chunk}};
+                for (int cut = 0; cut < 8 && !cropped; cut++)
+                {
+                    int top = cuts[cut][0], bottom = cuts[cut][1], left = cuts[cut][2], right = cuts[cut][3];
+                    if (top + bottom >= height || left + right >= width)
+                        continue;
+                    LayoutRows candidate(rows.begin() + top, rows.end() - bottom);
+                    for (std::string &row : candidate)
+                        row = row.substr(left, width - left - right);
+                    cropped = tryCandidate(rows, candidate, divergence);
+                }
+            }
+        }
+
+        // Clear square blocks of cells, then smaller ones down to single cells
+        int height = static_cast<int>(rows.size());
+        int width = static_cast<int>(rows[0].size());
+        int block = 1;
+        while (block * 2 <= std::max(width, height))
+            block *= 2;
+        for (; block >= 1; block /= 2)
+        {
+            for (int top = 0; top < height; top += block)
+            {
+                for (int left = 0; left < width; left += block)
+                {
+                    LayoutRows candidate = rows;
+                    bool cleared = false;
+                    for (int y = top; y < std::min(top + block, height); y++)
+                    {
+                        for (int x = left; x < std::min(left + block, width); x++)
+                        {
+                            cleared = cleared || candidate[y][x] != '-';
+                            candidate[y][x] = '-';
+                        }
+                    }
+                    if (cleared && !isBlank(candidate))
+                        tryCandidate(rows, candidate, divergence);
+                }
+            }
+        }
+    }
+    return rows;
+}
+
+GeneratorParams DifferentialChecker::randomParams(uint64_t seed, int region, int minSize, int maxSize, bool square)
+{
+    // One draw per setting, keyed like growth draws so runs are repeatable anywhere
+    int draw = 0;
+    auto uniform = [&]() { return CounterRng::uniform(seed, region, draw++, 0); };
+    auto between = [&](int low, int high) { return low + static_cast<int>(uniform() * (high - low + 1)); };
+
+    GeneratorParams params;
+    params.width = between(minSize, maxSize);
+    params.height = between(minSize, maxSize);
+    if (square)
+        params.height = params.width;
+    params.seed = seed * 1000003u + static_cast<uint64_t>(region);
+    params.density = 0.3 + 0.7 * uniform();
+    params.residentialWeight = between(0, 100);
+    params.commercialWeight = between(0, 100);
+    params.industrialWeight = between(1, 100);
+    params.roadSpacing = uniform() < 0.2 ? 0 : between(2, 12);
+    params.powerSpacing = uniform() < 0.2 ? 0 : between(2, 16);
+    params.plants = between(0, 4);
+    params.clustering = uniform();
+    params.clusterSize = between(1, 16);
+    return params;
+}
+
+LayoutRows DifferentialChecker::generate(const GeneratorParams &params)
+{
+    RegionGenerator generator(params);
+    LayoutRows rows(params.height);
+    std::vector<char> row;
+    for (int y = 0; y < params.height; y++)
+    {
+        generator.generateRow(y, row);
+        rows[y].assign(row.begin(), row.end());
+    }
+    return rows;
+}
+
+std::string DifferentialChecker::toRegionText(const LayoutRows &rows)
+{
+    std::string text = std::to_string(rows.size()) + "," + std::to_string(rows.empty() ? 0 : rows[0].size()) + "\n";
+    for (const std::string &row : rows)
+    {
+        for (size_t x = 0; x < row.size(); x++)
+        {
+            if (x > 0)
+                text += ',';
+            text += row[x];
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+bool DifferentialChecker::readLayout(const std::string &filename, LayoutRows &rows)
+{
+    Simulation simulation;
+    std::string error;
+    if (!simulation.load(filename, error))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+    rows.clear();
+    for (const std::vector<Cell> &gridRow : simulation.getGrid())
+    {
+        std::string row;
+        for (const Cell &cell : gridRow)
+            row += cell.getType();
+        rows.push_back(row);
+    }
+    return true;
+}
+
+bool DifferentialChecker::writeLayout(const std::string &filename, const LayoutRows &rows)
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot write region file: " << filename << std::endl;
+        return false;
+    }
+    file << toRegionText(rows);
+    return static_cast<bool>(file);
+}
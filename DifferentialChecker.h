@@ -0,0 +1,116 @@
+// DifferentialChecker.h
+// Cross-checks the optimized step engines against the reference engine.
+// Both are loaded with the same layout and stepped in lockstep, and every
+// cell's type, population and pollution is compared after every step. The
+// first difference is reported by step and cell, and the layout can then be
+// shrunk to a small region that still shows it. CheckOptions add random
+// edits between steps and the optional rules, which exercise the engines'
+// incremental paths.
+#ifndef DIFFERENTIAL_CHECKER_H
+#define DIFFERENTIAL_CHECKER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "Cell.h"
+#include "RegionGenerator.h"
+
+// A layout as one string of cell types per row
+typedef std::vector<std::string> LayoutRows;
+
+// First difference between the reference and a checked engine
+struct Divergence
+{
+    bool found = false;
+    int step = 0; // Steps taken when the states first differed
+    int x = 0, y = 0;
+    Cell expected; // Reference engine's cell
+    Cell actual;   // Checked engine's cell
+};
+
+// Conditions both engines run under; the defaults check plain stepping
+struct CheckOptions
+{
+    int editsPerStep = 0;        // Random cell edits made to both engines before each step
+    uint64_t editSeed = 1;       // Edits are drawn from this seed, the step and the edit
+    bool deferPollution = false; // The checked engine defers pollution, caught up to compare
+    int commuteDistance = 0;     // Commute limit for both engines; 0 is off
+    bool landValue = false;      // Land value limit for both engines
+    int minimumLandValue = 0;
+
+    bool isPlain() const { return editsPerStep == 0 && !deferPollution && commuteDistance == 0 && !landValue; }
+};
+
+// Engine under test; implementations live in DifferentialChecker.cpp
+class CheckedEngine
+{
+public:
+    virtual ~CheckedEngine() {}
+
+    // Start from the layout in rows, whose region file text is regionText
+    virtual bool load(const LayoutRows &rows, const std::string &regionText, std::string &error) = 0;
+    virtual void step() = 0;
+
+    // Change the type of one cell between steps; false if the engine has no edits
+    virtual bool edit(int, int, char) { return false; }
+
+    // All cells in row-major order
+    virtual void read(std::vector<Cell> &cells) = 0;
+};
+
+class DifferentialChecker
+{
+public:
+    // Engines that can be checked: sparse, adaptive, kernel, tiled, fixed
+    // (the reference engine's fixed-size specializations) and batch
+    static const std::vector<std::string> &engineNames();
+    static bool isKnownEngine(const std::string &name);
+
+    // Whether engine runs differently from the reference on this size at all
+    static bool supports(const std::string &engine, int width, int height);
+
+    // Whether engine can run under options; only the engines behind
+    // Simulation (sparse, adaptive and fixed) take edits and optional rules
+    static bool supports(const std::string &engine, const CheckOptions &options);
+
+    // workDir holds the scratch files of engines that need them (tiled)
+    DifferentialChecker(const std::string &engine, const std::string &workDir,
+                        const CheckOptions &options = CheckOptions());
+
+    const std::string &getEngine() const { return engine; }
+    const CheckOptions &getOptions() const { return options; }
+    void setOptions(const CheckOptions &newOptions) { options = newOptions; }
+
+    // Step both engines over rows for up to maxSteps steps and report the
+    // first difference; false if an engine could not load the layout
+    bool compare(const LayoutRows &rows, int maxSteps, Divergence &divergence, std::string &error);
+
+    // Shrink rows while the engines still differ within divergence.step
+    // steps: crop rows and columns, then clear blocks of cells down to
+    // single cells. Updates divergence to the reproducer's difference.
+    LayoutRows minimize(const LayoutRows &rows, Divergence &divergence);
+
+    // Comparisons run so far, including those made while minimizing
+    long long getComparisons() const { return comparisons; }
+
+    // Random generator settings for the region-th region of a run with seed
+    static GeneratorParams randomParams(uint64_t seed, int region, int minSize, int maxSize, bool square = false);
+    static LayoutRows generate(const GeneratorParams &params);
+
+    static std::string toRegionText(const LayoutRows &rows);
+    static bool readLayout(const std::string &filename, LayoutRows &rows);
+    static bool writeLayout(const std::string &filename, const LayoutRows &rows);
+
+private:
+    std::unique_ptr<CheckedEngine> createEngine() const;
+    bool diverges(const LayoutRows &rows, int maxSteps, Divergence &divergence);
+    bool tryCandidate(LayoutRows &rows, const LayoutRows &candidate, Divergence &divergence);
+
+    std::string engine;
+    std::string workDir;
+    CheckOptions options;
+    long long comparisons;
+};
+
+#endif // DIFFERENTIAL_CHECKER_H
@@ -0,0 +1,285 @@
+// DistributedSimulation.cpp
+#include "DistributedSimulation.h"
+#include "RegionReader.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+
+DistributedSimulation::DistributedSimulation()
+    : width(0), height(0), changed(false), totalPollution(0), availableWorkers(0), availableGoods(0),
+      stateHash(0)
+{
+    totals[0] = totals[1] = totals[2] = 0;
+}
+
+DistributedSimulation::~DistributedSimulation()
+{
+    stop();
+}
+
+bool DistributedSimulation::start(const std::string &regionFile, int workers, const std::string &transport)
+{
+    stop();
+
+    std::ifstream file(regionFile);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open region file: " << regionFile << std::endl;
+        return false;
+    }
+    try
+    {
+        RegionReader reader(file);
+        width = reader.getWidth();
+        height = reader.getHeight();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading region file: " << e.what() << std::endl;
+        return false;
+    }
+    file.close();
+
+    // Every strip must hold a full halo for its neighbours
+    int count = std::max(1, std::min(workers, height / DomainWorker::HALO));
+
+    // controls[k] links the coordinator (side 0) and worker k (side 1);
+    // halos[k] links worker k (side 0) and worker k + 1 (side 1)
+    std::vector<std::unique_ptr<Channel>> halos;
+    for (int k = 0; k < count; k++)
+    {
+        controls.push_back(Channel::create("socket"));
+        if (!controls.back())
+            return false;
+        if (k + 1 < count)
+        {
+            halos.push_back(Channel::create(transport));
+            if (!halos.back())
+                return false;
+        }
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t coordinator = getpid();
+    for (int k = 0; k < count; k++)
+    {
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            std::cerr << "Error: Cannot start worker " << k << std::endl;
+            stop();
+            return false;
+        }
+        if (pid == 0)
+        {
+            // Workers die with the coordinator
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != coordinator)
+                _exit(1);
+
+            Channel *upper = k > 0 ? halos[k - 1].get() : nullptr;
+            Channel *lower = k + 1 < count ? halos[k].get() : nullptr;
+            for (int other = 0; other < count; other++)
+            {
+                if (other == k)
+                    controls[other]->attach(1);
+                else
+                    controls[other]->detach();
+            }
+            for (int link = 0; link + 1 < count; link++)
+            {
+                if (link == k - 1)
+                    halos[link]->attach(1);
+                else if (link == k)
+                    halos[link]->attach(0);
+                else
+                    halos[link]->detach();
+            }
+
+            int firstRow = static_cast<long long>(height) * k / count;
+            int lastRow = static_cast<long long>(height) * (k + 1) / count;
+            int status = runWorker(k, firstRow, lastRow, height, regionFile, *controls[k], upper, lower);
+            std::cout.flush();
+            _exit(status);
+        }
+        pids.push_back(pid);
+    }
+
+    for (auto &control : controls)
+        control->attach(0);
+    halos.clear();
+
+    reports.resize(count);
+    return gatherReports();
+}
+
+int DistributedSimulation::runWorker(int rank, int firstRow, int lastRow, int regionHeight,
+                                     const std::string &regionFile, Channel &control, Channel *upper,
+                                     Channel *lower)
+{
+    DomainWorker worker(firstRow, lastRow, regionHeight);
+    if (!worker.load(regionFile))
+        return 1;
+
+    // Loaded regions have no population yet, so the halos start out in sync
+    WorkerReport report;
+    worker.fillReport(report);
+    if (!control.send(&report, sizeof(report)))
+        return 1;
+
+    while (true)
+    {
+        WorkerOrders orders;
+        if (!control.receive(&orders, sizeof(orders)))
+            return 1;
+        if (orders.stop)
+            return 0;
+
+        worker.grow(orders);
+        if (!exchangeHalo(worker, rank, upper, lower))
+            return 1;
+        worker.finishStep(report);
+        if (!control.send(&report, sizeof(report)))
+            return 1;
+    }
+}
+
+// Even ranks send first and odd ranks receive first on every link, so no
+// pair of workers both block on a full channel
+bool DistributedSimulation::exchangeHalo(DomainWorker &worker, int rank, Channel *upper, Channel *lower)
+{
+    std::vector<uint8_t> outgoing;
+    std::vector<uint8_t> incoming(static_cast<size_t>(DomainWorker::HALO) * worker.getWidth());
+    bool sendFirst = rank % 2 == 0;
+    Channel *links[2] = {sendFirst ? lower : upper, sendFirst ? upper : lower};
+
+    for (Channel *link : links)
+    {
+        if (!link)
+            continue;
+        bool top = link == upper;
+        worker.getEdgeRows(top, outgoing);
+        if (sendFirst)
+        {
+            if (!link->send(outgoing.data(), outgoing.size()) || !link->receive(incoming.data(), incoming.size()))
+                return false;
+        }
+        else
+        {
+            if (!link->receive(incoming.data(), incoming.size()) || !link->send(outgoing.data(), outgoing.size()))
+                return false;
+        }
+        worker.setHaloRows(top, incoming);
+    }
+    return true;
+}
+
+bool DistributedSimulation::gatherReports()
+{
+    changed = false;
+    totals[0] = totals[1] = totals[2] = 0;
+    totalPollution = 0;
+    stateHash = 0;
+    for (size_t k = 0; k < controls.size(); k++)
+    {
+        WorkerReport &report = reports[k];
+        if (!controls[k]->receive(&report, sizeof(report)))
+        {
+            std::cerr << "Error: Worker " << k << " stopped unexpectedly" << std::endl;
+            for (pid_t pid : pids)
+                kill(pid, SIGKILL);
+            stop();
+            return false;
+        }
+        changed = changed || report.changed;
+        for (int i = 0; i < 3; i++)
+            totals[i] += report.totals[i];
+        totalPollution += report.totalPollution;
+        stateHash ^= report.hash;
+    }
+    return true;
+}
+
+DistributedSimulation::Selection DistributedSimulation::select(const long long *counts, long long grown)
+{
+    Selection selection = {-1, 0};
+    selection.cutoff = CandidateBuckets::cutoff(counts, grown, selection.remaining);
+    return selection;
+}
+
+bool DistributedSimulation::step()
+{
+    if (pids.empty())
+        return false;
+
+    long long commercialCounts[DOMAIN_BUCKETS] = {};
+    long long industrialCounts[DOMAIN_BUCKETS] = {};
+    long long candidatesC = 0, candidatesI = 0;
+    for (const WorkerReport &report : reports)
+    {
+        for (int bucket = 0; bucket < DOMAIN_BUCKETS; bucket++)
+        {
+            commercialCounts[bucket] += report.commercialCounts[bucket];
+            industrialCounts[bucket] += report.industrialCounts[bucket];
+            candidatesC += report.commercialCounts[bucket];
+            candidatesI += report.industrialCounts[bucket];
+        }
+    }
+
+    // Same pooled resources and consumption order as Region's reference step
+    long long workers = totals[0];
+    long long goods = totals[2];
+    long long grownC = std::min(candidatesC, std::min(workers, goods));
+    workers -= grownC;
+    goods -= grownC;
+    long long grownI = std::min(candidatesI, workers / 2);
+    workers -= 2 * grownI;
+    goods += grownI;
+    availableWorkers = workers;
+    availableGoods = goods;
+
+    // Strips are in row order, so the cut-off bucket is handed out top down
+    Selection commercial = select(commercialCounts, grownC);
+    Selection industrial = select(industrialCounts, grownI);
+    for (size_t k = 0; k < controls.size(); k++)
+    {
+        WorkerOrders orders = {0, commercial.cutoff, 0, industrial.cutoff, 0};
+        if (commercial.cutoff >= 0)
+        {
+            orders.commercialQuota = std::min(reports[k].commercialCounts[commercial.cutoff], commercial.remaining);
+            commercial.remaining -= orders.commercialQuota;
+        }
+        if (industrial.cutoff >= 0)
+        {
+            orders.industrialQuota = std::min(reports[k].industrialCounts[industrial.cutoff], industrial.remaining);
+            industrial.remaining -= orders.industrialQuota;
+        }
+        controls[k]->send(&orders, sizeof(orders));
+    }
+    return gatherReports();
+}
+
+void DistributedSimulation::stop()
+{
+    WorkerOrders orders = {1, 0, 0, 0, 0};
+    for (auto &control : controls)
+        control->send(&orders, sizeof(orders));
+    controls.clear();
+
+    for (pid_t pid : pids)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+    pids.clear();
+}
+
+long long DistributedSimulation::getTotalPopulation(char type) const
+{
+    return type == 'R' ? totals[0] : (type == 'C' ? totals[1] : (type == 'I' ? totals[2] : 0));
+}
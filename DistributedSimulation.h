@@ -0,0 +1,71 @@
+// DistributedSimulation.h
+// Runs a region as horizontal strips owned by separate worker processes.
+// The calling process coordinates: it pools the workers and goods reported
+// by every strip, decides which growth candidates receive them in global
+// priority order, and stops the run. Neighbouring workers exchange halo
+// rows directly over the chosen transport each step. Control messages
+// always use Unix sockets so a crashed worker ends the run. Results are
+// identical to a single-process run.
+#ifndef DISTRIBUTED_SIMULATION_H
+#define DISTRIBUTED_SIMULATION_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <sys/types.h>
+#include "Transport.h"
+#include "DomainWorker.h"
+
+class DistributedSimulation
+{
+public:
+    DistributedSimulation();
+    ~DistributedSimulation();
+
+    // Fork the workers; each loads its own strip of the region file.
+    // transport selects the halo channels: "socket" or "shm".
+    bool start(const std::string &regionFile, int workers, const std::string &transport);
+
+    // Advance one global time step; false if a worker failed
+    bool step();
+
+    // Stop and reap the workers
+    void stop();
+
+    bool hasChanged() const { return changed; }
+    int getWorkerCount() const { return static_cast<int>(pids.size()); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    long long getTotalPopulation(char type) const;
+    long long getTotalPollution() const { return totalPollution; }
+    long long getAvailableWorkers() const { return availableWorkers; }
+    long long getAvailableGoods() const { return availableGoods; }
+    uint64_t getStateHash() const { return stateHash; }
+
+private:
+    struct Selection
+    {
+        int cutoff;
+        long long remaining; // Cells of the cut-off bucket still to hand out
+    };
+
+    static Selection select(const long long *counts, long long grown);
+    static int runWorker(int rank, int firstRow, int lastRow, int regionHeight, const std::string &regionFile,
+                         Channel &control, Channel *upper, Channel *lower);
+    static bool exchangeHalo(DomainWorker &worker, int rank, Channel *upper, Channel *lower);
+    bool gatherReports();
+
+    int width, height;
+    std::vector<pid_t> pids;
+    std::vector<std::unique_ptr<Channel>> controls;
+    std::vector<WorkerReport> reports;
+
+    bool changed;
+    long long totals[3];
+    long long totalPollution;
+    long long availableWorkers, availableGoods;
+    uint64_t stateHash;
+};
+
+#endif // DISTRIBUTED_SIMULATION_H
@@ -0,0 +1,197 @@
+// DomainWorker.cpp
+#include "DomainWorker.h"
+#include "RegionReader.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+const int DomainWorker::HALO;
+
+static const int PLANT_POLLUTION = 4;
+
+DomainWorker::DomainWorker(int firstRow, int lastRow, int regionHeight)
+    : firstRow(firstRow), lastRow(lastRow), height(regionHeight), width(0), grew(false)
+{
+}
+
+bool DomainWorker::load(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open region file: " << filename << std::endl;
+        return false;
+    }
+
+    try
+    {
+        RegionReader reader(file);
+        width = reader.getWidth();
+        int localRows = lastRow - firstRow + 2 * HALO;
+        types.assign(static_cast<size_t>(localRows) * width, '-');
+        population.assign(types.size(), 0);
+        nextPopulation.assign(types.size(), 0);
+        pollution.assign(static_cast<size_t>(lastRow - firstRow) * width, 0);
+        nextPollution.assign(pollution.size(), 0);
+
+        // Rows past the strip's lower halo are never needed
+        std::vector<char> row;
+        int lastNeeded = std::min(height, lastRow + HALO);
+        for (int y = 0; y < lastNeeded; y++)
+        {
+            reader.readRow(y, row);
+            if (y >= firstRow - HALO)
+                std::copy(row.begin(), row.end(), types.begin() + index(0, y));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading region file: " << e.what() << std::endl;
+        return false;
+    }
+
+    // Loaded regions start with no population and no pollution
+    hash = StateHash();
+    return true;
+}
+
+// Growth rules and priority bucket of (x, y) over the strip and its halo
+int DomainWorker::candidateBucket(int x, int y) const
+{
+    auto typeAt = [this](int cellX, int cellY) { return types[index(cellX, cellY)]; };
+    auto populationAt = [this](int cellX, int cellY) { return population[index(cellX, cellY)]; };
+    return CandidateBuckets::bucket(x, y, width, height, typeAt, populationAt);
+}
+
+void DomainWorker::grow(const WorkerOrders &orders)
+{
+    nextPopulation = population;
+    long long commercialTaken = 0, industrialTaken = 0;
+    grew = false;
+
+    // Row order matches the single-process tie-break on y, then x
+    for (int y = firstRow; y < lastRow; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t cell = index(x, y);
+            char type = types[cell];
+            if (type != 'R' && type != 'C' && type != 'I')
+                continue;
+
+            int bucket = candidateBucket(x, y);
+            if (bucket < 0)
+                continue;
+
+            if (type == 'C' && !CandidateBuckets::takes(bucket, orders.commercialCutoff, orders.commercialQuota,
+                                                        commercialTaken))
+                continue;
+            if (type == 'I' && !CandidateBuckets::takes(bucket, orders.industrialCutoff, orders.industrialQuota,
+                                                        industrialTaken))
+                continue;
+
+            nextPopulation[cell]++;
+            hash.updatePopulation(x, y, population[cell], nextPopulation[cell]);
+            grew = true;
+        }
+    }
+}
+
+void DomainWorker::getEdgeRows(bool top, std::vector<uint8_t> &rows) const
+{
+    int y0 = top ? firstRow : lastRow - HALO;
+    rows.assign(nextPopulation.begin() + index(0, y0), nextPopulation.begin() + index(0, y0 + HALO));
+}
+
+void DomainWorker::setHaloRows(bool top, const std::vector<uint8_t> &rows)
+{
+    int y0 = top ? firstRow - HALO : lastRow;
+    std::copy(rows.begin(), rows.end(), nextPopulation.begin() + index(0, y0));
+}
+
+void DomainWorker::finishStep(WorkerReport &report)
+{
+    // Gather pollution from every source within reach of the owned rows
+    std::fill(nextPollution.begin(), nextPollution.end(), 0);
+    int sourceFirst = std::max(0, firstRow - HALO);
+    int sourceLast = std::min(height, lastRow + HALO);
+    for (int y = sourceFirst; y < sourceLast; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t cell = index(x, y);
+            int source = types[cell] == 'I' ? nextPopulation[cell] : (types[cell] == 'P' ? PLANT_POLLUTION : 0);
+            if (source <= 0)
+                continue;
+
+            for (int dy = -HALO; dy <= HALO; dy++)
+            {
+                int newY = y + dy;
+                if (newY < firstRow || newY >= lastRow)
+                    continue;
+                for (int dx = -HALO; dx <= HALO; dx++)
+                {
+                    int newX = x + dx;
+                    if (newX < 0 || newX >= width)
+                        continue;
+                    int distance = std::max(std::abs(dx), std::abs(dy));
+                    nextPollution[static_cast<size_t>(newY - firstRow) * width + newX] += std::max(0, source - distance);
+                }
+            }
+        }
+    }
+
+    bool changed = grew;
+    for (int y = firstRow; y < lastRow; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t cell = static_cast<size_t>(y - firstRow) * width + x;
+            if (pollution[cell] == nextPollution[cell])
+                continue;
+            hash.updatePollution(x, y, pollution[cell], nextPollution[cell]);
+            pollution[cell] = nextPollution[cell];
+            changed = true;
+        }
+    }
+
+    population.swap(nextPopulation);
+    fillReport(report);
+    report.changed = changed;
+}
+
+void DomainWorker::countCandidates(WorkerReport &report) const
+{
+    for (int y = firstRow; y < lastRow; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t cell = index(x, y);
+            char type = types[cell];
+            if (type == 'R')
+                report.totals[0] += population[cell];
+            else if (type == 'C' || type == 'I')
+            {
+                int bucket = candidateBucket(x, y);
+                report.totals[type == 'C' ? 1 : 2] += population[cell];
+                if (bucket >= 0)
+                    (type == 'C' ? report.commercialCounts : report.industrialCounts)[bucket]++;
+            }
+        }
+    }
+}
+
+void DomainWorker::fillReport(WorkerReport &report)
+{
+    std::fill(report.totals, report.totals + 3, 0);
+    std::fill(report.commercialCounts, report.commercialCounts + DOMAIN_BUCKETS, 0);
+    std::fill(report.industrialCounts, report.industrialCounts + DOMAIN_BUCKETS, 0);
+    countCandidates(report);
+
+    report.totalPollution = 0;
+    for (uint16_t value : pollution)
+        report.totalPollution += value;
+    report.hash = hash.getHash();
+    report.changed = 0;
+}
@@ -0,0 +1,86 @@
+// DomainWorker.h
+// One subdomain of a distributed run: a horizontal strip of rows plus a
+// halo of HALO rows above and below, wide enough for the 3-cell pollution
+// radius and the 1-cell growth neighbourhood. The worker steps its own rows;
+// populations of the halo rows come from the neighbouring strips.
+//
+// Commercial and industrial priority is global. Each worker reports its
+// candidates counted per (population, adjacent population) bucket; the
+// coordinator picks the cut-off bucket and, because strips are in row order,
+// hands out the cut-off bucket's remaining growth to workers in strip order.
+// That reproduces the single-process sort on (population, adjacent, y, x).
+#ifndef DOMAIN_WORKER_H
+#define DOMAIN_WORKER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "StateHash.h"
+#include "StepKernel.h"
+
+static const int DOMAIN_BUCKETS = CandidateBuckets::COUNT;
+
+// Worker to coordinator, after loading and after every step
+struct WorkerReport
+{
+    long long totals[3]; // Residential, commercial, industrial population
+    long long commercialCounts[DOMAIN_BUCKETS];
+    long long industrialCounts[DOMAIN_BUCKETS];
+    long long totalPollution;
+    uint64_t hash; // Zobrist hash of the strip's own cells
+    int changed;
+};
+
+// Coordinator to worker, before every step
+struct WorkerOrders
+{
+    int stop;
+    int commercialCutoff; // Buckets above grow, buckets below do not
+    long long commercialQuota; // Cells of the cut-off bucket this strip grows
+    int industrialCutoff;
+    long long industrialQuota;
+};
+
+class DomainWorker
+{
+public:
+    static const int HALO = 3;
+
+    // Owns rows [firstRow, lastRow) of a region with the given height
+    DomainWorker(int firstRow, int lastRow, int regionHeight);
+
+    // Read the strip and its halo rows of types from a region file
+    bool load(const std::string &filename);
+
+    void grow(const WorkerOrders &orders);
+
+    // Owned edge rows sent to a neighbour, and halo rows received from one
+    void getEdgeRows(bool top, std::vector<uint8_t> &rows) const;
+    void setHaloRows(bool top, const std::vector<uint8_t> &rows);
+
+    // Recompute pollution, then count candidates for the next step
+    void finishStep(WorkerReport &report);
+
+    // Counts and totals of the loaded state
+    void fillReport(WorkerReport &report);
+
+    int getWidth() const { return width; }
+
+private:
+    int localRow(int y) const { return y - firstRow + HALO; }
+    size_t index(int x, int y) const { return static_cast<size_t>(localRow(y)) * width + x; }
+
+    int candidateBucket(int x, int y) const;
+    void countCandidates(WorkerReport &report) const;
+
+    int firstRow, lastRow, height, width;
+    std::vector<char> types;            // Owned and halo rows; '-' outside the region
+    std::vector<uint8_t> population;    // Owned and halo rows
+    std::vector<uint8_t> nextPopulation;
+    std::vector<uint16_t> pollution;    // Owned rows only
+    std::vector<int> nextPollution;
+    StateHash hash;
+    bool grew;
+};
+
+#endif // DOMAIN_WORKER_H
@@ -0,0 +1,30 @@
+// EngineSelector.cpp
+#include "EngineSelector.h"
+
+const long long EngineSelector::MIN_SPARSE_CELLS;
+const int EngineSelector::HOLD_STEPS;
+constexpr double EngineSelector::SPARSE_BELOW;
+constexpr double EngineSelector::REFERENCE_ABOVE;
+
+void EngineSelector::reset(long long regionCells)
+{
+    cells = regionCells;
+    sparse = false;
+    streak = 0;
+}
+
+void EngineSelector::observe(long long changes)
+{
+    if (cells < MIN_SPARSE_CELLS)
+        return;
+
+    // Between the two thresholds neither engine is clearly better, so stay
+    double fraction = static_cast<double>(changes) / cells;
+    bool favoursOther = sparse ? fraction > REFERENCE_ABOVE : fraction < SPARSE_BELOW;
+    streak = favoursOther ? streak + 1 : 0;
+    if (streak >= HOLD_STEPS)
+    {
+        sparse = !sparse;
+        streak = 0;
+    }
+}
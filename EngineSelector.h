@@ -0,0 +1,39 @@
+// EngineSelector.h
+// Chooses the step engine for adaptive runs from what recent steps did.
+// The reference engine scans every cell, which pays off while much of the
+// map is changing; the sparse engine only visits chunks near changes, which
+// pays off once activity dies down. Moving the state between the grid and
+// the chunks costs about one step, so the choice only flips after
+// HOLD_STEPS steps in a row point the other way. Decisions depend only on
+// the region and its history, never on timing, so a run always switches at
+// the same steps.
+#ifndef ENGINE_SELECTOR_H
+#define ENGINE_SELECTOR_H
+
+class EngineSelector
+{
+public:
+    // Regions with fewer cells than one sparse chunk always use the reference engine
+    static const long long MIN_SPARSE_CELLS = 64 * 64;
+    static const int HOLD_STEPS = 3;
+    // Changed-cell fractions (population and pollution values per cell)
+    static constexpr double SPARSE_BELOW = 0.10;
+    static constexpr double REFERENCE_ABOVE = 0.30;
+
+    EngineSelector() : cells(0), sparse(false), streak(0) {}
+
+    // Start over for a region of this many cells, on the reference engine
+    void reset(long long regionCells);
+
+    // Feed the number of values the last step changed
+    void observe(long long changes);
+
+    bool prefersSparse() const { return sparse; }
+
+private:
+    long long cells;
+    bool sparse;
+    int streak; // Consecutive steps that favoured the other engine
+};
+
+#endif // ENGINE_SELECTOR_H
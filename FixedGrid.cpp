@@ -0,0 +1,28 @@
+// FixedGrid.cpp
+// Instantiates FixedGrid for every supported size and picks one at run time.
+#include "FixedGrid.h"
+
+typedef FixedGridEngine *(*FixedGridFactory)();
+
+template <int N>
+static FixedGridEngine *makeFixedGrid()
+{
+    return new FixedGrid<N, N>();
+}
+
+// Factories indexed by side - MIN_SIZE
+template <int... I>
+static const FixedGridFactory *factories(std::integer_sequence<int, I...>)
+{
+    static const FixedGridFactory table[] = {&makeFixedGrid<FixedGridEngine::MIN_SIZE + I>...};
+    return table;
+}
+
+std::unique_ptr<FixedGridEngine> FixedGridEngine::create(int width, int height)
+{
+    if (!isSupported(width, height))
+        return nullptr;
+    const int sizes = MAX_SIZE - MIN_SIZE + 1;
+    const FixedGridFactory *table = factories(std::make_integer_sequence<int, sizes>());
+    return std::unique_ptr<FixedGridEngine>(table[width - MIN_SIZE]());
+}
@@ -0,0 +1,336 @@
+// FixedGrid.h
+// Step engine compiled for one region size, for workloads made of many
+// small regions. With the width and height known at compile time every
+// plane is a std::array inside the object, neighbour offsets are
+// constants, and the eight-neighbour loops are unrolled. Planes carry a
+// border of empty cells (1 cell for growth, 3 for pollution), so no
+// neighbour access needs a bounds check. Nothing is allocated per step.
+// When resources do not cover every growth candidate, the candidates are
+// ordered by a counting sort over (population, adjacent population)
+// buckets, which keeps the row-major order within a bucket and so matches
+// the priority rules' sort. Results are identical to the reference
+// engine's.
+#ifndef FIXED_GRID_H
+#define FIXED_GRID_H
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include "Cell.h"
+#include "Profiler.h"
+#include "StateHash.h"
+
+// Size-independent interface; Simulation holds one for regions of a size
+// that has a specialization
+class FixedGridEngine
+{
+public:
+    // Square regions with a side in this range have a specialization. Each
+    // size costs compile time and code, so not every rectangle gets one.
+    static const int MIN_SIZE = 4;
+    static const int MAX_SIZE = 16;
+
+    virtual ~FixedGridEngine() {}
+
+    static bool isSupported(int width, int height)
+    {
+        return width == height && width >= MIN_SIZE && width <= MAX_SIZE;
+    }
+
+    // The engine for width x height, or nullptr if there is none
+    static std::unique_ptr<FixedGridEngine> create(int width, int height);
+
+    virtual void loadFromGrid(const std::vector<std::vector<Cell>> &grid) = 0;
+    virtual void storeToGrid(std::vector<std::vector<Cell>> &grid) const = 0;
+
+    // Advance one time step starting with the given resources, which are
+    // left over on return. grown receives the residential, industrial and
+    // commercial growth; returns the total pollution afterwards.
+    virtual int step(int &availableWorkers, int &availableGoods, int grown[3], StateHash *hash) = 0;
+};
+
+template <int W, int H>
+class FixedGrid : public FixedGridEngine
+{
+public:
+    FixedGrid()
+    {
+        types.fill('-');
+        population.fill(0);
+        sameType.fill(0);
+        powered.fill(0);
+        pollution.fill(0);
+        target.fill(0);
+    }
+
+    void loadFromGrid(const std::vector<std::vector<Cell>> &grid) override
+    {
+        for (int y = 0; y < H; y++)
+        {
+            for (int x = 0; x < W; x++)
+            {
+                types[cell(x, y)] = grid[y][x].getType();
+                population[cell(x, y)] = static_cast<uint8_t>(grid[y][x].getPopulation());
+                pollution[y * W + x] = grid[y][x].getPollution();
+            }
+        }
+
+        // Zone lists in row-major order, with their neighbour masks and power
+        const char zones[3] = {'R', 'I', 'C'};
+        int count = 0;
+        for (int zone = 0; zone < 3; zone++)
+        {
+            zoneStart[zone] = count;
+            for (int y = 0; y < H; y++)
+            {
+                for (int x = 0; x < W; x++)
+                {
+                    int index = cell(x, y);
+                    if (types[index] != zones[zone])
+                        continue;
+                    zoneCells[count++] = static_cast<uint16_t>(index);
+                    sameType[index] = 0;
+                    powered[index] = 0;
+                    for (int k = 0; k < 8; k++)
+                    {
+                        char neighbour = types[index + OFFSETS[k]];
+                        if (neighbour == zones[zone])
+                            sameType[index] |= static_cast<uint8_t>(1 << k);
+                        if (neighbour == 'T' || neighbour == '#' || neighbour == 'P')
+                            powered[index] = 1;
+                    }
+                }
+            }
+        }
+        zoneStart[3] = count;
+
+        // Pollution the current populations lead to; the grid's own values
+        // may still be those of an earlier state
+        target.fill(0);
+        for (int y = 0; y < H; y++)
+        {
+            for (int x = 0; x < W; x++)
+            {
+                char type = types[cell(x, y)];
+                int source = type == 'I' ? population[cell(x, y)] : (type == 'P' ? PLANT_POLLUTION : 0);
+                for (int level = 0; level < source; level++)
+                    raiseSquare(x, y, level);
+            }
+        }
+    }
+
+    void storeToGrid(std::vector<std::vector<Cell>> &grid) const override
+    {
+        for (int y = 0; y < H; y++)
+        {
+            for (int x = 0; x < W; x++)
+            {
+                grid[y][x].setPopulation(population[cell(x, y)]);
+                grid[y][x].setPollution(pollution[y * W + x]);
+            }
+        }
+    }
+
+    int step(int &availableWorkers, int &availableGoods, int grown[3], StateHash *hash) override
+    {
+        // Commercial before industrial, both in priority order
+        int candidates = collect(ZONE_COMMERCIAL, 2);
+        int allCandidates = candidates;
+        int grownC = 0, grownI = 0;
+        const uint16_t *ranked = rank(candidates, std::min(availableWorkers, availableGoods));
+        for (int i = 0; i < candidates && availableWorkers >= 1 && availableGoods >= 1; i++)
+        {
+            grow(ranked[i], hash);
+            availableWorkers--;
+            availableGoods--;
+            grownC++;
+        }
+
+        candidates = collect(ZONE_INDUSTRIAL, 3);
+        allCandidates += candidates;
+        ranked = rank(candidates, availableWorkers / 2);
+        for (int i = 0; i < candidates && availableWorkers >= 2; i++)
+        {
+            // A source of level p reaches distance p - 1; one more level reaches one cell further
+            int index = ranked[i];
+            raiseSquare(index % PW - 1, index / PW - 1, population[index]);
+            grow(index, hash);
+            availableWorkers -= 2;
+            availableGoods++;
+            grownI++;
+        }
+
+        // Residential growth is not resource limited, so no ordering needed
+        candidates = 0;
+        for (int i = zoneStart[ZONE_RESIDENTIAL]; i < zoneStart[ZONE_RESIDENTIAL + 1]; i++)
+        {
+            int index = zoneCells[i];
+            int pop = population[index];
+            if (pop < 4 && canGrow(index, pop, countAdjacent(index, 1)))
+                order[candidates++] = static_cast<uint16_t>(index);
+        }
+        for (int i = 0; i < candidates; i++)
+            grow(order[i], hash);
+        allCandidates += candidates;
+        grown[0] += candidates;
+        grown[1] += grownI;
+        grown[2] += grownC;
+
+        // Pollution was kept up to date in target; report what differs
+        int total = 0;
+        int pollutionChanged = 0;
+        for (int y = 0; y < H; y++)
+        {
+            for (int x = 0; x < W; x++)
+            {
+                int value = target[(y + POLLUTION_RADIUS) * QW + x + POLLUTION_RADIUS];
+                int &current = pollution[y * W + x];
+                if (value != current)
+                {
+                    if (hash)
+                        hash->updatePollution(x, y, current, value);
+                    current = value;
+                    pollutionChanged++;
+                }
+                total += value;
+            }
+        }
+
+        PROFILE_COUNT(COUNTER_CANDIDATES, allCandidates);
+        PROFILE_COUNT(COUNTER_CELLS_GROWN, candidates + grownI + grownC);
+        PROFILE_COUNT(COUNTER_WORKERS_CONSUMED, grownC + 2 * grownI);
+        PROFILE_COUNT(COUNTER_GOODS_CONSUMED, grownC);
+        PROFILE_COUNT(COUNTER_VALUES_CHANGED, candidates + grownI + grownC + pollutionChanged);
+        return total;
+    }
+
+private:
+    static const int PW = W + 2; // Growth planes, with a 1-cell border
+    static const int PH = H + 2;
+    static const int POLLUTION_RADIUS = 3;
+    static const int QW = W + 2 * POLLUTION_RADIUS; // Pollution target, with a 3-cell border
+    static const int QH = H + 2 * POLLUTION_RADIUS;
+    static const int PLANT_POLLUTION = 4;
+    static const int BUCKETS = 3 * 9; // Population 0..2 by 0..8 populated neighbours
+
+    enum
+    {
+        ZONE_RESIDENTIAL,
+        ZONE_INDUSTRIAL,
+        ZONE_COMMERCIAL
+    };
+
+    static constexpr int OFFSETS[8] = {-PW - 1, -PW, -PW + 1, -1, 1, PW - 1, PW, PW + 1};
+
+    static int cell(int x, int y) { return (y + 1) * PW + x + 1; }
+
+    // Same-type neighbours with at least minPop population, unrolled over the eight offsets
+    template <size_t... K>
+    int countAdjacent(int index, int minPop, std::index_sequence<K...>) const
+    {
+        uint8_t mask = sameType[index];
+        return (((mask >> K) & 1 & (population[index + OFFSETS[K]] >= minPop)) + ...);
+    }
+
+    int countAdjacent(int index, int minPop) const
+    {
+        return countAdjacent(index, minPop, std::make_index_sequence<8>());
+    }
+
+    // The zone systems' growth rules below the zone's maximum population;
+    // adjacent is the count at population >= 1
+    bool canGrow(int index, int pop, int adjacent) const
+    {
+        switch (pop)
+        {
+        case 0:
+            return powered[index] || adjacent >= 1;
+        case 1:
+            return adjacent >= 2;
+        case 2:
+            return countAdjacent(index, 2) >= 4;
+        case 3:
+            return countAdjacent(index, 3) >= 6;
+        default:
+            return false;
+        }
+    }
+
+    // Gather the growable cells of one zone in row-major order; returns
+    // their number
+    int collect(int zone, int maxPopulation)
+    {
+        int candidates = 0;
+        for (int i = zoneStart[zone]; i < zoneStart[zone + 1]; i++)
+        {
+            int index = zoneCells[i];
+            int pop = population[index];
+            if (pop >= maxPopulation)
+                continue;
+            int adjacent = countAdjacent(index, 1);
+            if (!canGrow(index, pop, adjacent))
+                continue;
+            // Highest priority in bucket 0
+            uint8_t bucket = static_cast<uint8_t>(BUCKETS - 1 - (pop * 9 + adjacent));
+            candidateCells[candidates] = static_cast<uint16_t>(index);
+            candidateBuckets[candidates++] = bucket;
+        }
+        return candidates;
+    }
+
+    // The candidates by population, then adjacent population, then
+    // row-major position. The order only matters when fewer than all of
+    // them can be afforded, so otherwise they are left as collected.
+    const uint16_t *rank(int candidates, int affordable)
+    {
+        if (affordable >= candidates)
+            return candidateCells.data();
+        std::array<int, BUCKETS + 1> start = {};
+        for (int i = 0; i < candidates; i++)
+            start[candidateBuckets[i] + 1]++;
+        for (int bucket = 0; bucket < BUCKETS; bucket++)
+            start[bucket + 1] += start[bucket];
+        for (int i = 0; i < candidates; i++)
+            order[start[candidateBuckets[i]]++] = candidateCells[i];
+        return order.data();
+    }
+
+    void grow(int index, StateHash *hash)
+    {
+        int pop = population[index];
+        if (hash)
+            hash->updatePopulation(index % PW - 1, index / PW - 1, pop, pop + 1);
+        population[index] = static_cast<uint8_t>(pop + 1);
+    }
+
+    // Add 1 to the pollution target within distance level of (x, y)
+    void raiseSquare(int x, int y, int level)
+    {
+        for (int dy = -level; dy <= level; dy++)
+        {
+            int *row = &target[(y + dy + POLLUTION_RADIUS) * QW + x + POLLUTION_RADIUS];
+            for (int dx = -level; dx <= level; dx++)
+                row[dx]++;
+        }
+    }
+
+    std::array<char, PW * PH> types;
+    std::array<uint8_t, PW * PH> population;
+    std::array<uint8_t, PW * PH> sameType; // Bit k: neighbour k has the same zone type
+    std::array<uint8_t, PW * PH> powered;
+    std::array<int, W * H> pollution;  // As last reported
+    std::array<int, QW * QH> target;   // As implied by the current populations
+    std::array<uint16_t, W * H> zoneCells; // Residential, industrial, commercial cells, each row-major
+    int zoneStart[4];
+    std::array<uint16_t, W * H> candidateCells;
+    std::array<uint8_t, W * H> candidateBuckets;
+    std::array<uint16_t, W * H> order;
+};
+
+template <int W, int H>
+constexpr int FixedGrid<W, H>::OFFSETS[8];
+
+#endif // FIXED_GRID_H
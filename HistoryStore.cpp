@@ -0,0 +1,449 @@
+// HistoryStore.cpp
+#include "HistoryStore.h"
+#include "Simulation.h"
+#include <algorithm>
+
+const int HistoryStore::DEFAULT_KEYFRAME_INTERVAL;
+const size_t HistoryStore::DEFAULT_BUDGET_BYTES;
+
+HistoryStore::HistoryStore(int keyframeInterval, size_t budgetBytes)
+    : width(0), height(0), keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1),
+      budgetBytes(budgetBytes), memoryBytes(0), newestStep(0) {}
+
+size_t HistoryStore::frameBytes(const Frame &frame)
+{
+    return frame.types.size() + frame.population.size() + frame.pollution.size() * sizeof(uint16_t);
+}
+
+bool HistoryStore::reset(const std::vector<std::vector<Cell>> &grid, int step)
+{
+    keyframes.clear();
+    memoryBytes = 0;
+    newestStep = step;
+    size_t gridHeight = grid.size();
+    size_t cells = gridHeight * (gridHeight > 0 ? grid[0].size() : 0);
+    if (2 * cells * (sizeof(char) + sizeof(uint8_t) + sizeof(uint16_t)) > budgetBytes)
+    {
+        width = height = 0;
+        current = Frame();
+        return false;
+    }
+
+    height = grid.size();
+    width = height > 0 ? grid[0].size() : 0;
+    current.types.resize(cells);
+    current.population.resize(cells);
+    current.pollution.resize(cells);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t index = static_cast<size_t>(y) * width + x;
+            current.types[index] = grid[y][x].getType();
+            current.population[index] = grid[y][x].getPopulation();
+            current.pollution[index] = grid[y][x].getPollution();
+        }
+    }
+
+    keyframes.push_back(Keyframe{step, current, {}});
+    memoryBytes = frameBytes(keyframes.back().frame) + frameBytes(current);
+    return true;
+}
+
+static void writeVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static uint64_t readVarint(const uint8_t *&next)
+{
+    uint64_t value = 0;
+    int shift = 0;
+    while (*next & 0x80)
+    {
+        value |= static_cast<uint64_t>(*next++ & 0x7F) << shift;
+        shift += 7;
+    }
+    return value | static_cast<uint64_t>(*next++) << shift;
+}
+
+// Changes sorted by cell, each as varint(gap to the previous cell << 2 | field) and varint(value)
+void HistoryStore::encode(const std::vector<CellChange> &changes, int width, std::vector<uint8_t> &out)
+{
+    size_t previous = 0;
+    for (const CellChange &change : changes)
+    {
+        size_t index = static_cast<size_t>(change.y) * width + change.x;
+        writeVarint(out, (static_cast<uint64_t>(index - previous) << 2) | change.field);
+        writeVarint(out, change.value);
+        previous = index;
+    }
+}
+
+void HistoryStore::apply(const std::vector<uint8_t> &delta, Frame &frame)
+{
+    const uint8_t *next = delta.data();
+    const uint8_t *end = next + delta.size();
+    size_t index = 0;
+    while (next < end)
+    {
+        uint64_t header = readVarint(next);
+        int value = static_cast<int>(readVarint(next));
+        index += header >> 2;
+        switch (header & 3)
+        {
+        case FIELD_POPULATION:
+            frame.population[index] = value;
+            break;
+        case FIELD_POLLUTION:
+            frame.pollution[index] = value;
+            break;
+        case FIELD_TYPE:
+            frame.types[index] = static_cast<char>(value);
+            break;
+        }
+    }
+}
+
+// Order by cell and field and keep the last report of each value
+void HistoryStore::normalize(std::vector<CellChange> &changes) const
+{
+    // The stable sort keeps the last report of each value last
+    int rowWidth = width;
+    std::stable_sort(changes.begin(), changes.end(),
+                     [rowWidth](const CellChange &a, const CellChange &b)
+                     {
+                         long long indexA = static_cast<long long>(a.y) * rowWidth + a.x;
+                         long long indexB = static_cast<long long>(b.y) * rowWidth + b.x;
+                         return indexA != indexB ? indexA < indexB : a.field < b.field;
+                     });
+    size_t kept = 0;
+    for (size_t i = 0; i < changes.size(); i++)
+    {
+        bool last = i + 1 == changes.size() || changes[i + 1].x != changes[i].x ||
+                    changes[i + 1].y != changes[i].y || changes[i + 1].field != changes[i].field;
+        if (last)
+            changes[kept++] = changes[i];
+    }
+    changes.resize(kept);
+}
+
+void HistoryStore::decode(const std::vector<uint8_t> &delta, int width, std::vector<CellChange> &out)
+{
+    const uint8_t *next = delta.data();
+    const uint8_t *end = next + delta.size();
+    size_t index = 0;
+    while (next < end)
+    {
+        uint64_t header = readVarint(next);
+        int value = static_cast<int>(readVarint(next));
+        index += header >> 2;
+        out.push_back({static_cast<int>(index % width), static_cast<int>(index / width),
+                       static_cast<int>(header & 3), value});
+    }
+}
+
+void HistoryStore::record(int step, std::vector<CellChange> &changes)
+{
+    normalize(changes);
+
+    std::vector<uint8_t> delta;
+    encode(changes, width, delta);
+    apply(delta, current);
+    newestStep = step;
+
+    if (step - keyframes.back().step >= keyframeInterval)
+    {
+        keyframes.push_back(Keyframe{step, current, {}});
+        memoryBytes += frameBytes(current);
+    }
+    else
+    {
+        delta.shrink_to_fit();
+        memoryBytes += delta.size();
+        keyframes.back().deltas.push_back(std::move(delta));
+    }
+    enforceBudget();
+}
+
+void HistoryStore::amend(std::vector<CellChange> &changes)
+{
+    normalize(changes);
+    std::vector<uint8_t> delta;
+    encode(changes, width, delta);
+    apply(delta, current);
+
+    Keyframe &newest = keyframes.back();
+    if (newest.deltas.empty())
+    {
+        apply(delta, newest.frame);
+        return;
+    }
+
+    // Merge into the delta that leads to the newest step; later values win
+    std::vector<CellChange> merged;
+    decode(newest.deltas.back(), width, merged);
+    merged.insert(merged.end(), changes.begin(), changes.end());
+    normalize(merged);
+    memoryBytes -= newest.deltas.back().size();
+    newest.deltas.back().clear();
+    encode(merged, width, newest.deltas.back());
+    newest.deltas.back().shrink_to_fit();
+    memoryBytes += newest.deltas.back().size();
+    enforceBudget();
+}
+
+void HistoryStore::truncate(int step)
+{
+    if (!hasStep(step) || step == newestStep)
+        return;
+    while (keyframes.back().step > step)
+    {
+        memoryBytes -= frameBytes(keyframes.back().frame);
+        for (const auto &delta : keyframes.back().deltas)
+            memoryBytes -= delta.size();
+        keyframes.pop_back();
+    }
+    std::vector<std::vector<uint8_t>> &deltas = keyframes.back().deltas;
+    size_t kept = step - keyframes.back().step;
+    for (size_t i = kept; i < deltas.size(); i++)
+        memoryBytes -= deltas[i].size();
+    deltas.resize(kept);
+    restoreFrame(step, current);
+    newestStep = step;
+}
+
+template <typename T>
+static void writeValue(std::ostream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::istream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T>
+static void writeVector(std::ostream &out, const std::vector<T> &values)
+{
+    writeValue(out, static_cast<uint64_t>(values.size()));
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+static bool readVector(std::istream &in, std::vector<T> &values, uint64_t maxSize)
+{
+    uint64_t size;
+    if (!readValue(in, size) || size > maxSize)
+        return false;
+    values.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(values.data()), size * sizeof(T)));
+}
+
+// readVarint for untrusted input: false if the value runs past end
+static bool readCheckedVarint(const uint8_t *&next, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; next < end && shift < 64; shift += 7)
+    {
+        uint8_t byte = *next++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Whether every change in delta is complete and inside a frame of cells cells
+static bool isValidDelta(const std::vector<uint8_t> &delta, uint64_t cells)
+{
+    const uint8_t *next = delta.data();
+    const uint8_t *end = next + delta.size();
+    uint64_t index = 0;
+    while (next < end)
+    {
+        uint64_t header, value;
+        if (!readCheckedVarint(next, end, header) || !readCheckedVarint(next, end, value) ||
+            (header & 3) > FIELD_TYPE || (header >> 2) >= cells - index)
+            return false;
+        index += header >> 2;
+    }
+    return true;
+}
+
+void HistoryStore::write(std::ostream &out) const
+{
+    writeValue(out, static_cast<int32_t>(width));
+    writeValue(out, static_cast<int32_t>(height));
+    writeValue(out, static_cast<int32_t>(keyframeInterval));
+    writeValue(out, static_cast<int32_t>(newestStep));
+    writeValue(out, static_cast<uint64_t>(keyframes.size()));
+    for (const Keyframe &keyframe : keyframes)
+    {
+        writeValue(out, static_cast<int32_t>(keyframe.step));
+        writeVector(out, keyframe.frame.types);
+        writeVector(out, keyframe.frame.population);
+        writeVector(out, keyframe.frame.pollution);
+        writeValue(out, static_cast<uint64_t>(keyframe.deltas.size()));
+        for (const auto &delta : keyframe.deltas)
+            writeVector(out, delta);
+    }
+}
+
+bool HistoryStore::read(std::istream &in)
+{
+    int32_t newWidth, newHeight, interval, newest;
+    uint64_t count;
+    if (!readValue(in, newWidth) || !readValue(in, newHeight) || !readValue(in, interval) ||
+        !readValue(in, newest) || !readValue(in, count) || newWidth <= 0 || newHeight <= 0 || interval <= 0 ||
+        count == 0)
+        return false;
+
+    // Sizes are checked before anything is allocated, so a damaged image cannot ask for huge buffers
+    uint64_t cells = static_cast<uint64_t>(newWidth) * newHeight;
+    std::deque<Keyframe> loaded;
+    size_t bytes = 0;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        Keyframe keyframe;
+        int32_t step;
+        uint64_t deltaCount;
+        if (!readValue(in, step) || !readVector(in, keyframe.frame.types, cells) ||
+            !readVector(in, keyframe.frame.population, cells) || !readVector(in, keyframe.frame.pollution, cells) ||
+            keyframe.frame.types.size() != cells || keyframe.frame.population.size() != cells ||
+            keyframe.frame.pollution.size() != cells || !readValue(in, deltaCount) ||
+            deltaCount >= static_cast<uint64_t>(interval) ||
+            (!loaded.empty() && step != loaded.back().step + static_cast<int>(loaded.back().deltas.size()) + 1))
+            return false;
+        keyframe.step = step;
+        keyframe.deltas.resize(deltaCount);
+        bytes += frameBytes(keyframe.frame);
+        for (auto &delta : keyframe.deltas)
+        {
+            if (!readVector(in, delta, 8 * cells + 16) || !isValidDelta(delta, cells))
+                return false;
+            bytes += delta.size();
+        }
+        loaded.push_back(std::move(keyframe));
+    }
+    if (loaded.back().step + static_cast<int>(loaded.back().deltas.size()) != newest ||
+        2 * frameBytes(loaded.back().frame) > budgetBytes)
+        return false;
+
+    width = newWidth;
+    height = newHeight;
+    keyframeInterval = interval;
+    newestStep = newest;
+    keyframes.swap(loaded);
+    restoreFrame(newestStep, current);
+    memoryBytes = bytes + frameBytes(current);
+    enforceBudget();
+    return true;
+}
+
+// Drop the oldest keyframe and its deltas until the budget is met. When
+// the newest keyframe's deltas alone are too much, only the newest step is
+// kept, as a keyframe; reset() made sure one keyframe and current fit.
+void HistoryStore::enforceBudget()
+{
+    while (memoryBytes > budgetBytes && keyframes.size() > 1)
+    {
+        const Keyframe &oldest = keyframes.front();
+        memoryBytes -= frameBytes(oldest.frame);
+        for (const auto &delta : oldest.deltas)
+            memoryBytes -= delta.size();
+        keyframes.pop_front();
+    }
+    if (memoryBytes > budgetBytes && !keyframes.back().deltas.empty())
+    {
+        keyframes.clear();
+        keyframes.push_back(Keyframe{newestStep, current, {}});
+        memoryBytes = frameBytes(keyframes.back().frame) + frameBytes(current);
+    }
+}
+
+bool HistoryStore::restoreFrame(int step, Frame &frame) const
+{
+    if (!hasStep(step))
+        return false;
+
+    // The last keyframe at or before step
+    auto keyframe = std::upper_bound(keyframes.begin(), keyframes.end(), step,
+                                     [](int target, const Keyframe &candidate)
+                                     { return target < candidate.step; });
+    --keyframe;
+    frame = keyframe->frame;
+    for (int i = 0; i < step - keyframe->step; i++)
+        apply(keyframe->deltas[i], frame);
+    return true;
+}
+
+bool HistoryStore::restore(int step, std::vector<std::vector<Cell>> &grid) const
+{
+    Frame frame;
+    if (!restoreFrame(step, frame))
+        return false;
+
+    grid.assign(height, std::vector<Cell>(width));
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t index = static_cast<size_t>(y) * width + x;
+            grid[y][x].setType(frame.types[index]);
+            grid[y][x].setPopulation(frame.population[index]);
+            grid[y][x].setPollution(frame.pollution[index]);
+        }
+    }
+    return true;
+}
+
+bool HistoryStore::analyzeArea(int step, int x1, int y1, int x2, int y2, AreaStats &stats) const
+{
+    if (x1 > x2)
+        std::swap(x1, x2);
+    if (y1 > y2)
+        std::swap(y1, y2);
+    if (x1 < 0 || x2 >= width || y1 < 0 || y2 >= height)
+        return false;
+
+    // The newest state needs no replay
+    Frame restored;
+    const Frame *frame = &current;
+    if (step != newestStep)
+    {
+        if (!restoreFrame(step, restored))
+            return false;
+        frame = &restored;
+    }
+
+    stats.residential = stats.industrial = stats.commercial = stats.pollution = 0;
+    for (int y = y1; y <= y2; y++)
+    {
+        for (int x = x1; x <= x2; x++)
+        {
+            size_t index = static_cast<size_t>(y) * width + x;
+            switch (frame->types[index])
+            {
+            case 'R':
+                stats.residential += frame->population[index];
+                break;
+            case 'I':
+                stats.industrial += frame->population[index];
+                break;
+            case 'C':
+                stats.commercial += frame->population[index];
+                break;
+            }
+            stats.pollution += frame->pollution[index];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+// HistoryStore.h
+// Keeps every past state of a run so it can be queried after the fact. A
+// full keyframe of types, populations and pollution is stored every K
+// steps; the steps in between are stored as compressed lists of the values
+// that changed. Restoring a step starts from the nearest earlier keyframe
+// and replays at most K - 1 deltas. When the memory budget is exceeded the
+// oldest keyframe and its deltas are dropped, so the newest steps always
+// remain available; if the newest keyframe's deltas alone do not fit, the
+// newest step becomes the only keyframe. The budget covers the keyframes,
+// the deltas and the copy of the newest state kept for the next keyframe.
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <vector>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+#include "Cell.h"
+#include "StateHash.h"
+
+struct AreaStats;
+
+class HistoryStore
+{
+public:
+    static const int DEFAULT_KEYFRAME_INTERVAL = 16;
+    static const size_t DEFAULT_BUDGET_BYTES = 256u << 20;
+
+    HistoryStore(int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL, size_t budgetBytes = DEFAULT_BUDGET_BYTES);
+
+    // Start over from grid, which is the state after step steps; false,
+    // leaving the store empty, if two frames of grid exceed the budget
+    bool reset(const std::vector<std::vector<Cell>> &grid, int step);
+
+    // Record the state after step steps as the changes since the last
+    // recorded state. changes is sorted and deduplicated in place.
+    void record(int step, std::vector<CellChange> &changes);
+
+    // Fold more changes into the newest recorded step, for work done after
+    // the step itself (such as deferred pollution)
+    void amend(std::vector<CellChange> &changes);
+
+    // Forget every step after step, which must be available
+    void truncate(int step);
+
+    // Binary image of the whole store, in native byte order; read replaces
+    // the contents and returns false for a damaged image or one whose
+    // frames do not fit the budget
+    void write(std::ostream &out) const;
+    bool read(std::istream &in);
+
+    // Steps are counted like Simulation::getStepCount(); 0 is the loaded layout
+    bool hasStep(int step) const { return step >= getOldestStep() && step <= newestStep; }
+    int getOldestStep() const { return keyframes.empty() ? 0 : keyframes.front().step; }
+    int getNewestStep() const { return newestStep; }
+    size_t getMemoryBytes() const { return memoryBytes; }
+
+    // Rebuild the grid as it was after step steps; false if not available
+    bool restore(int step, std::vector<std::vector<Cell>> &grid) const;
+
+    // Same contract as Simulation::analyzeArea, at a past step; false if
+    // the step is not available or the area is not inside the region
+    bool analyzeArea(int step, int x1, int y1, int x2, int y2, AreaStats &stats) const;
+
+private:
+    struct Frame
+    {
+        std::vector<char> types;
+        std::vector<uint8_t> population;
+        std::vector<uint16_t> pollution;
+    };
+
+    struct Keyframe
+    {
+        int step;
+        Frame frame;
+        std::vector<std::vector<uint8_t>> deltas; // deltas[i] leads to step + i + 1
+    };
+
+    static size_t frameBytes(const Frame &frame);
+    static void encode(const std::vector<CellChange> &changes, int width, std::vector<uint8_t> &out);
+    static void apply(const std::vector<uint8_t> &delta, Frame &frame);
+    static void decode(const std::vector<uint8_t> &delta, int width, std::vector<CellChange> &out);
+    void normalize(std::vector<CellChange> &changes) const;
+    bool restoreFrame(int step, Frame &frame) const;
+    void enforceBudget();
+
+    int width, height;
+    int keyframeInterval;
+    size_t budgetBytes;
+    size_t memoryBytes; // Keyframes, deltas and current
+    int newestStep;
+    Frame current; // State after newestStep, kept up to date for the next keyframe
+    std::deque<Keyframe> keyframes;
+};
+
+#endif // HISTORY_STORE_H
@@ -0,0 +1,199 @@
+// LandValue.cpp
+#include "LandValue.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <thread>
+
+const int LandValue::COMMERCIAL_REACH;
+const int LandValue::ROAD_REACH;
+const int LandValue::MAX_LOCAL_EDITS;
+
+// Areas smaller than this are computed on the calling thread only
+static const long long PARALLEL_CELLS = 1 << 16;
+
+// Run body(begin, end) over [begin, end) split into one slice per thread
+template <typename Body>
+static void parallelFor(int threads, int begin, int end, Body body)
+{
+    if (threads <= 1 || end - begin < threads)
+    {
+        body(begin, end);
+        return;
+    }
+    std::vector<std::thread> workers;
+    int slice = (end - begin + threads - 1) / threads;
+    for (int start = begin + slice; start < end; start += slice)
+        workers.emplace_back(body, start, std::min(end, start + slice));
+    body(begin, std::min(end, begin + slice));
+    for (auto &worker : workers)
+        worker.join();
+}
+
+LandValue::LandValue(int minimumValue, int threads)
+    : minimumValue(minimumValue), threads(threads > 0 ? threads : 1), stale(true), width(0), height(0) {}
+
+void LandValue::cellChanged(int x, int y)
+{
+    if (stale)
+        return;
+    if (pendingEdits.size() >= static_cast<size_t>(MAX_LOCAL_EDITS))
+    {
+        stale = true;
+        pendingEdits.clear();
+        return;
+    }
+    pendingEdits.push_back(y * width + x);
+}
+
+void LandValue::refresh(const std::vector<std::vector<Cell>> &grid)
+{
+    if (stale)
+    {
+        PROFILE_SCOPE("LandValue::compute");
+        height = grid.size();
+        width = height > 0 ? grid[0].size() : 0;
+        nearness.assign(static_cast<size_t>(width) * height, 0);
+        compute(grid, 0, 0, width, height);
+        pendingEdits.clear();
+        stale = false;
+        return;
+    }
+
+    // An edit changes nearness only within reach of it
+    for (int cell : pendingEdits)
+    {
+        int x = cell % width;
+        int y = cell / width;
+        compute(grid, std::max(0, x - COMMERCIAL_REACH), std::max(0, y - COMMERCIAL_REACH),
+                std::min(width, x + COMMERCIAL_REACH + 1), std::min(height, y + COMMERCIAL_REACH + 1));
+    }
+    pendingEdits.clear();
+}
+
+void LandValue::compute(const std::vector<std::vector<Cell>> &grid, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; y++)
+        std::fill(nearness.begin() + static_cast<size_t>(y) * width + x0,
+                  nearness.begin() + static_cast<size_t>(y) * width + x1, 0);
+    addField(grid, true, COMMERCIAL_REACH, x0, y0, x1, y1);
+    addField(grid, false, ROAD_REACH, x0, y0, x1, y1);
+}
+
+// Add max(0, reach - distance to the nearest feature) to nearness over the
+// target rectangle. Features farther than reach do not matter, so the
+// search only looks reach cells beyond the rectangle and squared distances
+// are capped at reach * reach.
+void LandValue::addField(const std::vector<std::vector<Cell>> &grid, bool commercial, int reach,
+                         int x0, int y0, int x1, int y1)
+{
+    int sourceX0 = std::max(0, x0 - reach);
+    int sourceY0 = std::max(0, y0 - reach);
+    int sourceX1 = std::min(width, x1 + reach);
+    int sourceY1 = std::min(height, y1 + reach);
+    int sourceWidth = sourceX1 - sourceX0;
+    int cap = reach * reach;
+    int localThreads = static_cast<long long>(sourceWidth) * (sourceY1 - sourceY0) >= PARALLEL_CELLS ? threads : 1;
+    columnDistance.resize(static_cast<size_t>(sourceWidth) * (sourceY1 - sourceY0));
+
+    // Squared distances below cap are small integers, so the nearness of each is looked up
+    std::vector<uint8_t> nearnessOf(cap);
+    for (int squared = 0; squared < cap; squared++)
+        nearnessOf[squared] = static_cast<uint8_t>(std::lround(reach - std::sqrt(static_cast<double>(squared))));
+
+    auto isFeatureAt = [&](int x, int y)
+    {
+        char type = grid[y][x].getType();
+        return commercial ? type == 'C' : (type == '-' || type == '#');
+    };
+
+    // Pass 1: distance to the nearest feature in the same column, from
+    // above and then from below, in row-major order for locality
+    parallelFor(localThreads, sourceX0, sourceX1, [&](int columnBegin, int columnEnd)
+    {
+        std::vector<int> nearest(columnEnd - columnBegin);
+        std::fill(nearest.begin(), nearest.end(), INT_MIN / 2);
+        for (int y = sourceY0; y < sourceY1; y++)
+        {
+            uint16_t *row = &columnDistance[static_cast<size_t>(y - sourceY0) * sourceWidth];
+            for (int x = columnBegin; x < columnEnd; x++)
+            {
+                int &last = nearest[x - columnBegin];
+                if (isFeatureAt(x, y))
+                    last = y;
+                long long gap = y - last;
+                row[x - sourceX0] = static_cast<uint16_t>(std::min<long long>(cap, gap * gap));
+            }
+        }
+        std::fill(nearest.begin(), nearest.end(), INT_MAX / 2);
+        for (int y = sourceY1 - 1; y >= sourceY0; y--)
+        {
+            uint16_t *row = &columnDistance[static_cast<size_t>(y - sourceY0) * sourceWidth];
+            for (int x = columnBegin; x < columnEnd; x++)
+            {
+                uint16_t &distance = row[x - sourceX0];
+                int &next = nearest[x - columnBegin];
+                if (distance == 0)
+                    next = y;
+                long long gap = next - y;
+                distance = static_cast<uint16_t>(std::min<long long>(distance, gap * gap));
+            }
+        }
+    });
+
+    // Pass 2: per row, the lower envelope of the parabolas (x - q)^2 + f(q)
+    // over the column distances f gives the exact squared distance
+    parallelFor(localThreads, y0, y1, [&](int rowBegin, int rowEnd)
+    {
+        std::vector<int> vertex(sourceWidth);
+        std::vector<double> boundary(sourceWidth + 1);
+        for (int y = rowBegin; y < rowEnd; y++)
+        {
+            const uint16_t *row = &columnDistance[static_cast<size_t>(y - sourceY0) * sourceWidth];
+            auto f = [&](int q) { return static_cast<int>(row[q - sourceX0]); };
+            int k = -1;
+            for (int q = sourceX0; q < sourceX1; q++)
+            {
+                if (f(q) >= cap)
+                    continue;
+                if (k < 0)
+                {
+                    k = 0;
+                    vertex[0] = q;
+                    boundary[0] = -1e300;
+                    boundary[1] = 1e300;
+                    continue;
+                }
+                // boundary[0] is below any intersection, so k stays >= 0
+                double s;
+                while (true)
+                {
+                    int p = vertex[k];
+                    s = ((f(q) + static_cast<double>(q) * q) - (f(p) + static_cast<double>(p) * p)) / (2.0 * (q - p));
+                    if (s > boundary[k])
+                        break;
+                    k--;
+                }
+                k++;
+                vertex[k] = q;
+                boundary[k] = s;
+                boundary[k + 1] = 1e300;
+            }
+            if (k < 0)
+                continue;
+
+            uint8_t *out = &nearness[static_cast<size_t>(y) * width];
+            int segment = 0;
+            for (int x = x0; x < x1; x++)
+            {
+                while (boundary[segment + 1] < x)
+                    segment++;
+                long long offset = x - vertex[segment];
+                long long squared = offset * offset + f(vertex[segment]);
+                if (squared < cap)
+                    out[x] += nearnessOf[squared];
+            }
+        }
+    });
+}
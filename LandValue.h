@@ -0,0 +1,70 @@
+// LandValue.h
+// Land value of every cell: nearness to commercial zones and to roads,
+// minus the cell's pollution. Nearness depends only on cell types, so it is
+// kept as one byte per cell and computed with exact linear-time Euclidean
+// distance transforms (Felzenszwalb and Huttenlocher); after an edit only
+// the cells within reach of it are recomputed. Pollution is read from the
+// grid whenever a value is asked for, so it never goes stale.
+#ifndef LAND_VALUE_H
+#define LAND_VALUE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Cell.h"
+
+class LandValue
+{
+public:
+    // Nearness falls off by one per cell of distance, to 0 at these distances
+    static const int COMMERCIAL_REACH = 16;
+    static const int ROAD_REACH = 8;
+
+    // More pending edits than this recompute the whole map instead
+    static const int MAX_LOCAL_EDITS = 64;
+
+    static bool isFeature(char type) { return type == 'C' || type == '-' || type == '#'; }
+
+    LandValue(int minimumValue, int threads = 1);
+
+    int getMinimumValue() const { return minimumValue; }
+
+    // Recompute the nearness of every cell at the next refresh
+    void invalidate() { stale = true; }
+
+    // The type of the cell at (x, y) changed to or from a feature type
+    void cellChanged(int x, int y);
+
+    // Bring nearness up to date with the grid's cell types
+    void refresh(const std::vector<std::vector<Cell>> &grid);
+
+    int getNearness(int x, int y) const { return nearness[static_cast<size_t>(y) * width + x]; }
+    int getValue(const std::vector<std::vector<Cell>> &grid, int x, int y) const
+    {
+        return getNearness(x, y) - grid[y][x].getPollution();
+    }
+
+    // Growth condition used by the zone systems' canGrow
+    bool allowsGrowth(const std::vector<std::vector<Cell>> &grid, int x, int y) const
+    {
+        return getValue(grid, x, y) >= minimumValue;
+    }
+
+private:
+    // Recompute nearness for cells in [x0, x1) x [y0, y1)
+    void compute(const std::vector<std::vector<Cell>> &grid, int x0, int y0, int x1, int y1);
+    void addField(const std::vector<std::vector<Cell>> &grid, bool commercial, int reach,
+                  int x0, int y0, int x1, int y1);
+
+    int minimumValue;
+    int threads;
+    bool stale;
+    int width, height;
+    std::vector<uint8_t> nearness;
+    std::vector<int> pendingEdits; // Row-major cell indices
+
+    // Squared distances along columns, for the rectangle being computed
+    std::vector<uint16_t> columnDistance;
+};
+
+#endif // LAND_VALUE_H
@@ -0,0 +1,102 @@
+// Layout.cpp
+#include "Layout.h"
+#include "Region.h"
+
+const int Layout::NEIGHBOUR_DX[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+const int Layout::NEIGHBOUR_DY[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+std::shared_ptr<const Layout> Layout::fromGrid(const std::vector<std::vector<Cell>> &grid)
+{
+    std::shared_ptr<Layout> layout(new Layout());
+    if (grid.empty() || grid[0].empty())
+        return layout;
+
+    layout->height = grid.size();
+    layout->width = grid[0].size();
+    int width = layout->width;
+    int height = layout->height;
+    int cellCount = width * height;
+
+    layout->types.resize(cellCount);
+    layout->powered.assign(cellCount, 0);
+    layout->sameTypeNeighbours.assign(cellCount, 0);
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            layout->types[y * width + x] = grid[y][x].getType();
+        }
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int index = y * width + x;
+            char type = layout->types[index];
+
+            for (int k = 0; k < 8; k++)
+            {
+                int newX = x + NEIGHBOUR_DX[k];
+                int newY = y + NEIGHBOUR_DY[k];
+                if (newX < 0 || newX >= width || newY < 0 || newY >= height)
+                    continue;
+
+                char neighbour = layout->types[newY * width + newX];
+                if (neighbour == 'T' || neighbour == '#' || neighbour == 'P')
+                    layout->powered[index] = 1;
+                if (neighbour == type)
+                    layout->sameTypeNeighbours[index] |= (1 << k);
+            }
+
+            switch (type)
+            {
+            case 'R':
+                layout->residential.push_back(index);
+                break;
+            case 'C':
+                layout->commercial.push_back(index);
+                break;
+            case 'I':
+                layout->industrial.push_back(index);
+                break;
+            case 'P':
+                layout->plants.push_back(index);
+                break;
+            }
+        }
+    }
+
+    return layout;
+}
+
+std::shared_ptr<const Layout> Layout::load(const std::string &filename)
+{
+    Region region;
+    if (!region.loadFromFile(filename))
+        return nullptr;
+    return fromGrid(region.getGrid());
+}
+
+const std::vector<int> &Layout::getZoneCells(char type) const
+{
+    static const std::vector<int> none;
+    switch (type)
+    {
+    case 'R':
+        return residential;
+    case 'C':
+        return commercial;
+    case 'I':
+        return industrial;
+    default:
+        return none;
+    }
+}
+
+size_t Layout::getMemoryBytes() const
+{
+    return sizeof(Layout) + types.capacity() + powered.capacity() + sameTypeNeighbours.capacity() +
+           (residential.capacity() + commercial.capacity() + industrial.capacity() + plants.capacity()) * sizeof(int);
+}
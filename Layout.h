@@ -0,0 +1,56 @@
+// Layout.h
+// Immutable static data of a region: cell types, power coverage and the
+// same-type neighbour topology. A layout is built once per region file and
+// shared read-only by any number of simulation states.
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "Cell.h"
+
+class Layout
+{
+public:
+    // Neighbour offsets in the order used by the neighbour masks
+    static const int NEIGHBOUR_DX[8];
+    static const int NEIGHBOUR_DY[8];
+
+    static std::shared_ptr<const Layout> fromGrid(const std::vector<std::vector<Cell>> &grid);
+    static std::shared_ptr<const Layout> load(const std::string &filename);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getCellCount() const { return width * height; }
+    int indexOf(int x, int y) const { return y * width + x; }
+
+    char getType(int index) const { return types[index]; }
+    bool isPowered(int index) const { return powered[index] != 0; }
+
+    // Bit k is set when neighbour k exists and has the same zone type
+    uint8_t getSameTypeNeighbours(int index) const { return sameTypeNeighbours[index]; }
+    int neighbourIndex(int index, int k) const { return index + NEIGHBOUR_DY[k] * width + NEIGHBOUR_DX[k]; }
+
+    // Zone cells of one type ('R', 'C' or 'I') in row-major order
+    const std::vector<int> &getZoneCells(char type) const;
+    const std::vector<int> &getPlants() const { return plants; }
+
+    size_t getMemoryBytes() const;
+
+private:
+    Layout() : width(0), height(0) {}
+
+    int width, height;
+    std::vector<char> types;
+    std::vector<uint8_t> powered;
+    std::vector<uint8_t> sameTypeNeighbours;
+    std::vector<int> residential;
+    std::vector<int> commercial;
+    std::vector<int> industrial;
+    std::vector<int> plants;
+};
+
+#endif // LAYOUT_H
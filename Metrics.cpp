@@ -0,0 +1,274 @@
+// Metrics.cpp
+#include "Metrics.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+const int Metrics::LATENCY_BUCKETS;
+const double Metrics::LATENCY_BOUNDS[LATENCY_BUCKETS] = {
+    0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+    0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+Metrics::Metrics()
+    : steps(0), valuesChanged(0), latencySumNs(0), step(0), pollution(0),
+      workers(0), workersUsed(0), goods(0), goodsUsed(0)
+{
+    for (auto &count : latencyCounts)
+        count.store(0, std::memory_order_relaxed);
+    for (auto &value : population)
+        value.store(0, std::memory_order_relaxed);
+    for (auto &count : engineSteps)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void Metrics::recordStep(const Simulation &simulation, const StepSummary &summary)
+{
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    double seconds = summary.durationNs / 1e9;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS && seconds > LATENCY_BOUNDS[bucket])
+        bucket++;
+
+    // Single writer, so plain load and store instead of read-modify-write
+    latencyCounts[bucket].store(latencyCounts[bucket].load(relaxed) + 1, relaxed);
+    latencySumNs.store(latencySumNs.load(relaxed) + summary.durationNs, relaxed);
+    valuesChanged.store(valuesChanged.load(relaxed) + summary.changes, relaxed);
+    int engine = summary.engine == ENGINE_SPARSE ? 1 : 0;
+    engineSteps[engine].store(engineSteps[engine].load(relaxed) + 1, relaxed);
+    step.store(summary.step, relaxed);
+    population[0].store(simulation.getTotalPopulation('R'), relaxed);
+    population[1].store(simulation.getTotalPopulation('I'), relaxed);
+    population[2].store(simulation.getTotalPopulation('C'), relaxed);
+    pollution.store(simulation.getTotalPollution(), relaxed);
+    workers.store(summary.workers, relaxed);
+    workersUsed.store(summary.workersUsed, relaxed);
+    goods.store(summary.goods, relaxed);
+    goodsUsed.store(summary.goodsUsed, relaxed);
+    steps.store(steps.load(relaxed) + 1, relaxed);
+}
+
+static void writeMetric(std::ostream &out, const char *name, const char *type, const char *help)
+{
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+void Metrics::writePrometheus(std::ostream &out) const
+{
+    const std::memory_order relaxed = std::memory_order_relaxed;
+
+    // Scrapers derive the step rate from the counter, e.g. rate(simcity_steps_total[1m])
+    writeMetric(out, "simcity_steps_total", "counter", "Time steps simulated.");
+    out << "simcity_steps_total " << steps.load(relaxed) << "\n";
+    writeMetric(out, "simcity_step", "gauge", "Index of the last step.");
+    out << "simcity_step " << step.load(relaxed) << "\n";
+
+    writeMetric(out, "simcity_step_duration_seconds", "histogram", "Wall time per step.");
+    long long cumulative = 0;
+    for (int bucket = 0; bucket <= LATENCY_BUCKETS; bucket++)
+    {
+        cumulative += latencyCounts[bucket].load(relaxed);
+        out << "simcity_step_duration_seconds_bucket{le=\"";
+        if (bucket < LATENCY_BUCKETS)
+            out << LATENCY_BOUNDS[bucket];
+        else
+            out << "+Inf";
+        out << "\"} " << cumulative << "\n";
+    }
+    out << "simcity_step_duration_seconds_sum " << latencySumNs.load(relaxed) / 1e9 << "\n";
+    out << "simcity_step_duration_seconds_count " << cumulative << "\n";
+
+    writeMetric(out, "simcity_engine_steps_total", "counter", "Time steps simulated by each step engine.");
+    out << "simcity_engine_steps_total{engine=\"reference\"} " << engineSteps[0].load(relaxed) << "\n";
+    out << "simcity_engine_steps_total{engine=\"sparse\"} " << engineSteps[1].load(relaxed) << "\n";
+
+    writeMetric(out, "simcity_values_changed_total", "counter", "Population and pollution values changed.");
+    out << "simcity_values_changed_total " << valuesChanged.load(relaxed) << "\n";
+
+    writeMetric(out, "simcity_population", "gauge", "Population by zone type.");
+    out << "simcity_population{type=\"residential\"} " << population[0].load(relaxed) << "\n";
+    out << "simcity_population{type=\"industrial\"} " << population[1].load(relaxed) << "\n";
+    out << "simcity_population{type=\"commercial\"} " << population[2].load(relaxed) << "\n";
+    writeMetric(out, "simcity_pollution", "gauge", "Total pollution.");
+    out << "simcity_pollution " << pollution.load(relaxed) << "\n";
+
+    int workerSupply = workers.load(relaxed);
+    int goodsSupply = goods.load(relaxed);
+    writeMetric(out, "simcity_workers", "gauge", "Workers available at the start of the last step.");
+    out << "simcity_workers " << workerSupply << "\n";
+    writeMetric(out, "simcity_workers_used", "gauge", "Workers taken by growth in the last step.");
+    out << "simcity_workers_used " << workersUsed.load(relaxed) << "\n";
+    writeMetric(out, "simcity_worker_utilization", "gauge", "Fraction of workers used in the last step.");
+    out << "simcity_worker_utilization "
+        << (workerSupply > 0 ? static_cast<double>(workersUsed.load(relaxed)) / workerSupply : 0.0) << "\n";
+    writeMetric(out, "simcity_goods", "gauge", "Goods available at the start of the last step.");
+    out << "simcity_goods " << goodsSupply << "\n";
+    writeMetric(out, "simcity_goods_used", "gauge", "Goods taken by growth in the last step.");
+    out << "simcity_goods_used " << goodsUsed.load(relaxed) << "\n";
+    writeMetric(out, "simcity_goods_utilization", "gauge", "Fraction of goods used in the last step.");
+    out << "simcity_goods_utilization "
+        << (goodsSupply > 0 ? static_cast<double>(goodsUsed.load(relaxed)) / goodsSupply : 0.0) << "\n";
+}
+
+MetricsExporter::MetricsExporter(const Metrics &metrics)
+    : metrics(metrics), intervalMs(1000), listenFd(-1), stopping(false) {}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::startFile(const std::string &newFilename, int newIntervalMs)
+{
+    filename = newFilename;
+    intervalMs = newIntervalMs > 0 ? newIntervalMs : 1;
+    if (!writeFile())
+    {
+        std::cerr << "Error: Cannot write metrics file: " << filename << std::endl;
+        return false;
+    }
+    stopping = false;
+    thread = std::thread(&MetricsExporter::runFile, this);
+    return true;
+}
+
+bool MetricsExporter::startServer(int port)
+{
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listenFd, 16) != 0)
+    {
+        std::cerr << "Error: Cannot serve metrics on port " << port << ": " << std::strerror(errno) << std::endl;
+        if (listenFd >= 0)
+            ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    stopping = false;
+    thread = std::thread(&MetricsExporter::runServer, this);
+    return true;
+}
+
+bool MetricsExporter::startFromEnvironment()
+{
+    const char *file = std::getenv("SIMCITY_METRICS_FILE");
+    const char *port = std::getenv("SIMCITY_METRICS_PORT");
+    if (file && *file)
+        return startFile(file, 1000);
+    if (port && *port)
+        return startServer(std::atoi(port));
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if (!thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (listenFd >= 0)
+        shutdown(listenFd, SHUT_RDWR); // Wakes the server thread in accept()
+    thread.join();
+
+    if (listenFd >= 0)
+    {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+    else
+    {
+        writeFile();
+    }
+}
+
+std::string MetricsExporter::render()
+{
+    std::ostringstream out;
+    metrics.writePrometheus(out);
+    return out.str();
+}
+
+// Write a temporary file and rename it, so scrapers never see a partial file
+bool MetricsExporter::writeFile()
+{
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream out(temporary);
+        if (!out)
+            return false;
+        out << render();
+        if (!out)
+            return false;
+    }
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+void MetricsExporter::runFile()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this] { return stopping; }))
+    {
+        lock.unlock();
+        writeFile();
+        lock.lock();
+    }
+}
+
+void MetricsExporter::runServer()
+{
+    while (true)
+    {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return; // Shut down by stop()
+        }
+
+        // The request itself does not matter; read it so the client sees a clean close
+        timeval timeout = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        recv(fd, request, sizeof(request), 0);
+
+        std::string body = render();
+        std::ostringstream response;
+        response << "HTTP/1.1 200 OK\r\n"
+                 << "Content-Type: text/plain; version=0.0.4\r\n"
+                 << "Content-Length: " << body.size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body;
+        std::string text = response.str();
+        const char *next = text.data();
+        size_t left = text.size();
+        while (left > 0)
+        {
+            ssize_t written = send(fd, next, left, MSG_NOSIGNAL);
+            if (written <= 0)
+                break;
+            next += written;
+            left -= written;
+        }
+        ::close(fd);
+    }
+}
@@ -0,0 +1,84 @@
+// Metrics.h
+// Live health and throughput numbers for long runs, in Prometheus text
+// format. The stepping thread records each step with a handful of relaxed
+// atomic stores; a MetricsExporter thread periodically writes the numbers
+// to a file (for a textfile collector) or serves them over HTTP on a local
+// port. Readers may see values from two adjacent steps mixed, which is
+// fine for monitoring.
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Simulation.h"
+
+class Metrics
+{
+public:
+    // Upper bounds of the step latency histogram buckets, in seconds
+    static const int LATENCY_BUCKETS = 19;
+    static const double LATENCY_BOUNDS[LATENCY_BUCKETS];
+
+    Metrics();
+
+    // Stepping thread, after each step
+    void recordStep(const Simulation &simulation, const StepSummary &summary);
+
+    long long getSteps() const { return steps.load(std::memory_order_relaxed); }
+
+    void writePrometheus(std::ostream &out) const;
+
+private:
+    std::atomic<long long> steps;
+    std::atomic<long long> valuesChanged;
+    std::atomic<long long> latencyCounts[LATENCY_BUCKETS + 1]; // Last one is +Inf
+    std::atomic<long long> latencySumNs;
+    std::atomic<long long> engineSteps[2]; // Reference, sparse
+    std::atomic<int> step;
+    std::atomic<int> population[3]; // Residential, industrial, commercial
+    std::atomic<int> pollution;
+    std::atomic<int> workers, workersUsed;
+    std::atomic<int> goods, goodsUsed;
+};
+
+class MetricsExporter
+{
+public:
+    explicit MetricsExporter(const Metrics &metrics);
+    ~MetricsExporter();
+
+    // Rewrite filename every intervalMs; the file is replaced atomically
+    bool startFile(const std::string &filename, int intervalMs);
+
+    // Answer HTTP requests for any path on 127.0.0.1:port
+    bool startServer(int port);
+
+    // SIMCITY_METRICS_FILE or SIMCITY_METRICS_PORT, if set; true if neither
+    // is set or the export started
+    bool startFromEnvironment();
+
+    // Stop the export; a file gets one final write first
+    void stop();
+
+private:
+    void runFile();
+    void runServer();
+    bool writeFile();
+    std::string render();
+
+    const Metrics &metrics;
+    std::thread thread;
+    std::string filename;
+    int intervalMs;
+    int listenFd;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,189 @@
+// MonteCarlo.cpp
+#include "MonteCarlo.h"
+#include "SweepRunner.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <thread>
+#include <atomic>
+
+void CellMoments::resize(int cells)
+{
+    sum.assign(cells, 0);
+    sumSquares.assign(cells, 0);
+}
+
+void CellMoments::add(int index, int value)
+{
+    sum[index] += value;
+    sumSquares[index] += static_cast<long long>(value) * value;
+}
+
+void CellMoments::merge(const CellMoments &other)
+{
+    for (size_t i = 0; i < sum.size(); i++)
+    {
+        sum[i] += other.sum[i];
+        sumSquares[i] += other.sumSquares[i];
+    }
+}
+
+double CellMoments::mean(int index, int runs) const
+{
+    return runs > 0 ? static_cast<double>(sum[index]) / runs : 0.0;
+}
+
+double CellMoments::variance(int index, int runs) const
+{
+    if (runs < 2)
+        return 0.0;
+    // n * sum(x^2) - sum(x)^2 is exact in integers, so no cancellation error
+    double spread = static_cast<double>(runs * sumSquares[index] - sum[index] * sum[index]);
+    return spread / (static_cast<double>(runs) * (runs - 1));
+}
+
+MonteCarloRunner::MonteCarloRunner(std::shared_ptr<const Layout> layout) : layout(layout) {}
+
+MonteCarloResult MonteCarloRunner::run(const MonteCarloParams &params) const
+{
+    int cells = layout->getCellCount();
+    int seeds = params.seeds > 0 ? params.seeds : 0;
+    int threadCount = params.threads < 1 ? 1 : params.threads;
+    if (threadCount > seeds)
+        threadCount = seeds > 0 ? seeds : 1;
+
+    MonteCarloResult result;
+    result.runs = seeds;
+    result.population.resize(cells);
+    result.pollution.resize(cells);
+    result.residentialTotals.assign(seeds, 0);
+    result.industrialTotals.assign(seeds, 0);
+    result.commercialTotals.assign(seeds, 0);
+    result.pollutionTotals.assign(seeds, 0);
+    result.stepsTaken.assign(seeds, 0);
+
+    // Each thread owns its sums; thread 0 uses the result's directly
+    std::vector<CellMoments> populationSums(threadCount - 1);
+    std::vector<CellMoments> pollutionSums(threadCount - 1);
+    std::atomic<int> next(0);
+
+    auto worker = [&](int thread)
+    {
+        CellMoments &population = thread == 0 ? result.population : populationSums[thread - 1];
+        CellMoments &pollution = thread == 0 ? result.pollution : pollutionSums[thread - 1];
+        if (thread > 0)
+        {
+            population.resize(cells);
+            pollution.resize(cells);
+        }
+
+        StepScratch scratch;
+        for (int run = next++; run < seeds; run = next++)
+        {
+            RuleParams rules = params.rules;
+            rules.seed = params.firstSeed + run;
+            VariantState state(layout->getWidth(), layout->getHeight());
+
+            int timeStep = 0;
+            bool hasChanged = true;
+            while (timeStep < params.maxTimeSteps && hasChanged)
+            {
+                hasChanged = StepKernel<VariantState>::step(*layout, state, rules, timeStep, scratch);
+                timeStep++;
+            }
+
+            int totalPollution = 0;
+            for (int index = 0; index < cells; index++)
+            {
+                int pop = state.getPopulation(index);
+                int pol = state.getPollution(index);
+                population.add(index, pop);
+                pollution.add(index, pol);
+                totalPollution += pol;
+                switch (layout->getType(index))
+                {
+                case 'R':
+                    result.residentialTotals[run] += pop;
+                    break;
+                case 'I':
+                    result.industrialTotals[run] += pop;
+                    break;
+                case 'C':
+                    result.commercialTotals[run] += pop;
+                    break;
+                }
+            }
+            result.pollutionTotals[run] = totalPollution;
+            result.stepsTaken[run] = timeStep;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++)
+        threads.emplace_back(worker, t);
+    worker(0);
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int t = 1; t < threadCount; t++)
+    {
+        result.population.merge(populationSums[t - 1]);
+        result.pollution.merge(pollutionSums[t - 1]);
+    }
+    return result;
+}
+
+bool MonteCarloRunner::writeMaps(const std::string &filename, const MonteCarloResult &result) const
+{
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cerr << "Error: Cannot write '" << filename << "'" << std::endl;
+        return false;
+    }
+
+    out << "x,y,type,population_mean,population_variance,pollution_mean,pollution_variance\n";
+    out << std::setprecision(6);
+    for (int y = 0; y < layout->getHeight(); y++)
+    {
+        for (int x = 0; x < layout->getWidth(); x++)
+        {
+            int index = layout->indexOf(x, y);
+            out << x << "," << y << "," << layout->getType(index) << ","
+                << result.population.mean(index, result.runs) << ","
+                << result.population.variance(index, result.runs) << ","
+                << result.pollution.mean(index, result.runs) << ","
+                << result.pollution.variance(index, result.runs) << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+// Mean and sample standard deviation of one total, accumulated in seed order
+static void displayTotal(const char *label, const std::vector<int> &totals)
+{
+    double mean = 0.0;
+    double squares = 0.0;
+    for (size_t i = 0; i < totals.size(); i++)
+    {
+        double delta = totals[i] - mean;
+        mean += delta / (i + 1);
+        squares += delta * (totals[i] - mean);
+    }
+    double deviation = totals.size() > 1 ? std::sqrt(squares / (totals.size() - 1)) : 0.0;
+    std::cout << std::setw(20) << std::left << label << std::right
+              << std::setw(12) << mean << " +/- " << deviation << std::endl;
+}
+
+void MonteCarloRunner::displaySummary(const MonteCarloResult &result) const
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Runs: " << result.runs << std::endl;
+    displayTotal("Steps:", result.stepsTaken);
+    displayTotal("Residential:", result.residentialTotals);
+    displayTotal("Industrial:", result.industrialTotals);
+    displayTotal("Commercial:", result.commercialTotals);
+    displayTotal("Pollution:", result.pollutionTotals);
+    std::cout.unsetf(std::ios::fixed);
+}
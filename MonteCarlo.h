@@ -0,0 +1,69 @@
+// MonteCarlo.h
+// Runs one region under stochastic growth for many seeds and aggregates
+// per-cell mean and variance maps of population and pollution. Worker
+// threads take seeds from a shared counter and fold each finished run into
+// their own integer sums, so memory does not grow with the number of seeds.
+// The sums are exact, which makes the result independent of the thread
+// count and of the order in which seeds finish.
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "Layout.h"
+#include "StepKernel.h"
+
+struct MonteCarloParams
+{
+    int maxTimeSteps = 100;
+    RuleParams rules;     // rules.seed is ignored; each run uses its own seed
+    uint64_t firstSeed = 1;
+    int seeds = 100;      // Runs use firstSeed .. firstSeed + seeds - 1
+    int threads = 4;
+};
+
+// Running sums for one value per cell
+struct CellMoments
+{
+    std::vector<long long> sum;
+    std::vector<long long> sumSquares;
+
+    void resize(int cells);
+    void add(int index, int value);
+    void merge(const CellMoments &other);
+    double mean(int index, int runs) const;
+    double variance(int index, int runs) const; // Sample variance, 0 for a single run
+};
+
+struct MonteCarloResult
+{
+    int runs = 0;
+    CellMoments population;
+    CellMoments pollution;
+
+    // Region totals of every run, in seed order
+    std::vector<int> residentialTotals;
+    std::vector<int> industrialTotals;
+    std::vector<int> commercialTotals;
+    std::vector<int> pollutionTotals;
+    std::vector<int> stepsTaken;
+};
+
+class MonteCarloRunner
+{
+public:
+    explicit MonteCarloRunner(std::shared_ptr<const Layout> layout);
+
+    MonteCarloResult run(const MonteCarloParams &params) const;
+
+    // One row per cell: x,y,type,population mean and variance, pollution mean and variance
+    bool writeMaps(const std::string &filename, const MonteCarloResult &result) const;
+    void displaySummary(const MonteCarloResult &result) const;
+
+private:
+    std::shared_ptr<const Layout> layout;
+};
+
+#endif // MONTE_CARLO_H
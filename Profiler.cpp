@@ -0,0 +1,227 @@
+// Profiler.cpp
+#include "Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+thread_local std::vector<Profiler::Event> Profiler::events;
+thread_local std::vector<Profiler::StepCounters> Profiler::stepCounters;
+thread_local std::vector<Profiler::ScopeTotals> Profiler::totals;
+thread_local long long Profiler::counters[COUNTER_COUNT] = {};
+thread_local long long Profiler::stepStartAllocations = 0;
+thread_local long long Profiler::originNs = 0;
+thread_local int Profiler::currentStep = -1;
+thread_local size_t Profiler::droppedEvents = 0;
+
+// Allocations made by this thread
+static thread_local long long heapAllocations = 0;
+
+// Programs only; a library must not replace its host's allocator
+#if !defined(SIMCITY_NO_PROFILING) && !defined(SIMCITY_LIBRARY)
+// Count every heap allocation made by the program
+void *operator new(std::size_t size)
+{
+    heapAllocations++;
+    if (void *pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+#endif
+
+static const char *COUNTER_NAMES[COUNTER_COUNT] = {
+    "candidates found", "cells grown", "workers consumed",
+    "goods consumed", "values changed", "allocations"};
+
+long long Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+long long Profiler::allocations()
+{
+    return heapAllocations;
+}
+
+void Profiler::reset()
+{
+    events.clear();
+    stepCounters.clear();
+    totals.clear();
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        counters[i] = 0;
+    droppedEvents = 0;
+    currentStep = -1;
+    events.reserve(1 << 16);
+    originNs = now();
+}
+
+void Profiler::beginStep(int step)
+{
+    currentStep = step;
+    stepStartAllocations = allocations();
+    StepCounters entry;
+    entry.step = step;
+    entry.timestampNs = 0;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        entry.values[i] = counters[i];
+    stepCounters.push_back(entry);
+}
+
+void Profiler::endStep()
+{
+    if (stepCounters.empty())
+        return;
+
+    counters[COUNTER_ALLOCATIONS] += allocations() - stepStartAllocations;
+
+    // Turn the snapshot taken in beginStep into this step's deltas
+    StepCounters &entry = stepCounters.back();
+    entry.timestampNs = now();
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        entry.values[i] = counters[i] - entry.values[i];
+    currentStep = -1;
+}
+
+void Profiler::count(ProfileCounter counter, long long amount)
+{
+    counters[counter] += amount;
+}
+
+void Profiler::record(const char *name, long long startNs, long long endNs, long long allocs)
+{
+    long long duration = endNs - startNs;
+
+    ScopeTotals *entry = nullptr;
+    for (auto &scope : totals)
+    {
+        if (scope.name == name || std::strcmp(scope.name, name) == 0)
+        {
+            entry = &scope;
+            break;
+        }
+    }
+    if (!entry)
+    {
+        totals.push_back({name, 0, 0, 0, 0});
+        entry = &totals.back();
+    }
+    entry->calls++;
+    entry->totalNs += duration;
+    entry->allocations += allocs;
+    if (duration > entry->maxNs)
+        entry->maxNs = duration;
+
+    if (events.size() < MAX_EVENTS)
+        events.push_back({name, startNs, duration, currentStep});
+    else
+        droppedEvents++;
+}
+
+void Profiler::displaySummary(std::ostream &out)
+{
+    if (totals.empty())
+        return;
+
+    out << "\nProfile Summary:" << std::endl;
+    out << std::left << std::setw(28) << "Scope" << std::right << std::setw(8) << "Calls"
+        << std::setw(14) << "Total ms" << std::setw(12) << "Mean us" << std::setw(12) << "Max us"
+        << std::setw(10) << "Allocs" << std::endl;
+    for (const auto &scope : totals)
+    {
+        out << std::left << std::setw(28) << scope.name << std::right << std::setw(8) << scope.calls
+            << std::fixed << std::setprecision(3)
+            << std::setw(14) << scope.totalNs / 1e6
+            << std::setw(12) << scope.totalNs / 1e3 / scope.calls
+            << std::setw(12) << scope.maxNs / 1e3
+            << std::setw(10) << scope.allocations << std::endl;
+    }
+    out.unsetf(std::ios::fixed);
+    out << std::setprecision(6);
+
+    out << "Counters:" << std::endl;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        out << "- " << COUNTER_NAMES[i] << ": " << counters[i] << std::endl;
+    if (droppedEvents > 0)
+        out << "(" << droppedEvents << " timer events not kept for the trace)" << std::endl;
+}
+
+void Profiler::displaySummaryFromEnvironment(std::ostream &out)
+{
+    const char *enabled = std::getenv("SIMCITY_PROFILE");
+    if (enabled && *enabled)
+        displaySummary(out);
+}
+
+bool Profiler::writeChromeTrace(const std::string &filename)
+{
+    std::ofstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot write trace file: " << filename << std::endl;
+        return false;
+    }
+
+    // Chrome trace timestamps are microseconds
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto &event : events)
+    {
+        file << (first ? "" : ",\n");
+        file << "{\"name\":\"" << event.name << "\",\"cat\":\"sim\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+             << ",\"ts\":" << (event.startNs - originNs) / 1e3
+             << ",\"dur\":" << event.durationNs / 1e3
+             << ",\"args\":{\"step\":" << event.step << "}}";
+        first = false;
+    }
+    for (const auto &entry : stepCounters)
+    {
+        file << (first ? "" : ",\n");
+        file << "{\"name\":\"step counters\",\"ph\":\"C\",\"pid\":1,\"tid\":1"
+             << ",\"ts\":" << (entry.timestampNs - originNs) / 1e3 << ",\"args\":{";
+        for (int i = 0; i < COUNTER_COUNT; i++)
+            file << (i ? "," : "") << "\"" << COUNTER_NAMES[i] << "\":" << entry.values[i];
+        file << "}}";
+        first = false;
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+void Profiler::exportTraceFromEnvironment()
+{
+    const char *filename = std::getenv("SIMCITY_TRACE");
+    if (filename && *filename && writeChromeTrace(filename))
+        std::cout << "Trace written to " << filename << std::endl;
+}
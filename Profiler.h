@@ -0,0 +1,124 @@
+// Profiler.h
+// Low-overhead instrumentation for the simulation loop: scoped phase timers,
+// per-step counters, heap allocation counts, a summary table and Chrome
+// trace-event JSON export (load the file in chrome://tracing or Perfetto).
+//
+// Use the PROFILE_* macros rather than the class directly. Building with
+// -DSIMCITY_NO_PROFILING removes every call site at compile time.
+// Every thread records into its own state, so simulations can step on
+// different threads at once; the summary and the trace show the recording
+// of the thread that asks for them.
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+enum ProfileCounter
+{
+    COUNTER_CANDIDATES,        // Cells that passed canGrow
+    COUNTER_CELLS_GROWN,       // Population increments applied
+    COUNTER_WORKERS_CONSUMED,  // Workers used by commercial/industrial growth
+    COUNTER_GOODS_CONSUMED,    // Goods used by commercial growth
+    COUNTER_VALUES_CHANGED,    // Population plus pollution values that changed
+    COUNTER_ALLOCATIONS,       // Heap allocations
+    COUNTER_COUNT
+};
+
+class Profiler
+{
+public:
+    static void reset();
+    static void beginStep(int step);
+    static void endStep();
+    static void count(ProfileCounter counter, long long amount);
+
+    // Scope bookkeeping used by ProfileScope
+    static long long now();
+    static long long allocations();
+    static void record(const char *name, long long startNs, long long endNs, long long allocs);
+
+    static void displaySummary(std::ostream &out);
+
+    // Print the summary only if the SIMCITY_PROFILE environment variable is set
+    static void displaySummaryFromEnvironment(std::ostream &out);
+    static bool writeChromeTrace(const std::string &filename);
+
+    // Write the trace if the SIMCITY_TRACE environment variable names a file
+    static void exportTraceFromEnvironment();
+
+    // Keep at most this many individual timer events for the trace
+    static const size_t MAX_EVENTS = 1000000;
+
+private:
+    struct Event
+    {
+        const char *name;
+        long long startNs;
+        long long durationNs;
+        int step;
+    };
+
+    struct StepCounters
+    {
+        long long timestampNs;
+        int step;
+        long long values[COUNTER_COUNT];
+    };
+
+    struct ScopeTotals
+    {
+        const char *name;
+        long long calls;
+        long long totalNs;
+        long long maxNs;
+        long long allocations;
+    };
+
+    static thread_local std::vector<Event> events;
+    static thread_local std::vector<StepCounters> stepCounters;
+    static thread_local std::vector<ScopeTotals> totals;
+    static thread_local long long counters[COUNTER_COUNT];
+    static thread_local long long stepStartAllocations;
+    static thread_local long long originNs;
+    static thread_local int currentStep;
+    static thread_local size_t droppedEvents;
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name)
+        : name(name), startNs(Profiler::now()), startAllocs(Profiler::allocations()) {}
+    ~ProfileScope() { Profiler::record(name, startNs, Profiler::now(), Profiler::allocations() - startAllocs); }
+
+private:
+    const char *name;
+    long long startNs;
+    long long startAllocs;
+};
+
+#ifndef SIMCITY_NO_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(counter, amount) Profiler::count(counter, amount)
+#define PROFILE_RESET() Profiler::reset()
+#define PROFILE_BEGIN_STEP(step) Profiler::beginStep(step)
+#define PROFILE_END_STEP() Profiler::endStep()
+#define PROFILE_SUMMARY(out) Profiler::displaySummary(out)
+#define PROFILE_SUMMARY_FROM_ENVIRONMENT(out) Profiler::displaySummaryFromEnvironment(out)
+#define PROFILE_EXPORT_TRACE() Profiler::exportTraceFromEnvironment()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#define PROFILE_RESET() ((void)0)
+#define PROFILE_BEGIN_STEP(step) ((void)0)
+#define PROFILE_END_STEP() ((void)0)
+#define PROFILE_SUMMARY(out) ((void)0)
+#define PROFILE_SUMMARY_FROM_ENVIRONMENT(out) ((void)0)
+#define PROFILE_EXPORT_TRACE() ((void)0)
+#endif
+
+#endif // PROFILER_H
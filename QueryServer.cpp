@@ -0,0 +1,190 @@
+// QueryServer.cpp
+#include "QueryServer.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+QueryServer::QueryServer(SnapshotPublisher &publisher)
+    : publisher(publisher), listenFd(-1), stopping(false), queriesServed(0) {}
+
+QueryServer::~QueryServer()
+{
+    stop();
+}
+
+bool QueryServer::start(const std::string &socketPath, int threadCount)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Error: Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    if (threadCount <= 0 || threadCount > SnapshotPublisher::MAX_READERS)
+    {
+        std::cerr << "Error: Query threads must be between 1 and " << SnapshotPublisher::MAX_READERS << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str()); // Left behind by an earlier run
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, 64) != 0)
+    {
+        std::cerr << "Error: Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listenFd >= 0)
+            ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    path = socketPath;
+    stopping = false;
+    for (int i = 0; i < threadCount; i++)
+        threads.emplace_back(&QueryServer::serve, this);
+    return true;
+}
+
+void QueryServer::stop()
+{
+    if (listenFd < 0)
+        return;
+
+    stopping = true;
+    shutdown(listenFd, SHUT_RDWR); // Wakes threads blocked in accept()
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (int fd : connections)
+            shutdown(fd, SHUT_RDWR);
+    }
+    for (auto &thread : threads)
+        thread.join();
+    threads.clear();
+
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(path.c_str());
+}
+
+void QueryServer::serve()
+{
+    int slot = publisher.registerReader();
+    while (!stopping)
+    {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            if (stopping)
+            {
+                ::close(fd);
+                break;
+            }
+            connections.insert(fd);
+        }
+        handleConnection(fd, slot);
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            connections.erase(fd);
+        }
+        ::close(fd);
+    }
+    publisher.unregisterReader(slot);
+}
+
+void QueryServer::handleConnection(int fd, int slot)
+{
+    std::string pending;
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return;
+        pending.append(buffer, received);
+
+        // Answer every complete line with a single write
+        std::string replies;
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != std::string::npos)
+        {
+            replies += answer(pending.substr(start, end - start), slot);
+            start = end + 1;
+        }
+        pending.erase(0, start);
+
+        const char *next = replies.data();
+        size_t left = replies.size();
+        while (left > 0)
+        {
+            ssize_t written = send(fd, next, left, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return;
+            next += written;
+            left -= written;
+        }
+    }
+}
+
+std::string QueryServer::answer(const std::string &request, int slot)
+{
+    std::istringstream in(request);
+    std::string command;
+    in >> command;
+
+    std::ostringstream out;
+    const Snapshot *snapshot = publisher.beginRead(slot);
+    if (!snapshot)
+    {
+        out << "ERR no snapshot published yet";
+    }
+    else if (command == "INFO")
+    {
+        out << "OK " << snapshot->getStep() << " " << snapshot->getWidth() << " " << snapshot->getHeight();
+    }
+    else if (command == "TOTALS")
+    {
+        out << "OK " << snapshot->getStep() << " " << snapshot->getTotalPopulation('R') << " "
+            << snapshot->getTotalPopulation('I') << " " << snapshot->getTotalPopulation('C') << " "
+            << snapshot->getTotalPollution() << " " << snapshot->getAvailableWorkers() << " "
+            << snapshot->getAvailableGoods();
+    }
+    else if (command == "AREA")
+    {
+        int x1, y1, x2, y2;
+        AreaStats stats;
+        if (!(in >> x1 >> y1 >> x2 >> y2))
+            out << "ERR usage: AREA x1 y1 x2 y2";
+        else if (!snapshot->analyzeArea(x1, y1, x2, y2, stats))
+            out << "ERR area outside region";
+        else
+            out << "OK " << snapshot->getStep() << " " << stats.residential << " " << stats.industrial << " "
+                << stats.commercial << " " << stats.pollution;
+    }
+    else
+    {
+        out << "ERR unknown command";
+    }
+    publisher.endRead(slot);
+
+    queriesServed.fetch_add(1, std::memory_order_relaxed);
+    out << "\n";
+    return out.str();
+}
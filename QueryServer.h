@@ -0,0 +1,50 @@
+// QueryServer.h
+// Answers area and total queries over a Unix domain socket from the
+// snapshots a SnapshotPublisher holds, while the simulation keeps stepping
+// in another thread. Each request is one line and gets one line back:
+//   INFO                  -> OK step width height
+//   TOTALS                -> OK step residential industrial commercial pollution workers goods
+//   AREA x1 y1 x2 y2      -> OK step residential industrial commercial pollution
+// Errors are answered with "ERR reason".
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <set>
+#include "Snapshot.h"
+
+class QueryServer
+{
+public:
+    explicit QueryServer(SnapshotPublisher &publisher);
+    ~QueryServer();
+
+    // Listen on socketPath with one thread per concurrently served
+    // connection; further connections wait to be accepted
+    bool start(const std::string &socketPath, int threads);
+    void stop();
+
+    long long getQueriesServed() const { return queriesServed.load(std::memory_order_relaxed); }
+
+private:
+    void serve();
+    void handleConnection(int fd, int slot);
+    std::string answer(const std::string &request, int slot);
+
+    SnapshotPublisher &publisher;
+    std::string path;
+    int listenFd;
+    std::atomic<bool> stopping;
+    std::atomic<long long> queriesServed;
+    std::vector<std::thread> threads;
+
+    // Open connections, so stop() can wake their threads
+    std::mutex connectionsMutex;
+    std::set<int> connections;
+};
+
+#endif // QUERY_SERVER_H
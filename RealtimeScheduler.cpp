@@ -0,0 +1,131 @@
+// RealtimeScheduler.cpp
+#include "RealtimeScheduler.h"
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+const int RealtimeScheduler::MAX_DEFERRED_TICKS;
+
+typedef std::chrono::steady_clock Clock;
+
+static long long nanosecondsBetween(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+static double percentileUs(const std::vector<long long> &sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = static_cast<size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index] / 1000.0;
+}
+
+// Moving average that follows changes in step cost within a few ticks
+static void track(double &estimate, long long sampleNs)
+{
+    estimate = estimate == 0.0 ? sampleNs : 0.75 * estimate + 0.25 * sampleNs;
+}
+
+void RealtimeReport::print(std::ostream &out) const
+{
+    out << "Real-time: " << ticks << " ticks, " << overruns << " overruns, " << missedTicks
+        << " missed ticks, " << deferredSteps << " steps with deferred pollution, " << catchUps
+        << " catch-ups\n";
+    out << "Tick jitter us: mean " << jitterMeanUs << "  p99 " << jitterP99Us << "  max " << jitterMaxUs << "\n";
+    out << "Step latency us: p50 " << latencyP50Us << "  p99 " << latencyP99Us << "  p99.9 " << latencyP999Us
+        << "  max " << latencyMaxUs << std::endl;
+}
+
+RealtimeScheduler::RealtimeScheduler(Simulation &simulation, double ticksPerSecond, double budgetShare)
+    : simulation(simulation)
+{
+    periodNs = static_cast<long long>(1e9 / (ticksPerSecond > 0 ? ticksPerSecond : 1));
+    budgetNs = static_cast<long long>(periodNs * (budgetShare > 0 ? budgetShare : 1));
+}
+
+RealtimeReport RealtimeScheduler::run(int maxSteps, const std::function<void(const StepSummary &)> &onStep)
+{
+    RealtimeReport report = {};
+    std::vector<long long> latencies;
+    std::vector<long long> jitters;
+    double growthEstimate = 0.0;    // Step time without pollution
+    double pollutionEstimate = 0.0; // Pollution update time
+    int deferredTicks = 0;
+
+    Clock::time_point tick = Clock::now();
+    bool finished = false;
+    while (!finished && report.ticks < maxSteps)
+    {
+        std::this_thread::sleep_until(tick);
+        Clock::time_point start = Clock::now();
+        Clock::time_point deadline = tick + std::chrono::nanoseconds(periodNs);
+        jitters.push_back(std::max(0LL, nanosecondsBetween(tick, start)));
+
+        // Degrade before overrunning, but never leave pollution stale for long
+        bool defer = growthEstimate + pollutionEstimate > budgetNs && deferredTicks < MAX_DEFERRED_TICKS;
+        simulation.setPollutionDeferred(defer);
+        StepSummary summary = simulation.step();
+        report.ticks++;
+        latencies.push_back(summary.durationNs);
+        track(growthEstimate, summary.durationNs - summary.pollutionNs);
+        if (summary.pollutionNs > 0)
+            track(pollutionEstimate, summary.pollutionNs);
+        if (simulation.isPollutionPending())
+        {
+            report.deferredSteps += defer ? 1 : 0;
+            deferredTicks++;
+        }
+        else
+        {
+            deferredTicks = 0;
+        }
+
+        finished = !summary.changed || summary.period > 0;
+
+        // Spare time in this tick goes to deferred pollution, before the
+        // step is reported so it shows the caught-up state
+        if (simulation.isPollutionPending() &&
+            (finished || report.ticks >= maxSteps || deferredTicks >= MAX_DEFERRED_TICKS ||
+             nanosecondsBetween(Clock::now(), deadline) > pollutionEstimate))
+        {
+            Clock::time_point catchUpStart = Clock::now();
+            summary.changes += simulation.catchUpPollution();
+            summary.hash = simulation.getStateHash();
+            summary.pollutionPending = false;
+            track(pollutionEstimate, nanosecondsBetween(catchUpStart, Clock::now()));
+            report.catchUps++;
+            deferredTicks = 0;
+        }
+        onStep(summary);
+
+        // After an overrun, resume at the next tick boundary still ahead
+        Clock::time_point now = Clock::now();
+        tick = deadline;
+        if (now > deadline)
+        {
+            report.overruns++;
+            while (tick < now)
+            {
+                tick += std::chrono::nanoseconds(periodNs);
+                report.missedTicks++;
+            }
+        }
+    }
+    simulation.setPollutionDeferred(false);
+
+    long long jitterSum = 0;
+    for (long long jitter : jitters)
+        jitterSum += jitter;
+    std::sort(jitters.begin(), jitters.end());
+    std::sort(latencies.begin(), latencies.end());
+    report.jitterMeanUs = jitters.empty() ? 0.0 : jitterSum / 1000.0 / jitters.size();
+    report.jitterP99Us = percentileUs(jitters, 99);
+    report.jitterMaxUs = jitters.empty() ? 0.0 : jitters.back() / 1000.0;
+    report.latencyP50Us = percentileUs(latencies, 50);
+    report.latencyP99Us = percentileUs(latencies, 99);
+    report.latencyP999Us = percentileUs(latencies, 99.9);
+    report.latencyMaxUs = latencies.empty() ? 0.0 : latencies.back() / 1000.0;
+    return report;
+}
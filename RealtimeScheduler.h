@@ -0,0 +1,52 @@
+// RealtimeScheduler.h
+// Runs a simulation at a fixed tick rate for live displays: one step per
+// tick, each measured against a budget that is a share of the tick period.
+// The cost of the next step is predicted from recent ones; when the full
+// step would overrun, its pollution update is deferred to a later tick
+// that has time to spare (at the latest MAX_DEFERRED_TICKS ticks later).
+// Ticks missed after an overrun are dropped rather than run back to back,
+// so a slow step delays the display once instead of freezing it.
+#ifndef REALTIME_SCHEDULER_H
+#define REALTIME_SCHEDULER_H
+
+#include <functional>
+#include <ostream>
+#include "Simulation.h"
+
+struct RealtimeReport
+{
+    int ticks;          // Ticks that ran a step
+    int overruns;       // Ticks whose work ran past the next tick
+    int missedTicks;    // Ticks dropped after overruns
+    int deferredSteps;  // Steps that left their pollution update for later
+    int catchUps;       // Deferred pollution updates run in spare time
+    double jitterMeanUs; // Lateness of tick starts
+    double jitterP99Us;
+    double jitterMaxUs;
+    double latencyP50Us; // Step latency
+    double latencyP99Us;
+    double latencyP999Us;
+    double latencyMaxUs;
+
+    void print(std::ostream &out) const;
+};
+
+class RealtimeScheduler
+{
+public:
+    static const int MAX_DEFERRED_TICKS = 8;
+
+    RealtimeScheduler(Simulation &simulation, double ticksPerSecond, double budgetShare = 0.8);
+
+    // Take up to maxSteps steps, one per tick, until the region stops
+    // changing or repeats. onStep runs inside the tick after each step and
+    // any catch-up; summary.pollutionPending marks steps still deferred.
+    RealtimeReport run(int maxSteps, const std::function<void(const StepSummary &)> &onStep);
+
+private:
+    Simulation &simulation;
+    long long periodNs;
+    long long budgetNs;
+};
+
+#endif // REALTIME_SCHEDULER_H
@@ -1,42 +1,56 @@
-#ifndef REGION_H
-#define REGION_H
-
-#include <vector>
-#include <string>
-#include <memory>
-#include "Cell.h"
-#include "ResidentialSystem.h"
-#include "CommercialSystem.h"
-#include "IndustrialSystem.h"
-#include "Statistics.h"
-
-class Region
-{
-private:
-    std::vector<std::vector<Cell>> grid;
-    int width, height;
-    int availableWorkers;
-    int availableGoods;
-    bool changed; // Track if the region changed during last update
-
-    // Helper functions
-    void updateResources();
-    bool hasChanges(const std::vector<std::vector<Cell>> &oldGrid) const;
-    void performTimeStep();
-
-public:
-    Region();
-    bool loadFromFile(const std::string &filename);
-    void displayState() const;
-    void simulate(int maxTimeSteps, int refreshRate);
-    void analyzeArea(int x1, int y1, int x2, int y2);
-    void displayFinalStats() const;
-
-    // Getters for testing/verification
-    int getWidth() const { return width; }
-    int getHeight() const { return height; }
-    int getAvailableWorkers() const { return availableWorkers; }
-    int getAvailableGoods() const { return availableGoods; }
-};
-
+#ifndef REGION_H
+#define REGION_H
+
+#include <vector>
+#include <string>
+#include "Cell.h"
+#include "ResidentialSystem.h"
+#include "CommercialSystem.h"
+#include "IndustrialSystem.h"
+#include "Statistics.h"
+#include "Simulation.h"
+
+// Console front end: loads a region, runs and prints a simulation, and
+// answers area queries. All stepping is done by the embedded Simulation.
+class Region
+{
+private:
+    Simulation simulation;
+
+    void displayGrid(const std::vector<std::vector<Cell>> &grid, int availableWorkers, int availableGoods) const;
+
+public:
+    static const int DEFAULT_CYCLE_WINDOW = Simulation::DEFAULT_CYCLE_WINDOW;
+
+    Region();
+    bool loadFromFile(const std::string &filename);
+    void displayState() const;
+    // ticksPerSecond > 0 paces the run at a fixed tick rate (see RealtimeScheduler)
+    void simulate(int maxTimeSteps, int refreshRate, double ticksPerSecond = 0);
+    // timeStep >= 0 analyzes the state shown as that time step during the run
+    void analyzeArea(int x1, int y1, int x2, int y2, int timeStep = -1);
+    void displayFinalStats() const;
+    void setCycleWindow(int steps) { simulation.setCycleWindow(steps); }
+    void setEngine(StepEngine newEngine) { simulation.setEngine(newEngine); }
+    StepEngine getEngine() const { return simulation.getEngine(); }
+    void setCommuteDistance(int maxDistance) { simulation.setCommuteDistance(maxDistance); }
+    void setMinimumLandValue(int minimumValue) { simulation.enableLandValue(minimumValue); }
+    static bool parseEngine(const std::string &name, StepEngine &result)
+    {
+        return Simulation::parseEngine(name, result);
+    }
+
+    Simulation &getSimulation() { return simulation; }
+    const Simulation &getSimulation() const { return simulation; }
+
+    // Getters for testing/verification
+    int getWidth() const { return simulation.getWidth(); }
+    int getHeight() const { return simulation.getHeight(); }
+    int getAvailableWorkers() const { return simulation.getAvailableWorkers(); }
+    int getAvailableGoods() const { return simulation.getAvailableGoods(); }
+    const std::vector<std::vector<Cell>> &getGrid() const { return simulation.getGrid(); }
+    uint64_t getStateHash() const { return simulation.getStateHash(); }
+    int getDetectedPeriod() const { return simulation.getDetectedPeriod(); }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+// RegionGenerator.cpp
+#include "RegionGenerator.h"
+#include "TileStore.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+    uint64_t splitmix64(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ULL;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t hashCell(uint64_t seed, int x, int y, uint64_t channel)
+    {
+        uint64_t h = splitmix64(seed ^ (channel << 56));
+        h = splitmix64(h ^ static_cast<uint32_t>(x));
+        return splitmix64(h ^ (static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32));
+    }
+
+    double toUnit(uint64_t value)
+    {
+        return (value >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Position of the line inside each spacing period
+    bool onLine(int coordinate, int spacing, int offset)
+    {
+        return spacing > 0 && coordinate % spacing == offset;
+    }
+}
+
+RegionGenerator::RegionGenerator(const GeneratorParams &params) : params(params)
+{
+    uint64_t state = splitmix64(params.seed ^ 0x504C414E54ULL);
+    int powerOffset = params.powerSpacing / 2;
+    int powerColumns = params.powerSpacing > 0 ? (params.width - powerOffset + params.powerSpacing - 1) / params.powerSpacing : 0;
+
+    for (int i = 0; i < params.plants; i++)
+    {
+        state = splitmix64(state);
+        int y = static_cast<int>(state % params.height);
+        state = splitmix64(state);
+        int x;
+        if (powerColumns > 0)
+            x = static_cast<int>(state % powerColumns) * params.powerSpacing + powerOffset;
+        else
+            x = static_cast<int>(state % params.width);
+        plantPositions.push_back({y, x});
+    }
+
+    std::sort(plantPositions.begin(), plantPositions.end());
+    plantPositions.erase(std::unique(plantPositions.begin(), plantPositions.end()), plantPositions.end());
+}
+
+bool RegionGenerator::validate(const GeneratorParams &params, std::string &error)
+{
+    if (params.width <= 0 || params.height <= 0)
+        error = "Width and height must be positive";
+    else if (static_cast<long long>(params.width) * params.height > 2147483647LL)
+        error = "Region must have fewer than 2^31 cells";
+    else if (params.density < 0.0 || params.density > 1.0)
+        error = "Density must be between 0 and 1";
+    else if (params.residentialWeight < 0 || params.commercialWeight < 0 || params.industrialWeight < 0 ||
+             params.residentialWeight + params.commercialWeight + params.industrialWeight <= 0)
+        error = "Zone mix weights must be non-negative with a positive sum";
+    else if (params.roadSpacing < 0 || params.powerSpacing < 0 || params.plants < 0)
+        error = "Spacings and plant count cannot be negative";
+    else if (params.clustering < 0.0 || params.clustering > 1.0 || params.clusterSize < 1)
+        error = "Clustering must be between 0 and 1 with a cluster size of at least 1";
+    else
+        return true;
+    return false;
+}
+
+double RegionGenerator::whiteNoise(int x, int y, uint64_t channel) const
+{
+    return toUnit(hashCell(params.seed, x, y, channel));
+}
+
+// Bilinearly interpolated lattice noise with clusterSize spacing
+double RegionGenerator::smoothNoise(int x, int y, uint64_t channel) const
+{
+    int size = params.clusterSize;
+    int gx = x / size, gy = y / size;
+    double fx = static_cast<double>(x % size) / size;
+    double fy = static_cast<double>(y % size) / size;
+    fx = fx * fx * (3.0 - 2.0 * fx);
+    fy = fy * fy * (3.0 - 2.0 * fy);
+
+    uint64_t lattice = channel + 16;
+    double top = whiteNoise(gx, gy, lattice) * (1.0 - fx) + whiteNoise(gx + 1, gy, lattice) * fx;
+    double bottom = whiteNoise(gx, gy + 1, lattice) * (1.0 - fx) + whiteNoise(gx + 1, gy + 1, lattice) * fx;
+    return top * (1.0 - fy) + bottom * fy;
+}
+
+double RegionGenerator::clusteredNoise(int x, int y, uint64_t channel) const
+{
+    if (params.clustering <= 0.0)
+        return whiteNoise(x, y, channel);
+    return params.clustering * smoothNoise(x, y, channel) + (1.0 - params.clustering) * whiteNoise(x, y, channel);
+}
+
+void RegionGenerator::generateRow(int y, std::vector<char> &row) const
+{
+    row.assign(params.width, '-');
+
+    int roadOffset = params.roadSpacing - 1;
+    int powerOffset = params.powerSpacing / 2;
+    bool roadRow = onLine(y, params.roadSpacing, roadOffset);
+    bool powerRow = onLine(y, params.powerSpacing, powerOffset);
+    double totalWeight = params.residentialWeight + params.commercialWeight + params.industrialWeight;
+    double residentialShare = params.residentialWeight / totalWeight;
+    double commercialShare = residentialShare + params.commercialWeight / totalWeight;
+
+    for (int x = 0; x < params.width; x++)
+    {
+        bool road = roadRow || onLine(x, params.roadSpacing, roadOffset);
+        bool power = powerRow || onLine(x, params.powerSpacing, powerOffset);
+
+        if (road && power)
+            row[x] = '#';
+        else if (power)
+            row[x] = 'T';
+        else if (!road && clusteredNoise(x, y, 0) < params.density)
+        {
+            double zone = clusteredNoise(x, y, 1);
+            row[x] = zone < residentialShare ? 'R' : (zone < commercialShare ? 'C' : 'I');
+        }
+    }
+
+    auto first = std::lower_bound(plantPositions.begin(), plantPositions.end(), std::make_pair(y, 0));
+    for (auto it = first; it != plantPositions.end() && it->first == y; ++it)
+        row[it->second] = 'P';
+}
+
+bool RegionGenerator::writeCsv(std::ostream &out) const
+{
+    out << params.height << "," << params.width << "\n";
+
+    std::vector<char> row;
+    std::string line;
+    line.reserve(params.width * 2);
+    for (int y = 0; y < params.height && out; y++)
+    {
+        generateRow(y, row);
+        line.clear();
+        for (int x = 0; x < params.width; x++)
+        {
+            if (x > 0)
+                line += ',';
+            line += row[x];
+        }
+        line += '\n';
+        out.write(line.data(), line.size());
+    }
+    return static_cast<bool>(out);
+}
+
+bool RegionGenerator::writeCsv(const std::string &filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot write region file: " << filename << std::endl;
+        return false;
+    }
+    return writeCsv(file);
+}
+
+bool RegionGenerator::writeTiles(const std::string &filename, int tileSize) const
+{
+    TileWriter writer(filename, params.width, params.height, tileSize);
+    if (!writer.isOpen())
+        return false;
+
+    std::vector<char> row;
+    for (int y = 0; y < params.height; y++)
+    {
+        generateRow(y, row);
+        writer.writeRow(row);
+    }
+    return writer.finish();
+}
@@ -0,0 +1,55 @@
+// RegionGenerator.h
+// Seeded procedural region layouts of arbitrary size. Every cell is a pure
+// function of (seed, x, y) plus a short list of plant positions, so rows can
+// be produced one at a time and streamed to disk without holding the map.
+#ifndef REGION_GENERATOR_H
+#define REGION_GENERATOR_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+struct GeneratorParams
+{
+    int width = 100;
+    int height = 100;
+    uint64_t seed = 1;
+    double density = 0.6;         // Fraction of free cells that are zoned
+    int residentialWeight = 50;   // Zone mix weights
+    int commercialWeight = 25;
+    int industrialWeight = 25;
+    int roadSpacing = 8;          // Road every N rows and columns (0 = none)
+    int powerSpacing = 16;        // Power line every N rows and columns (0 = none)
+    int plants = 4;               // Power plants placed on power lines
+    double clustering = 0.5;      // 0 = white noise, 1 = smooth zone blobs
+    int clusterSize = 16;         // Blob scale in cells
+};
+
+class RegionGenerator
+{
+public:
+    explicit RegionGenerator(const GeneratorParams &params);
+
+    // Fill row with the width cell types of row y
+    void generateRow(int y, std::vector<char> &row) const;
+
+    // Stream the whole layout in the format Region::loadFromFile reads
+    bool writeCsv(std::ostream &out) const;
+    bool writeCsv(const std::string &filename) const;
+
+    // Stream the layout straight into a tile file for out-of-core runs
+    bool writeTiles(const std::string &filename, int tileSize) const;
+
+    static bool validate(const GeneratorParams &params, std::string &error);
+
+private:
+    double whiteNoise(int x, int y, uint64_t channel) const;
+    double smoothNoise(int x, int y, uint64_t channel) const;
+    double clusteredNoise(int x, int y, uint64_t channel) const;
+
+    GeneratorParams params;
+    std::vector<std::pair<int, int>> plantPositions; // (y, x), sorted
+};
+
+#endif // REGION_GENERATOR_H
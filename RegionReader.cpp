@@ -0,0 +1,69 @@
+// RegionReader.cpp
+#include "RegionReader.h"
+#include <sstream>
+#include <stdexcept>
+
+RegionReader::RegionReader(std::istream &in) : in(in), width(0), height(0)
+{
+    // Read dimensions
+    if (!std::getline(in, line))
+    {
+        throw std::runtime_error("Cannot read dimensions");
+    }
+
+    std::stringstream ss(line);
+    char comma;
+    ss >> height >> comma >> width;
+
+    if (ss.fail() || comma != ',' || height <= 0 || width <= 0)
+    {
+        throw std::runtime_error("Invalid dimensions format");
+    }
+}
+
+bool RegionReader::isValidType(char type)
+{
+    return type == 'R' || type == 'I' || type == 'C' ||
+           type == '-' || type == 'T' || type == '#' || type == 'P';
+}
+
+void RegionReader::readRow(int y, std::vector<char> &row)
+{
+    if (!std::getline(in, line))
+    {
+        throw std::runtime_error("Unexpected end of file at line " + std::to_string(y));
+    }
+
+    row.resize(width);
+    std::stringstream lineStream(line);
+    std::string cell;
+    int x = 0;
+
+    while (std::getline(lineStream, cell, ','))
+    {
+        if (x >= width)
+        {
+            throw std::runtime_error("Too many columns in row " + std::to_string(y));
+        }
+
+        if (cell.empty())
+        {
+            throw std::runtime_error("Empty cell at position " + std::to_string(x) + "," + std::to_string(y));
+        }
+
+        char type = cell[0];
+        if (!isValidType(type))
+        {
+            throw std::runtime_error("Invalid cell type '" + std::string(1, type) +
+                                     "' at position " + std::to_string(x) + "," + std::to_string(y));
+        }
+
+        row[x] = type;
+        x++;
+    }
+
+    if (x < width)
+    {
+        throw std::runtime_error("Not enough columns in row " + std::to_string(y));
+    }
+}
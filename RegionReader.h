@@ -0,0 +1,32 @@
+// RegionReader.h
+// Streaming parser for region layout files ("height,width" followed by one
+// comma separated row of cell types per line). Rows are read one at a time
+// so large layouts never have to be held as text or as a whole grid.
+#ifndef REGION_READER_H
+#define REGION_READER_H
+
+#include <vector>
+#include <string>
+#include <istream>
+
+class RegionReader
+{
+public:
+    // Reads the dimensions line; throws std::runtime_error on bad input
+    explicit RegionReader(std::istream &in);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Read row y into row as width cell types; throws std::runtime_error on bad input
+    void readRow(int y, std::vector<char> &row);
+
+    static bool isValidType(char type);
+
+private:
+    std::istream &in;
+    int width, height;
+    std::string line;
+};
+
+#endif // REGION_READER_H
@@ -0,0 +1,257 @@
+// RoadNetwork.cpp
+#include "RoadNetwork.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+const int RoadNetwork::UNREACHED;
+const size_t RoadNetwork::PARALLEL_FRONTIER;
+const int RoadNetwork::LINKS;
+const int RoadNetwork::MAX_SPLIT_SEARCH;
+
+void RoadNetwork::build(const std::vector<std::vector<Cell>> &grid)
+{
+    height = grid.size();
+    width = height > 0 ? grid[0].size() : 0;
+
+    nodeOf.assign(static_cast<size_t>(width) * height, -1);
+    cellOf.clear();
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if (isRoad(grid[y][x].getType()))
+            {
+                size_t cell = static_cast<size_t>(y) * width + x;
+                nodeOf[cell] = cellOf.size();
+                cellOf.push_back(cell);
+            }
+        }
+    }
+
+    // Links in the order up, left, right, down. Networks are found with
+    // union-find over the up and left links in the same pass.
+    std::vector<int> parent(cellOf.size());
+    links.assign(cellOf.size() * LINKS, -1);
+    freeNodes.clear();
+    for (size_t node = 0; node < cellOf.size(); node++)
+    {
+        size_t cell = cellOf[node];
+        int x = cell % width;
+        int *slots = &links[node * LINKS];
+        parent[node] = node;
+        if (cell >= static_cast<size_t>(width) && nodeOf[cell - width] >= 0)
+        {
+            slots[0] = nodeOf[cell - width];
+            unite(parent, node, slots[0]);
+        }
+        if (x > 0 && nodeOf[cell - 1] >= 0)
+        {
+            slots[1] = nodeOf[cell - 1];
+            unite(parent, node, slots[1]);
+        }
+        if (x + 1 < width)
+            slots[2] = nodeOf[cell + 1];
+        if (cell + width < nodeOf.size())
+            slots[3] = nodeOf[cell + width];
+    }
+
+    // Number the networks in order of their first node
+    network.assign(cellOf.size(), -1);
+    networkCount = 0;
+    for (size_t node = 0; node < cellOf.size(); node++)
+    {
+        int root = find(parent, node);
+        if (network[root] < 0)
+            network[root] = networkCount++;
+        network[node] = network[root];
+    }
+}
+
+int RoadNetwork::addNode(int x, int y)
+{
+    size_t cell = static_cast<size_t>(y) * width + x;
+    int around[LINKS] = {y > 0 ? nodeOf[cell - width] : -1, x > 0 ? nodeOf[cell - 1] : -1,
+                         x + 1 < width ? nodeOf[cell + 1] : -1, y + 1 < height ? nodeOf[cell + width] : -1};
+    int joined = -1;
+    for (int k = 0; k < LINKS; k++)
+    {
+        if (around[k] < 0)
+            continue;
+        if (joined >= 0 && network[around[k]] != joined)
+            return -1;
+        joined = network[around[k]];
+    }
+
+    int node;
+    if (!freeNodes.empty())
+    {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else
+    {
+        node = cellOf.size();
+        cellOf.push_back(-1);
+        network.push_back(-1);
+        links.resize(links.size() + LINKS, -1);
+    }
+    nodeOf[cell] = node;
+    cellOf[node] = cell;
+    network[node] = joined >= 0 ? joined : networkCount++;
+
+    // Slot k of a neighbour points back through the opposite side, LINKS - 1 - k
+    for (int k = 0; k < LINKS; k++)
+    {
+        links[static_cast<size_t>(node) * LINKS + k] = around[k];
+        if (around[k] >= 0)
+            links[static_cast<size_t>(around[k]) * LINKS + LINKS - 1 - k] = node;
+    }
+    return node;
+}
+
+bool RoadNetwork::removeNode(int x, int y)
+{
+    size_t cell = static_cast<size_t>(y) * width + x;
+    int node = nodeOf[cell];
+    const int *slots = linksOf(node);
+    int around[LINKS];
+    int count = 0;
+    for (int k = 0; k < LINKS; k++)
+    {
+        if (slots[k] >= 0)
+            around[count++] = slots[k];
+    }
+
+    // The neighbours must still reach each other without this node; a
+    // bounded search from the first one looks for the others
+    if (count > 1)
+    {
+        std::vector<char> seen(cellOf.size(), 0);
+        std::vector<int> visited(1, around[0]);
+        seen[node] = seen[around[0]] = 1;
+        int found = 1;
+        for (size_t i = 0; i < visited.size() && found < count && visited.size() < static_cast<size_t>(MAX_SPLIT_SEARCH);
+             i++)
+        {
+            for (const int *n = linksOf(visited[i]); n != linksOf(visited[i]) + LINKS; n++)
+            {
+                if (*n < 0 || seen[*n])
+                    continue;
+                seen[*n] = 1;
+                visited.push_back(*n);
+                found += std::find(around + 1, around + count, *n) != around + count;
+            }
+        }
+        if (found < count)
+            return false;
+    }
+
+    for (int k = 0; k < LINKS; k++)
+    {
+        if (slots[k] >= 0)
+            links[static_cast<size_t>(slots[k]) * LINKS + LINKS - 1 - k] = -1;
+    }
+    std::fill(links.begin() + static_cast<size_t>(node) * LINKS, links.begin() + static_cast<size_t>(node + 1) * LINKS,
+              -1);
+    nodeOf[cell] = -1;
+    cellOf[node] = -1;
+    network[node] = -1;
+    freeNodes.push_back(node);
+    return true;
+}
+
+// Union-find with path halving; roots are always the lowest node of their set
+int RoadNetwork::find(std::vector<int> &parent, int node)
+{
+    while (parent[node] != node)
+    {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void RoadNetwork::unite(std::vector<int> &parent, int a, int b)
+{
+    a = find(parent, a);
+    b = find(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+// Claim every neighbour of frontier[begin, end) that is farther than level.
+// Alone on the frontier a plain store will do; shared, nodes are claimed
+// with compare-and-swap so each lands in exactly one next frontier.
+static void expandLevel(const RoadNetwork &roads, const std::vector<int> &frontier, size_t begin, size_t end,
+                        int level, std::atomic<int> *distance, bool shared, std::vector<int> &next)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        const int *links = roads.linksOf(frontier[i]);
+        for (const int *n = links; n != links + RoadNetwork::LINKS; n++)
+        {
+            if (*n < 0)
+                continue;
+            int current = distance[*n].load(std::memory_order_relaxed);
+            if (current <= level)
+                continue;
+            if (!shared)
+            {
+                distance[*n].store(level, std::memory_order_relaxed);
+                next.push_back(*n);
+                continue;
+            }
+            while (current > level)
+            {
+                if (distance[*n].compare_exchange_weak(current, level, std::memory_order_relaxed))
+                {
+                    next.push_back(*n);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void RoadNetwork::expand(std::vector<int> &frontier, int startDistance, int maxDistance,
+                         std::atomic<int> *distance, int threads) const
+{
+    std::vector<int> next;
+    std::vector<std::vector<int>> parts(threads > 1 ? threads : 1);
+    for (int level = startDistance + 1; level <= maxDistance && !frontier.empty(); level++)
+    {
+        next.clear();
+        if (threads <= 1 || frontier.size() < PARALLEL_FRONTIER)
+        {
+            expandLevel(*this, frontier, 0, frontier.size(), level, distance, false, next);
+        }
+        else
+        {
+            // Each thread takes one slice of the frontier; the next frontier is their results in order
+            std::vector<std::thread> workers;
+            size_t slice = (frontier.size() + threads - 1) / threads;
+            for (int t = 0; t < threads; t++)
+            {
+                size_t begin = std::min(frontier.size(), t * slice);
+                size_t end = std::min(frontier.size(), begin + slice);
+                parts[t].clear();
+                workers.emplace_back(expandLevel, std::cref(*this), std::cref(frontier), begin, end,
+                                     level, distance, true, std::ref(parts[t]));
+            }
+            for (auto &worker : workers)
+                worker.join();
+            for (const auto &part : parts)
+                next.insert(next.end(), part.begin(), part.end());
+        }
+        frontier.swap(next);
+    }
+}
+
+size_t RoadNetwork::getMemoryBytes() const
+{
+    return (nodeOf.capacity() + cellOf.capacity() + links.capacity() + network.capacity() + freeNodes.capacity()) *
+           sizeof(int);
+}
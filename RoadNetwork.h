@@ -0,0 +1,77 @@
+// RoadNetwork.h
+// Road cells ('-' and '#') compiled into a graph: one node per road cell,
+// with a slot for each of its road neighbours above, left, right and
+// below. Nodes are grouped into connected networks. A build numbers nodes
+// in row-major order; roads added later reuse the numbers of removed ones
+// or get new ones, so order cells with getCell() rather than by node.
+// Distances are counted in road cells travelled.
+#ifndef ROAD_NETWORK_H
+#define ROAD_NETWORK_H
+
+#include <vector>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include "Cell.h"
+
+class RoadNetwork
+{
+public:
+    static const int UNREACHED = INT_MAX;
+
+    // Frontiers smaller than this are expanded on the calling thread only
+    static const size_t PARALLEL_FRONTIER = 1 << 14;
+
+    // Link slots per node: up, left, right, down; -1 where there is no road
+    static const int LINKS = 4;
+
+    // Nodes a removal may search before it assumes the network splits
+    static const int MAX_SPLIT_SEARCH = 1 << 12;
+
+    static bool isRoad(char type) { return type == '-' || type == '#'; }
+
+    RoadNetwork() : width(0), height(0), networkCount(0) {}
+
+    void build(const std::vector<std::vector<Cell>> &grid);
+
+    int getNodeCount() const { return cellOf.size(); }
+    int getNetworkCount() const { return networkCount; }
+
+    // Node of a road cell, or -1
+    int nodeAt(int x, int y) const { return nodeOf[static_cast<size_t>(y) * width + x]; }
+    int getCell(int node) const { return cellOf[node]; }
+    int getNetwork(int node) const { return network[node]; }
+    const int *linksOf(int node) const { return links.data() + static_cast<size_t>(node) * LINKS; }
+
+    // Make (x, y) a road node joined to the roads around it; returns the
+    // node, or -1 without changes if that would merge networks
+    int addNode(int x, int y);
+
+    // Take the road node at (x, y) out of the graph; false without changes
+    // if its neighbours might no longer be connected to each other
+    bool removeNode(int x, int y);
+
+    // Multi-source breadth-first search. Every frontier node already holds
+    // startDistance; distances of nodes up to maxDistance away are lowered
+    // where the frontier is closer. Large frontiers are split across
+    // threads, which claim nodes with compare-and-swap, so the distances
+    // are the same for any thread count. frontier is used as scratch.
+    void expand(std::vector<int> &frontier, int startDistance, int maxDistance,
+                std::atomic<int> *distance, int threads) const;
+
+    size_t getMemoryBytes() const;
+
+private:
+    static int find(std::vector<int> &parent, int node);
+    static void unite(std::vector<int> &parent, int a, int b);
+
+    int width, height;
+    int networkCount;
+    std::vector<int> nodeOf;    // Per cell
+    std::vector<int> cellOf;    // Per node, row-major cell index; -1 for removed nodes
+    std::vector<int> links;     // LINKS slots per node
+    std::vector<int> network;   // Per node, numbered in order of each network's first node when built
+    std::vector<int> freeNodes; // Removed nodes, reused by addNode
+};
+
+#endif // ROAD_NETWORK_H
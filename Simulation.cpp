@@ -0,0 +1,626 @@
+// Simulation.cpp
+#include "Simulation.h"
+#include "ResidentialSystem.h"
+#include "CommercialSystem.h"
+#include "IndustrialSystem.h"
+#include "Profiler.h"
+#include "RegionReader.h"
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+
+bool StepGenerator::next(StepSummary &summary)
+{
+    if (finished || remaining <= 0)
+        return false;
+
+    summary = simulation->step();
+    remaining--;
+    finished = !summary.changed || summary.period > 0;
+    return true;
+}
+
+Simulation::Simulation() : gridStale(false), width(0), height(0), totals{0, 0, 0}, totalPollution(0),
+                           availableWorkers(0), availableGoods(0),
+                           changed(false), cycleWindow(DEFAULT_CYCLE_WINDOW), detectedPeriod(0),
+                           engine(ENGINE_REFERENCE), chunkedGridLoaded(false), fixedGridLoaded(false),
+                           fixedSizeDispatch(true), stepsTaken(0),
+                           pollutionDeferred(false), pollutionPending(false), pollutionNs(0) {}
+
+bool Simulation::parseEngine(const std::string &name, StepEngine &result)
+{
+    if (name == "reference")
+        result = ENGINE_REFERENCE;
+    else if (name == "sparse")
+        result = ENGINE_SPARSE;
+    else if (name == "adaptive")
+        result = ENGINE_ADAPTIVE;
+    else
+        return false;
+    return true;
+}
+
+const char *Simulation::engineName(StepEngine engine)
+{
+    switch (engine)
+    {
+    case ENGINE_SPARSE:
+        return "sparse";
+    case ENGINE_ADAPTIVE:
+        return "adaptive";
+    default:
+        return "reference";
+    }
+}
+
+void Simulation::setEngine(StepEngine newEngine)
+{
+    handBackToGrid();
+    engine = newEngine;
+    selector.reset(static_cast<long long>(width) * height);
+}
+
+// Move the state out of chunkedGrid or fixedGrid; their next step re-imports the grid
+void Simulation::handBackToGrid()
+{
+    syncGrid();
+    if (chunkedGridLoaded)
+    {
+        totals[0] = chunkedGrid.getTotalPopulation('R');
+        totals[1] = chunkedGrid.getTotalPopulation('I');
+        totals[2] = chunkedGrid.getTotalPopulation('C');
+        totalPollution = chunkedGrid.getTotalPollution();
+    }
+    chunkedGridLoaded = false;
+    fixedGridLoaded = false;
+}
+
+void Simulation::setCommuteDistance(int maxDistance, int threads)
+{
+    // Hand the state back to the grid, which the reference engine steps
+    setEngine(engine);
+    if (maxDistance > 0)
+        commute.reset(new CommuteSystem(maxDistance, threads));
+    else
+        commute.reset();
+}
+
+void Simulation::enableLandValue(int minimumValue, int threads)
+{
+    setEngine(engine);
+    landValue.reset(new LandValue(minimumValue, threads));
+}
+
+void Simulation::disableLandValue()
+{
+    landValue.reset();
+}
+
+// Bring grid up to date after sparse or fixed-size steps
+void Simulation::syncGrid() const
+{
+    if (gridStale)
+    {
+        if (fixedGridLoaded)
+            fixedGrid->storeToGrid(grid);
+        else
+            chunkedGrid.storeToGrid(grid);
+        gridStale = false;
+    }
+}
+
+bool Simulation::load(const std::string &filename, std::string &error)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        error = "Cannot open region file: " + filename;
+        return false;
+    }
+    return load(file, error);
+}
+
+bool Simulation::load(std::istream &in, std::string &error)
+{
+    std::vector<std::vector<Cell>> loaded;
+    try
+    {
+        RegionReader reader(in);
+        loaded.resize(reader.getHeight(), std::vector<Cell>(reader.getWidth()));
+
+        std::vector<char> row;
+        for (int y = 0; y < reader.getHeight(); y++)
+        {
+            reader.readRow(y, row);
+            for (int x = 0; x < reader.getWidth(); x++)
+                loaded[y][x].setType(row[x]);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        error = e.what();
+        return false;
+    }
+
+    grid.swap(loaded);
+    height = grid.size();
+    width = grid[0].size();
+    totals[0] = totals[1] = totals[2] = 0; // Every cell starts empty
+    totalPollution = 0;
+    availableWorkers = 0;
+    availableGoods = 0;
+    changed = false;
+
+    stateHash.reset(grid);
+    hashHistory.clear();
+    recordStateHash();
+    detectedPeriod = 0;
+    chunkedGridLoaded = false;
+    fixedGrid = FixedGridEngine::create(width, height);
+    fixedGridLoaded = false;
+    gridStale = false;
+    stepsTaken = 0;
+    selector.reset(static_cast<long long>(width) * height);
+    pollutionPending = false;
+
+    historyChanges.clear();
+    if (history)
+        history->reset(grid, 0);
+    if (commute)
+        commute->invalidate();
+    if (landValue)
+        landValue->invalidate();
+    return true;
+}
+
+const std::vector<std::vector<Cell>> &Simulation::getGrid() const
+{
+    syncGrid();
+    return grid;
+}
+
+void Simulation::updateResources()
+{
+    availableWorkers = totals[0];
+    availableGoods = totals[1];
+}
+
+// Remember the current state hash; returns the period if it was seen within the window
+int Simulation::recordStateHash()
+{
+    uint64_t hash = stateHash.getHash();
+    int period = 0;
+    for (size_t back = 1; back <= hashHistory.size() && period == 0; back++)
+    {
+        if (hashHistory[hashHistory.size() - back] == hash)
+            period = back;
+    }
+
+    hashHistory.push_back(hash);
+    while (hashHistory.size() > static_cast<size_t>(cycleWindow))
+        hashHistory.pop_front();
+    return period;
+}
+
+StepSummary Simulation::step()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int workers = getTotalPopulation('R');
+    int goods = getTotalPopulation('I');
+    int commercial = getTotalPopulation('C');
+
+    // Commuting and land value are only implemented over the grid
+    StepEngine used = engine == ENGINE_ADAPTIVE ? (selector.prefersSparse() ? ENGINE_SPARSE : ENGINE_REFERENCE)
+                                                : engine;
+    if (commute || landValue)
+        used = ENGINE_REFERENCE;
+
+    // Pollution deferred earlier belongs to the step that deferred it, so
+    // unless this step defers too it is caught up before growth starts
+    pollutionNs = 0;
+    if (pollutionPending && !(pollutionDeferred && !landValue && used != ENGINE_SPARSE))
+        catchUpPollution();
+
+    PROFILE_BEGIN_STEP(stepsTaken);
+    {
+        PROFILE_SCOPE("step");
+        stateHash.clearChanges();
+
+        if (used == ENGINE_SPARSE)
+        {
+            stepSparse();
+        }
+        else if (usesFixedGrid() && !commute && !landValue && !pollutionDeferred)
+        {
+            stepFixed();
+        }
+        else
+        {
+            handBackToGrid();
+            stepReference();
+        }
+
+        // Populations only grow and pollution is written once, so any reported change is real
+        PROFILE_SCOPE("changeDetection");
+        changed = stateHash.getChanges() > 0;
+        detectedPeriod = changed ? recordStateHash() : 0;
+    }
+    PROFILE_END_STEP();
+
+    StepSummary summary;
+    summary.step = stepsTaken++;
+    if (history)
+    {
+        PROFILE_SCOPE("HistoryStore::record");
+        history->record(stepsTaken, historyChanges);
+        historyChanges.clear();
+    }
+    summary.changed = changed;
+    summary.period = detectedPeriod;
+    summary.changes = stateHash.getChanges();
+    summary.workers = workers;
+    summary.goods = goods;
+    summary.workersUsed = workers - availableWorkers;
+    summary.goodsUsed = getTotalPopulation('C') - commercial; // One good per commercial growth
+    summary.availableWorkers = availableWorkers;
+    summary.availableGoods = availableGoods;
+    summary.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    summary.pollutionNs = pollutionNs;
+    summary.engine = used;
+    summary.pollutionPending = pollutionPending;
+    summary.hash = stateHash.getHash();
+    if (engine == ENGINE_ADAPTIVE)
+        selector.observe(summary.changes);
+    return summary;
+}
+
+void Simulation::stepSparse()
+{
+    PROFILE_SCOPE("ChunkedGrid::step");
+    if (fixedGridLoaded)
+        handBackToGrid();
+    if (!chunkedGridLoaded)
+    {
+        chunkedGrid.loadFromGrid(grid, stepsTaken);
+        chunkedGridLoaded = true;
+    }
+    chunkedGrid.step(&stateHash);
+    availableWorkers = chunkedGrid.getAvailableWorkers();
+    availableGoods = chunkedGrid.getAvailableGoods();
+    gridStale = true;
+}
+
+// The reference rules on a FixedGrid; resources and totals stay with Simulation
+void Simulation::stepFixed()
+{
+    PROFILE_SCOPE("FixedGrid::step");
+    if (!fixedGridLoaded)
+    {
+        handBackToGrid();
+        fixedGrid->loadFromGrid(grid);
+        fixedGridLoaded = true;
+    }
+    updateResources();
+    int grown[3] = {0, 0, 0};
+    totalPollution = fixedGrid->step(availableWorkers, availableGoods, grown, &stateHash);
+    for (int slot = 0; slot < 3; slot++)
+        totals[slot] += grown[slot];
+    gridStale = true;
+}
+
+void Simulation::stepReference()
+{
+    {
+        PROFILE_SCOPE("updateResources");
+        updateResources();
+        if (commute)
+            commute->beginStep(grid);
+        if (landValue)
+            landValue->refresh(grid);
+    }
+
+    // Update in priority order according to project requirements
+    {
+        PROFILE_SCOPE("CommercialSystem::update");
+        totals[2] += CommercialSystem::update(grid, availableWorkers, availableGoods, &stateHash, commute.get(),
+                                              landValue.get());
+    }
+    {
+        PROFILE_SCOPE("IndustrialSystem::update");
+        totals[1] += IndustrialSystem::update(grid, availableWorkers, availableGoods, &stateHash, commute.get(),
+                                              landValue.get());
+    }
+    {
+        PROFILE_SCOPE("ResidentialSystem::update");
+        totals[0] += ResidentialSystem::update(grid, &stateHash, landValue.get());
+    }
+
+    // Update pollution last. A deferred step that grew nothing has no
+    // later step to hand its pollution to: anything still pending goes to
+    // the steps that deferred it, and otherwise it is updated now.
+    if (!pollutionDeferred || landValue)
+    {
+        updatePollution();
+    }
+    else if (stateHash.getChanges() > 0)
+    {
+        pollutionPending = true;
+    }
+    else if (pollutionPending)
+    {
+        catchUpPollution();
+        stateHash.clearChanges();
+    }
+    else
+    {
+        updatePollution();
+    }
+}
+
+void Simulation::updatePollution()
+{
+    PROFILE_SCOPE("updatePollution");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    totalPollution = IndustrialSystem::updatePollution(grid, &stateHash);
+    pollutionPending = false;
+    pollutionNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+}
+
+long long Simulation::catchUpPollution()
+{
+    if (!pollutionPending)
+        return 0;
+
+    long long before = stateHash.getChanges();
+    updatePollution();
+    long long changes = stateHash.getChanges() - before;
+
+    // The caught-up state replaces the one recorded for the last step
+    if (!hashHistory.empty())
+        hashHistory.back() = stateHash.getHash();
+    if (history)
+    {
+        history->amend(historyChanges);
+        historyChanges.clear();
+    }
+    return changes;
+}
+
+bool Simulation::setCellType(int x, int y, char type)
+{
+    if (x < 0 || x >= width || y < 0 || y >= height || !RegionReader::isValidType(type))
+        return false;
+
+    // Edits update pollution around the cell only, which needs a complete start
+    catchUpPollution();
+
+    // Fixed-size steps are cheap to restart, so edits go to the grid
+    if (fixedGridLoaded)
+        handBackToGrid();
+
+    // Road and zone edits change who can reach which jobs and land values;
+    // the grid is never stale while either is on
+    if (commute && (CommuteSystem::affectedBy(grid[y][x].getType()) || CommuteSystem::affectedBy(type)))
+        commute->cellChanged(x, y);
+    if (landValue && (LandValue::isFeature(grid[y][x].getType()) || LandValue::isFeature(type)))
+        landValue->cellChanged(x, y);
+
+    // The sparse engine owns the state once loaded; a grid that is in sync gets the same edit
+    if (chunkedGridLoaded)
+    {
+        chunkedGrid.setType(x, y, type, &stateHash);
+        if (!gridStale)
+            editGrid(x, y, type, nullptr);
+    }
+    else
+    {
+        editGrid(x, y, type, &stateHash);
+    }
+
+    // Type changes are not part of the hash, so history logs them here
+    if (history)
+        historyChanges.push_back({x, y, FIELD_TYPE, type});
+
+    // Earlier states were reached under a different layout
+    hashHistory.clear();
+    recordStateHash();
+    detectedPeriod = 0;
+    changed = true;
+    return true;
+}
+
+// Index into Simulation::totals, or -1 for cells without population
+static int zoneSlot(char type)
+{
+    switch (type)
+    {
+    case 'R':
+        return 0;
+    case 'I':
+        return 1;
+    case 'C':
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+static int pollutionSource(const Cell &cell)
+{
+    if (cell.getType() == 'I')
+        return cell.getPopulation();
+    return cell.getType() == 'P' ? 4 : 0;
+}
+
+void Simulation::editGrid(int x, int y, char type, StateHash *hash)
+{
+    Cell &cell = grid[y][x];
+    if (cell.getType() == type)
+        return;
+
+    int oldSource = pollutionSource(cell);
+    if (hash)
+        hash->updatePopulation(x, y, cell.getPopulation(), 0);
+    int slot = zoneSlot(cell.getType());
+    if (slot >= 0)
+        totals[slot] -= cell.getPopulation();
+    cell.setType(type);
+    cell.setPopulation(0);
+    int newSource = pollutionSource(cell);
+
+    // Pollution is only present once a step has run; apply the change of this one source
+    if (stepsTaken == 0 || oldSource == newSource)
+        return;
+    for (int dy = -3; dy <= 3; dy++)
+    {
+        for (int dx = -3; dx <= 3; dx++)
+        {
+            int newX = x + dx;
+            int newY = y + dy;
+            if (newX < 0 || newX >= width || newY < 0 || newY >= height)
+                continue;
+
+            int distance = std::max(std::abs(dx), std::abs(dy));
+            int delta = std::max(0, newSource - distance) - std::max(0, oldSource - distance);
+            Cell &target = grid[newY][newX];
+            if (hash)
+                hash->updatePollution(newX, newY, target.getPollution(), target.getPollution() + delta);
+            target.setPollution(target.getPollution() + delta);
+            totalPollution += delta;
+        }
+    }
+}
+
+int Simulation::getTotalPopulation(char type) const
+{
+    // Both engines keep running totals, so no grid scan or refresh is needed
+    if (chunkedGridLoaded)
+        return chunkedGrid.getTotalPopulation(type);
+    int slot = zoneSlot(type);
+    return slot >= 0 ? totals[slot] : 0;
+}
+
+int Simulation::getTotalPollution() const
+{
+    if (chunkedGridLoaded)
+        return chunkedGrid.getTotalPollution();
+    return totalPollution;
+}
+
+bool Simulation::enableHistory(int keyframeInterval, size_t budgetBytes)
+{
+    std::unique_ptr<HistoryStore> store(new HistoryStore(keyframeInterval, budgetBytes));
+    if (!store->reset(getGrid(), stepsTaken))
+        return false;
+    history = std::move(store);
+    historyChanges.clear();
+    stateHash.setChangeLog(&historyChanges);
+    return true;
+}
+
+bool Simulation::resume(std::unique_ptr<HistoryStore> stored, const std::vector<StepSummary> &taken)
+{
+    int step = taken.size();
+    std::vector<std::vector<Cell>> restored;
+    if (stepsTaken != 0 || !stored->hasStep(0) || !stored->hasStep(step) || !stored->restore(0, restored) ||
+        static_cast<int>(restored.size()) != height || static_cast<int>(restored[0].size()) != width)
+        return false;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if (restored[y][x].getType() != grid[y][x].getType())
+                return false;
+        }
+    }
+
+    stored->truncate(step);
+    stored->restore(step, restored);
+    StateHash restoredHash;
+    restoredHash.reset(restored);
+    if (step > 0 && restoredHash.getHash() != taken.back().hash)
+        return false;
+
+    handBackToGrid();
+    grid.swap(restored);
+    totals[0] = ResidentialSystem::getTotalPopulation(grid);
+    totals[1] = IndustrialSystem::getTotalPopulation(grid);
+    totals[2] = CommercialSystem::getTotalPopulation(grid);
+    totalPollution = 0;
+    for (const auto &row : grid)
+    {
+        for (const Cell &cell : row)
+            totalPollution += cell.getPollution();
+    }
+    if (step > 0)
+    {
+        availableWorkers = taken.back().availableWorkers;
+        availableGoods = taken.back().availableGoods;
+        changed = taken.back().changed;
+        detectedPeriod = taken.back().period;
+    }
+
+    // Cycle detection picks up with the hashes it would have seen; the loaded layout hashes to 0
+    stateHash.reset(grid);
+    hashHistory.assign(1, 0);
+    for (const StepSummary &summary : taken)
+        hashHistory.push_back(summary.hash);
+    while (hashHistory.size() > static_cast<size_t>(cycleWindow))
+        hashHistory.pop_front();
+
+    stepsTaken = step;
+    pollutionPending = false;
+    history = std::move(stored);
+    historyChanges.clear();
+    stateHash.setChangeLog(&historyChanges);
+    if (commute)
+        commute->invalidate();
+    if (landValue)
+        landValue->invalidate();
+    selector.reset(static_cast<long long>(width) * height);
+    return true;
+}
+
+bool Simulation::analyzeAreaAt(int step, int x1, int y1, int x2, int y2, AreaStats &stats) const
+{
+    return history && history->analyzeArea(step, x1, y1, x2, y2, stats);
+}
+
+bool Simulation::analyzeArea(int x1, int y1, int x2, int y2, AreaStats &stats) const
+{
+    if (x1 > x2)
+        std::swap(x1, x2);
+    if (y1 > y2)
+        std::swap(y1, y2);
+    if (x1 < 0 || x2 >= width || y1 < 0 || y2 >= height)
+        return false;
+
+    syncGrid();
+    stats.residential = stats.industrial = stats.commercial = stats.pollution = 0;
+    for (int y = y1; y <= y2; y++)
+    {
+        for (int x = x1; x <= x2; x++)
+        {
+            const Cell &cell = grid[y][x];
+            switch (cell.getType())
+            {
+            case 'R':
+                stats.residential += cell.getPopulation();
+                break;
+            case 'I':
+                stats.industrial += cell.getPopulation();
+                break;
+            case 'C':
+                stats.commercial += cell.getPopulation();
+                break;
+            }
+            stats.pollution += cell.getPollution();
+        }
+    }
+    return true;
+}
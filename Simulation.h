@@ -0,0 +1,302 @@
+// Simulation.h
+// Embeddable simulation engine with no console or file output. Load a
+// region, advance it one step at a time with step() or pull steps lazily
+// from a StepGenerator, and read the grid through read-only plane views.
+// Region's console front end is one consumer of this API.
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <istream>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include "Cell.h"
+#include "StateHash.h"
+#include "ChunkedGrid.h"
+#include "HistoryStore.h"
+#include "CommuteSystem.h"
+#include "LandValue.h"
+#include "EngineSelector.h"
+#include "FixedGrid.h"
+
+// Step implementations a Simulation can run; all produce identical results
+enum StepEngine
+{
+    ENGINE_REFERENCE, // Full grid scans through the zone systems
+    ENGINE_SPARSE,    // ChunkedGrid, skips chunks that cannot change
+    ENGINE_ADAPTIVE   // Switches between the two as activity changes (see EngineSelector)
+};
+
+// What one step did; cheap to produce, no grid scan involved
+struct StepSummary
+{
+    int step;             // Index of the step, counted from the load
+    bool changed;         // Whether any population or pollution value changed
+    int period;           // > 0 if the state repeats with this period
+    long long changes;    // Number of population and pollution values changed
+    int workers;          // Resources at the start of the step
+    int goods;
+    int workersUsed;      // Taken by commercial and industrial growth
+    int goodsUsed;        // Taken by commercial growth
+    int availableWorkers; // Resources left over after the step
+    int availableGoods;
+    long long durationNs; // Wall time of the step
+    long long pollutionNs; // Part of it spent recomputing pollution, catch-ups included
+    StepEngine engine;     // Engine that ran the step, never ENGINE_ADAPTIVE
+    bool pollutionPending; // Pollution was deferred and is not up to date yet
+    uint64_t hash;         // State hash after the step
+};
+
+struct AreaStats
+{
+    int residential;
+    int industrial;
+    int commercial;
+    int pollution;
+};
+
+enum PlaneField
+{
+    PLANE_TYPE,
+    PLANE_POPULATION,
+    PLANE_POLLUTION
+};
+
+// Read-only view of one field of the grid, without copying. Valid until
+// the next step or load of the simulation it came from.
+class PlaneView
+{
+public:
+    PlaneView(const std::vector<std::vector<Cell>> &grid, PlaneField field) : grid(&grid), field(field) {}
+
+    int getWidth() const { return grid->empty() ? 0 : (*grid)[0].size(); }
+    int getHeight() const { return grid->size(); }
+    PlaneField getField() const { return field; }
+
+    // Cell types are returned as their character codes
+    int operator()(int x, int y) const
+    {
+        const Cell &cell = (*grid)[y][x];
+        return field == PLANE_TYPE ? cell.getType()
+                                   : (field == PLANE_POPULATION ? cell.getPopulation() : cell.getPollution());
+    }
+
+private:
+    const std::vector<std::vector<Cell>> *grid;
+    PlaneField field;
+};
+
+class Simulation;
+
+// Lazily steps a simulation: each pull takes exactly one step, and the
+// sequence ends after maxSteps steps or once the region stops changing or
+// starts repeating. Usable with next() or as a range in a for loop.
+class StepGenerator
+{
+public:
+    StepGenerator(Simulation &simulation, int maxSteps)
+        : simulation(&simulation), remaining(maxSteps), finished(false) {}
+
+    // Take the next step; false once the sequence has ended
+    bool next(StepSummary &summary);
+
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef StepSummary value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const StepSummary *pointer;
+        typedef const StepSummary &reference;
+
+        iterator() : generator(nullptr) {}
+        explicit iterator(StepGenerator *generator) : generator(generator) { advance(); }
+
+        const StepSummary &operator*() const { return current; }
+        const StepSummary *operator->() const { return &current; }
+        iterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+        bool operator==(const iterator &other) const { return generator == other.generator; }
+        bool operator!=(const iterator &other) const { return generator != other.generator; }
+
+    private:
+        void advance()
+        {
+            if (generator && !generator->next(current))
+                generator = nullptr;
+        }
+
+        StepGenerator *generator;
+        StepSummary current;
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+private:
+    Simulation *simulation;
+    int remaining;
+    bool finished;
+};
+
+class Simulation
+{
+public:
+    static const int DEFAULT_CYCLE_WINDOW = 32;
+
+    Simulation();
+
+    // The hash logs changes into this object, so it stays where it was made
+    Simulation(const Simulation &) = delete;
+    Simulation &operator=(const Simulation &) = delete;
+
+    // Load a region layout; on failure error describes the problem
+    bool load(const std::string &filename, std::string &error);
+    bool load(std::istream &in, std::string &error);
+
+    void setCycleWindow(int steps) { cycleWindow = steps > 0 ? steps : 1; }
+    int getCycleWindow() const { return cycleWindow; }
+    void setEngine(StepEngine newEngine);
+    StepEngine getEngine() const { return engine; }
+    static bool parseEngine(const std::string &name, StepEngine &result);
+    static const char *engineName(StepEngine engine);
+
+    // Reference steps on regions of a size with a FixedGrid specialization
+    // run on it, with identical results; off always uses the zone systems
+    void setFixedSizeDispatch(bool enabled) { fixedSizeDispatch = enabled; }
+    bool usesFixedGrid() const { return fixedGrid && fixedSizeDispatch; }
+
+    // Only let jobs draw workers and goods over the roads, from at most
+    // maxDistance road cells away (see CommuteSystem); 0 turns it off.
+    // While on, every step runs on the reference engine.
+    void setCommuteDistance(int maxDistance, int threads = 1);
+    int getCommuteDistance() const { return commute ? commute->getMaxDistance() : 0; }
+    const CommuteSystem *getCommute() const { return commute.get(); }
+
+    // While deferred, reference steps leave pollution as it is; the next
+    // step that is not deferred catches it up before growing, or
+    // catchUpPollution() does; either way the caught-up values count as
+    // changes of the step that deferred them. Growth only depends on
+    // pollution through land value, so steps with land value on never
+    // defer, and neither does the sparse engine, which updates pollution
+    // incrementally.
+    void setPollutionDeferred(bool deferred) { pollutionDeferred = deferred; }
+    bool isPollutionPending() const { return pollutionPending; }
+
+    // Recompute deferred pollution now, as part of the last step taken;
+    // returns the number of values changed
+    long long catchUpPollution();
+
+    // Only let cells grow whose land value (see LandValue) is at least
+    // minimumValue. While on, every step runs on the reference engine.
+    void enableLandValue(int minimumValue, int threads = 1);
+    void disableLandValue();
+    const LandValue *getLandValue() const { return landValue.get(); }
+
+    // Advance one time step
+    StepSummary step();
+
+    // Pull up to maxSteps steps lazily
+    StepGenerator steps(int maxSteps) { return StepGenerator(*this, maxSteps); }
+
+    // Rezone, bulldoze ('-') or place power and roads between steps. The
+    // cell starts over at population 0; pollution, totals and the sparse
+    // engine's active chunks are updated around the cell only, and cycle
+    // detection starts over. Returns false for a bad position or type.
+    bool setCellType(int x, int y, char type);
+
+    // Read-only access to the grid
+    PlaneView types() const { return PlaneView(getGrid(), PLANE_TYPE); }
+    PlaneView population() const { return PlaneView(getGrid(), PLANE_POPULATION); }
+    PlaneView pollution() const { return PlaneView(getGrid(), PLANE_POLLUTION); }
+    const std::vector<std::vector<Cell>> &getGrid() const;
+
+    int getTotalPopulation(char type) const;
+    int getTotalPollution() const;
+
+    // Totals over the inclusive rectangle; corners may be given in any
+    // order. Returns false if it is not inside the region.
+    bool analyzeArea(int x1, int y1, int x2, int y2, AreaStats &stats) const;
+
+    // Keep every step from now on in a HistoryStore so past steps can be
+    // queried; the oldest steps are dropped beyond budgetBytes. Returns
+    // false, leaving history off, if two copies of the grid do not fit.
+    bool enableHistory(int keyframeInterval = HistoryStore::DEFAULT_KEYFRAME_INTERVAL,
+                       size_t budgetBytes = HistoryStore::DEFAULT_BUDGET_BYTES);
+    const HistoryStore *getHistory() const { return history.get(); }
+
+    // Continue a freshly loaded simulation after the steps of a stored run
+    // of the same layout and rules instead of taking them again. taken
+    // summarizes those steps; stored must hold all of them and becomes the
+    // history, without any later steps. Returns false, changing nothing,
+    // if the stored run does not start from the loaded layout.
+    bool resume(std::unique_ptr<HistoryStore> stored, const std::vector<StepSummary> &taken);
+
+    // analyzeArea as of the state after step steps (0 is the loaded layout);
+    // false without history, for a dropped step or a bad area
+    bool analyzeAreaAt(int step, int x1, int y1, int x2, int y2, AreaStats &stats) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStepCount() const { return stepsTaken; }
+    int getAvailableWorkers() const { return availableWorkers; }
+    int getAvailableGoods() const { return availableGoods; }
+    bool hasChanged() const { return changed; }
+    uint64_t getStateHash() const { return stateHash.getHash(); }
+    int getDetectedPeriod() const { return detectedPeriod; }
+
+private:
+    void updatePollution();
+    void handBackToGrid();
+    void updateResources();
+    int recordStateHash();
+    void stepReference();
+    void stepSparse();
+    void stepFixed();
+    void syncGrid() const;
+    void editGrid(int x, int y, char type, StateHash *hash);
+
+    // Refreshed from chunkedGrid or fixedGrid on demand after their steps
+    mutable std::vector<std::vector<Cell>> grid;
+    mutable bool gridStale;
+    int width, height;
+    int totals[3];      // Residential, industrial, commercial population of grid
+    int totalPollution; // Of grid; chunkedGrid keeps its own totals once loaded
+    int availableWorkers;
+    int availableGoods;
+    bool changed; // Track if the region changed during last update
+
+    // Cycle detection over the last cycleWindow state hashes
+    StateHash stateHash;
+    std::deque<uint64_t> hashHistory;
+    int cycleWindow;
+    int detectedPeriod; // > 0 once the state repeats with that period
+
+    StepEngine engine;
+    EngineSelector selector; // Used by ENGINE_ADAPTIVE
+    ChunkedGrid chunkedGrid;
+    bool chunkedGridLoaded;
+    std::unique_ptr<FixedGridEngine> fixedGrid; // Only for sizes with a specialization
+    bool fixedGridLoaded;
+    bool fixedSizeDispatch;
+    int stepsTaken;
+
+    // Changes reported since the last recorded step, while history is on
+    std::unique_ptr<HistoryStore> history;
+    std::vector<CellChange> historyChanges;
+
+    std::unique_ptr<CommuteSystem> commute;
+    std::unique_ptr<LandValue> landValue;
+
+    bool pollutionDeferred;
+    bool pollutionPending; // Growth since the last pollution update
+    long long pollutionNs; // Time spent updating pollution in the current step
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,179 @@
+// Snapshot.cpp
+#include "Snapshot.h"
+#include <algorithm>
+
+const int SnapshotPublisher::MAX_READERS;
+
+Snapshot::Snapshot()
+    : step(0), width(0), height(0), totals{0, 0, 0}, totalPollution(0), availableWorkers(0), availableGoods(0) {}
+
+void Snapshot::build(const Simulation &simulation)
+{
+    const std::vector<std::vector<Cell>> &grid = simulation.getGrid();
+    step = simulation.getStepCount();
+    width = simulation.getWidth();
+    height = simulation.getHeight();
+    availableWorkers = simulation.getAvailableWorkers();
+    availableGoods = simulation.getAvailableGoods();
+    totals[0] = totals[1] = totals[2] = 0;
+    totalPollution = 0;
+
+    sums.assign(static_cast<size_t>(width + 1) * (height + 1), Sums{0, 0, 0, 0});
+    for (int y = 0; y < height; y++)
+    {
+        Sums row = {0, 0, 0, 0};
+        for (int x = 0; x < width; x++)
+        {
+            const Cell &cell = grid[y][x];
+            int pop = cell.getPopulation();
+            switch (cell.getType())
+            {
+            case 'R':
+                row.residential += pop;
+                totals[0] += pop;
+                break;
+            case 'I':
+                row.industrial += pop;
+                totals[1] += pop;
+                break;
+            case 'C':
+                row.commercial += pop;
+                totals[2] += pop;
+                break;
+            }
+            row.pollution += cell.getPollution();
+            totalPollution += cell.getPollution();
+
+            const Sums &above = at(x + 1, y);
+            Sums &sum = sums[static_cast<size_t>(y + 1) * (width + 1) + x + 1];
+            sum.residential = above.residential + row.residential;
+            sum.industrial = above.industrial + row.industrial;
+            sum.commercial = above.commercial + row.commercial;
+            sum.pollution = above.pollution + row.pollution;
+        }
+    }
+}
+
+long long Snapshot::getTotalPopulation(char type) const
+{
+    switch (type)
+    {
+    case 'R':
+        return totals[0];
+    case 'I':
+        return totals[1];
+    case 'C':
+        return totals[2];
+    default:
+        return 0;
+    }
+}
+
+bool Snapshot::analyzeArea(int x1, int y1, int x2, int y2, AreaStats &stats) const
+{
+    if (x1 > x2)
+        std::swap(x1, x2);
+    if (y1 > y2)
+        std::swap(y1, y2);
+    if (x1 < 0 || x2 >= width || y1 < 0 || y2 >= height)
+        return false;
+
+    const Sums &a = at(x2 + 1, y2 + 1);
+    const Sums &b = at(x1, y2 + 1);
+    const Sums &c = at(x2 + 1, y1);
+    const Sums &d = at(x1, y1);
+    stats.residential = static_cast<int>(a.residential - b.residential - c.residential + d.residential);
+    stats.industrial = static_cast<int>(a.industrial - b.industrial - c.industrial + d.industrial);
+    stats.commercial = static_cast<int>(a.commercial - b.commercial - c.commercial + d.commercial);
+    stats.pollution = static_cast<int>(a.pollution - b.pollution - c.pollution + d.pollution);
+    return true;
+}
+
+SnapshotPublisher::SnapshotPublisher() : current(nullptr), epoch(1)
+{
+    for (ReaderSlot &reader : readers)
+    {
+        reader.epoch.store(0);
+        reader.used.store(false);
+    }
+}
+
+// Readers must be gone by now
+SnapshotPublisher::~SnapshotPublisher()
+{
+    delete current.load();
+    for (const auto &entry : retired)
+        delete entry.first;
+    for (Snapshot *snapshot : spare)
+        delete snapshot;
+}
+
+Snapshot *SnapshotPublisher::acquire()
+{
+    reclaim();
+    if (spare.empty())
+        return new Snapshot();
+    Snapshot *snapshot = spare.back();
+    spare.pop_back();
+    return snapshot;
+}
+
+void SnapshotPublisher::publish(Snapshot *snapshot)
+{
+    Snapshot *old = current.exchange(snapshot);
+    // Readers that announce this epoch or later can only see the new snapshot
+    uint64_t retiredIn = epoch.fetch_add(1) + 1;
+    if (old)
+        retired.push_back(std::make_pair(old, retiredIn));
+    reclaim();
+}
+
+// Move retired snapshots that no reader can still hold to the spare list
+void SnapshotPublisher::reclaim()
+{
+    uint64_t oldest = UINT64_MAX;
+    for (const ReaderSlot &reader : readers)
+    {
+        uint64_t seen = reader.epoch.load();
+        if (seen != 0)
+            oldest = std::min(oldest, seen);
+    }
+
+    size_t kept = 0;
+    for (const auto &entry : retired)
+    {
+        if (entry.second <= oldest)
+            spare.push_back(entry.first);
+        else
+            retired[kept++] = entry;
+    }
+    retired.resize(kept);
+}
+
+int SnapshotPublisher::registerReader()
+{
+    for (int slot = 0; slot < MAX_READERS; slot++)
+    {
+        bool expected = false;
+        if (readers[slot].used.compare_exchange_strong(expected, true))
+            return slot;
+    }
+    return -1;
+}
+
+void SnapshotPublisher::unregisterReader(int slot)
+{
+    readers[slot].epoch.store(0);
+    readers[slot].used.store(false);
+}
+
+const Snapshot *SnapshotPublisher::beginRead(int slot)
+{
+    readers[slot].epoch.store(epoch.load());
+    return current.load();
+}
+
+void SnapshotPublisher::endRead(int slot)
+{
+    readers[slot].epoch.store(0);
+}
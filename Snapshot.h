@@ -0,0 +1,95 @@
+// Snapshot.h
+// Immutable per-step copies of a simulation's query results, and an
+// epoch-based publisher that hands them from the stepping thread to reader
+// threads. Readers never take a lock and the stepping thread never waits
+// for them: a replaced snapshot is only reused once no reader that could
+// still hold it remains.
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include "Simulation.h"
+
+// Totals and summed-area tables of one step, so any rectangle is answered
+// in constant time
+class Snapshot
+{
+public:
+    Snapshot();
+
+    // Capture the simulation's current state, reusing this snapshot's memory
+    void build(const Simulation &simulation);
+
+    int getStep() const { return step; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    long long getTotalPopulation(char type) const;
+    long long getTotalPollution() const { return totalPollution; }
+    int getAvailableWorkers() const { return availableWorkers; }
+    int getAvailableGoods() const { return availableGoods; }
+
+    // Same contract as Simulation::analyzeArea
+    bool analyzeArea(int x1, int y1, int x2, int y2, AreaStats &stats) const;
+
+private:
+    // Sums wrap modulo 2^32; a rectangle's total is exact whenever it fits in an int
+    struct Sums
+    {
+        uint32_t residential;
+        uint32_t industrial;
+        uint32_t commercial;
+        uint32_t pollution;
+    };
+
+    const Sums &at(int x, int y) const { return sums[static_cast<size_t>(y) * (width + 1) + x]; }
+
+    int step;
+    int width, height;
+    long long totals[3]; // Residential, industrial, commercial population
+    long long totalPollution;
+    int availableWorkers, availableGoods;
+    std::vector<Sums> sums; // (width + 1) x (height + 1), first row and column zero
+};
+
+class SnapshotPublisher
+{
+public:
+    static const int MAX_READERS = 64;
+
+    SnapshotPublisher();
+    ~SnapshotPublisher();
+
+    // Stepping thread: get a snapshot to fill (recycled when possible),
+    // then make it current. The replaced snapshot is retired.
+    Snapshot *acquire();
+    void publish(Snapshot *snapshot);
+
+    // Reader threads: claim a slot once, then bracket every use of a
+    // snapshot with beginRead/endRead. Returns -1 if all slots are taken.
+    int registerReader();
+    void unregisterReader(int slot);
+    const Snapshot *beginRead(int slot);
+    void endRead(int slot);
+
+private:
+    void reclaim();
+
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<uint64_t> epoch; // Epoch seen when the read began, 0 if idle
+        std::atomic<bool> used;
+    };
+
+    std::atomic<Snapshot *> current;
+    std::atomic<uint64_t> epoch;
+    ReaderSlot readers[MAX_READERS];
+
+    // Stepping thread only
+    std::vector<std::pair<Snapshot *, uint64_t>> retired; // Snapshot and the epoch it was retired in
+    std::vector<Snapshot *> spare;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,58 @@
+// StateHash.cpp
+#include "StateHash.h"
+
+namespace
+{
+    uint64_t splitmix64(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ULL;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+}
+
+StateHash::StateHash() : hash(0), changes(0), changeLog(nullptr) {}
+
+// Keys are derived on the fly instead of stored, so any value range works
+uint64_t StateHash::key(int x, int y, int field, int value)
+{
+    if (value == 0)
+        return 0;
+    uint64_t position = (static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32) | static_cast<uint32_t>(x);
+    return splitmix64(splitmix64(position) ^ (static_cast<uint64_t>(field) << 62) ^ static_cast<uint32_t>(value));
+}
+
+void StateHash::reset(const std::vector<std::vector<Cell>> &grid)
+{
+    hash = 0;
+    changes = 0;
+    for (size_t y = 0; y < grid.size(); y++)
+    {
+        for (size_t x = 0; x < grid[y].size(); x++)
+        {
+            hash ^= key(x, y, FIELD_POPULATION, grid[y][x].getPopulation());
+            hash ^= key(x, y, FIELD_POLLUTION, grid[y][x].getPollution());
+        }
+    }
+}
+
+void StateHash::updatePopulation(int x, int y, int oldPop, int newPop)
+{
+    if (oldPop == newPop)
+        return;
+    hash ^= key(x, y, FIELD_POPULATION, oldPop) ^ key(x, y, FIELD_POPULATION, newPop);
+    changes++;
+    if (changeLog)
+        changeLog->push_back({x, y, FIELD_POPULATION, newPop});
+}
+
+void StateHash::updatePollution(int x, int y, int oldPol, int newPol)
+{
+    if (oldPol == newPol)
+        return;
+    hash ^= key(x, y, FIELD_POLLUTION, oldPol) ^ key(x, y, FIELD_POLLUTION, newPol);
+    changes++;
+    if (changeLog)
+        changeLog->push_back({x, y, FIELD_POLLUTION, newPol});
+}
@@ -0,0 +1,57 @@
+// StateHash.h
+// Incrementally maintained 64-bit Zobrist hash of every cell's population
+// and pollution. The zone systems report each value they change, so the
+// hash and a per-step change count are available without scanning the grid.
+// The reported changes can also be appended to a log.
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Cell.h"
+
+enum CellField
+{
+    FIELD_POPULATION,
+    FIELD_POLLUTION,
+    FIELD_TYPE // Never reported by StateHash; logged by layout edits
+};
+
+// One changed value; later entries for the same cell and field win
+struct CellChange
+{
+    int x, y;
+    int field;
+    int value;
+};
+
+class StateHash
+{
+public:
+    StateHash();
+
+    // Recompute from scratch (zero values contribute nothing)
+    void reset(const std::vector<std::vector<Cell>> &grid);
+
+    void updatePopulation(int x, int y, int oldPop, int newPop);
+    void updatePollution(int x, int y, int oldPol, int newPol);
+
+    uint64_t getHash() const { return hash; }
+
+    // Number of value changes reported since the last clearChanges()
+    long long getChanges() const { return changes; }
+    void clearChanges() { changes = 0; }
+
+    // Append every reported change to log, or stop logging with nullptr
+    void setChangeLog(std::vector<CellChange> *log) { changeLog = log; }
+
+private:
+    static uint64_t key(int x, int y, int field, int value);
+
+    uint64_t hash;
+    long long changes;
+    std::vector<CellChange> *changeLog;
+};
+
+#endif // STATE_HASH_H
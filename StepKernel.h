@@ -0,0 +1,345 @@
+// StepKernel.h
+// Growth and pollution rules evaluated over a shared Layout and a separate
+// population/pollution state. With default RuleParams a step produces the
+// same grid as Region's step. The state type only has to provide
+// getPopulation/setPopulation/getPollution/setPollution by cell index, and
+// must start from a freshly loaded (all zero) state at time step 0.
+#ifndef STEP_KERNEL_H
+#define STEP_KERNEL_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include "Layout.h"
+#include "CounterRng.h"
+
+// Tunable rule parameters (defaults match the project rules)
+struct RuleParams
+{
+    int workersPerCommercial = 1;
+    int goodsPerCommercial = 1;
+    int workersPerIndustrial = 2;
+    int plantPollution = 4;
+
+    // Stochastic mode: below 1, each eligible cell grows only with this
+    // probability, drawn from (seed, time step, x, y)
+    double growthProbability = 1.0;
+    uint64_t seed = 0;
+};
+
+// Per-thread buffers reused between steps
+struct StepScratch
+{
+    struct Candidate
+    {
+        int index;
+        int population;
+        int adjacentPop;
+    };
+    std::vector<Candidate> candidates;
+};
+
+template <typename State>
+class StepKernel
+{
+public:
+    static const int POLLUTION_RADIUS = 3;
+
+    // Advance the state by one time step; returns true if any cell changed
+    // or, in stochastic mode, a cell held back by its draw could have grown
+    static bool step(const Layout &layout, State &state, const RuleParams &rules,
+                     int timeStep, StepScratch &scratch)
+    {
+        int availableWorkers = 0;
+        int availableGoods = 0;
+        for (int index : layout.getZoneCells('R'))
+            availableWorkers += state.getPopulation(index);
+        for (int index : layout.getZoneCells('I'))
+            availableGoods += state.getPopulation(index);
+
+        int grown = 0;
+        bool pending = false;
+
+        // Commercial before industrial, both in priority order
+        int heldBack = collectCandidates(layout, state, 'C', rules, timeStep, scratch);
+        for (const auto &cell : scratch.candidates)
+        {
+            if (availableWorkers >= rules.workersPerCommercial && availableGoods >= rules.goodsPerCommercial)
+            {
+                state.setPopulation(cell.index, cell.population + 1);
+                availableWorkers -= rules.workersPerCommercial;
+                availableGoods -= rules.goodsPerCommercial;
+                grown++;
+            }
+        }
+        pending = pending || (heldBack > 0 && availableWorkers >= rules.workersPerCommercial &&
+                              availableGoods >= rules.goodsPerCommercial);
+
+        heldBack = collectCandidates(layout, state, 'I', rules, timeStep, scratch);
+        for (const auto &cell : scratch.candidates)
+        {
+            if (availableWorkers >= rules.workersPerIndustrial)
+            {
+                state.setPopulation(cell.index, cell.population + 1);
+                spreadPollution(layout, state, cell.index, cell.population, cell.population + 1);
+                availableWorkers -= rules.workersPerIndustrial;
+                availableGoods++;
+                grown++;
+            }
+        }
+        pending = pending || (heldBack > 0 && availableWorkers >= rules.workersPerIndustrial);
+
+        // Residential growth is not resource limited, so no sorting needed
+        scratch.candidates.clear();
+        for (int index : layout.getZoneCells('R'))
+        {
+            if (!canGrow(layout, state, index))
+                continue;
+            if (passesDraw(layout, rules, timeStep, index))
+                scratch.candidates.push_back({index, state.getPopulation(index), 0});
+            else
+                pending = true;
+        }
+        for (const auto &cell : scratch.candidates)
+        {
+            state.setPopulation(cell.index, cell.population + 1);
+            grown++;
+        }
+
+        // Plants pollute from the first step on; industry is handled incrementally above
+        bool plantsChanged = false;
+        if (timeStep == 0 && rules.plantPollution > 0)
+        {
+            for (int index : layout.getPlants())
+            {
+                spreadPollution(layout, state, index, 0, rules.plantPollution);
+                plantsChanged = true;
+            }
+        }
+
+        return grown > 0 || plantsChanged || pending;
+    }
+
+    // Highest population each zone type can reach under the growth rules
+    static int maxPopulation(char type)
+    {
+        switch (type)
+        {
+        case 'R':
+            return 4;
+        case 'I':
+            return 3;
+        case 'C':
+            return 2;
+        default:
+            return 0;
+        }
+    }
+
+    static int countAdjacentPopulation(const Layout &layout, const State &state, int index, int minPop)
+    {
+        int count = 0;
+        uint8_t mask = layout.getSameTypeNeighbours(index);
+        for (int k = 0; mask != 0; k++, mask >>= 1)
+        {
+            if ((mask & 1) && state.getPopulation(layout.neighbourIndex(index, k)) >= minPop)
+                count++;
+        }
+        return count;
+    }
+
+    static bool canGrow(const Layout &layout, const State &state, int index)
+    {
+        int pop = state.getPopulation(index);
+        if (pop >= maxPopulation(layout.getType(index)))
+            return false;
+
+        switch (pop)
+        {
+        case 0:
+            return layout.isPowered(index) || countAdjacentPopulation(layout, state, index, 1) >= 1;
+        case 1:
+            return countAdjacentPopulation(layout, state, index, 1) >= 2;
+        case 2:
+            return countAdjacentPopulation(layout, state, index, 2) >= 4;
+        case 3:
+            return countAdjacentPopulation(layout, state, index, 3) >= 6;
+        default:
+            return false;
+        }
+    }
+
+    // Stochastic mode only: whether an eligible cell gets to grow this step
+    static bool passesDraw(const Layout &layout, const RuleParams &rules, int timeStep, int index)
+    {
+        if (rules.growthProbability >= 1.0)
+            return true;
+        int width = layout.getWidth();
+        return CounterRng::uniform(rules.seed, timeStep, index % width, index / width) < rules.growthProbability;
+    }
+
+    // Apply the change in pollution caused by a source going from oldSource to newSource
+    static void spreadPollution(const Layout &layout, State &state, int index, int oldSource, int newSource)
+    {
+        int width = layout.getWidth();
+        int height = layout.getHeight();
+        int x = index % width;
+        int y = index / width;
+
+        for (int dy = -POLLUTION_RADIUS; dy <= POLLUTION_RADIUS; dy++)
+        {
+            int newY = y + dy;
+            if (newY < 0 || newY >= height)
+                continue;
+            for (int dx = -POLLUTION_RADIUS; dx <= POLLUTION_RADIUS; dx++)
+            {
+                int newX = x + dx;
+                if (newX < 0 || newX >= width)
+                    continue;
+
+                int distance = std::max(std::abs(dx), std::abs(dy));
+                int delta = std::max(0, newSource - distance) - std::max(0, oldSource - distance);
+                if (delta != 0)
+                {
+                    int target = newY * width + newX;
+                    state.setPollution(target, state.getPollution(target) + delta);
+                }
+            }
+        }
+    }
+
+private:
+    // Gather growable cells of one type sorted by the priority rules;
+    // returns the number of eligible cells held back by their draw
+    static int collectCandidates(const Layout &layout, const State &state, char type,
+                                 const RuleParams &rules, int timeStep, StepScratch &scratch)
+    {
+        int heldBack = 0;
+        scratch.candidates.clear();
+        for (int index : layout.getZoneCells(type))
+        {
+            if (!canGrow(layout, state, index))
+                continue;
+            if (!passesDraw(layout, rules, timeStep, index))
+                heldBack++;
+            else
+            {
+                scratch.candidates.push_back({index,
+                                              state.getPopulation(index),
+                                              countAdjacentPopulation(layout, state, index, 1)});
+            }
+        }
+
+        // Population, then adjacent population, then y and x (row-major index)
+        std::sort(scratch.candidates.begin(), scratch.candidates.end(),
+                  [](const StepScratch::Candidate &a, const StepScratch::Candidate &b)
+                  {
+                      if (a.population != b.population)
+                          return a.population > b.population;
+                      if (a.adjacentPop != b.adjacentPop)
+                          return a.adjacentPop > b.adjacentPop;
+                      return a.index < b.index;
+                  });
+        return heldBack;
+    }
+};
+
+// The same rules for engines that resolve priority without a sorted list
+// (TiledSimulation, DomainWorker): candidates are counted per (population,
+// adjacent population) bucket, which fixes a cut-off bucket and how many of
+// its cells, taken in row order, still get resources. typeAt(x, y) and
+// populationAt(x, y) are only asked about cells inside the region.
+struct CandidateBuckets
+{
+    static const int ADJACENT = 9;         // 0..8 populated neighbours
+    static const int COUNT = 4 * ADJACENT; // Keyed by population * 9 + neighbours
+
+    // Priority bucket of the cell at (x, y) if it can grow, else -1;
+    // residential cells are not resource limited and all use bucket 0
+    template <typename TypeAt, typename PopulationAt>
+    static int bucket(int x, int y, int width, int height, TypeAt typeAt, PopulationAt populationAt)
+    {
+        char type = typeAt(x, y);
+        int pop = populationAt(x, y);
+        int maxPop = type == 'R' ? 4 : (type == 'I' ? 3 : 2);
+        if (pop >= maxPop)
+            return -1;
+
+        bool powered = false;
+        int adjacent[4] = {0, 0, 0, 0}; // Same-type neighbours with population >= 1, 2, 3
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            int newY = y + dy;
+            if (newY < 0 || newY >= height)
+                continue;
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int newX = x + dx;
+                if ((dx == 0 && dy == 0) || newX < 0 || newX >= width)
+                    continue;
+
+                char neighbour = typeAt(newX, newY);
+                powered = powered || neighbour == 'T' || neighbour == '#' || neighbour == 'P';
+                if (neighbour == type)
+                {
+                    int neighbourPop = populationAt(newX, newY);
+                    for (int level = 1; level <= 3 && neighbourPop >= level; level++)
+                        adjacent[level]++;
+                }
+            }
+        }
+
+        bool grows = false;
+        switch (pop)
+        {
+        case 0:
+            grows = powered || adjacent[1] >= 1;
+            break;
+        case 1:
+            grows = adjacent[1] >= 2;
+            break;
+        case 2:
+            grows = adjacent[2] >= 4;
+            break;
+        case 3:
+            grows = adjacent[3] >= 6;
+            break;
+        }
+        if (!grows)
+            return -1;
+        return type == 'R' ? 0 : pop * ADJACENT + adjacent[1];
+    }
+
+    // The cut-off bucket when grown candidates get resources, highest
+    // bucket first: buckets above it grow in full and quota receives how
+    // many of its own cells do. -1 if there is no such bucket.
+    static int cutoff(const long long *counts, long long grown, long long &quota)
+    {
+        for (int bucket = COUNT - 1; bucket >= 0; bucket--)
+        {
+            if (counts[bucket] >= grown)
+            {
+                quota = grown;
+                return bucket;
+            }
+            grown -= counts[bucket];
+        }
+        quota = 0;
+        return -1;
+    }
+
+    // Whether a candidate in bucket gets resources; cells of the cut-off
+    // bucket are counted in taken, in row order, up to quota
+    static bool takes(int bucket, int cutoff, long long quota, long long &taken)
+    {
+        if (bucket > cutoff)
+            return true;
+        if (bucket < cutoff || taken >= quota)
+            return false;
+        taken++;
+        return true;
+    }
+};
+
+#endif // STEP_KERNEL_H
@@ -0,0 +1,187 @@
+// SweepRunner.cpp
+#include "SweepRunner.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+
+SweepRunner::SweepRunner(std::shared_ptr<const Layout> layout) : layout(layout) {}
+
+SweepResult SweepRunner::runVariant(const SweepVariant &variant) const
+{
+    VariantState state(layout->getWidth(), layout->getHeight());
+    StepScratch scratch;
+
+    int timeStep = 0;
+    bool hasChanged = true;
+    while (timeStep < variant.maxTimeSteps && hasChanged)
+    {
+        hasChanged = StepKernel<VariantState>::step(*layout, state, variant.rules, timeStep, scratch);
+        timeStep++;
+    }
+
+    SweepResult result = {timeStep, !hasChanged, 0, 0, 0, 0, state.getOwnedBytes()};
+    for (int index : layout->getZoneCells('R'))
+        result.residentialPopulation += state.getPopulation(index);
+    for (int index : layout->getZoneCells('I'))
+        result.industrialPopulation += state.getPopulation(index);
+    for (int index : layout->getZoneCells('C'))
+        result.commercialPopulation += state.getPopulation(index);
+    for (int index = 0; index < layout->getCellCount(); index++)
+        result.totalPollution += state.getPollution(index);
+    return result;
+}
+
+std::vector<SweepResult> SweepRunner::run(const std::vector<SweepVariant> &variants, int threadCount) const
+{
+    std::vector<SweepResult> results(variants.size());
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < variants.size(); i = next++)
+        {
+            results[i] = runVariant(variants[i]);
+        }
+    };
+
+    if (threadCount < 1)
+        threadCount = 1;
+    if (static_cast<size_t>(threadCount) > variants.size())
+        threadCount = variants.size();
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+
+    return results;
+}
+
+// Words of line; the '\r' of a CRLF file counts as whitespace
+static std::vector<std::string> splitWords(const std::string &line)
+{
+    std::istringstream in(line);
+    std::vector<std::string> words;
+    std::string word;
+    while (in >> word)
+        words.push_back(word);
+    return words;
+}
+
+// All of text as one number
+static bool parseNumber(const std::string &text, int &value)
+{
+    std::istringstream in(text);
+    return in >> value && in.peek() == EOF;
+}
+
+bool SweepRunner::loadSweepFile(const std::string &filename, std::string &regionFile,
+                                int &threadCount, std::vector<SweepVariant> &variants)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open sweep file '" << filename << "'" << std::endl;
+        return false;
+    }
+
+    std::getline(file, regionFile);
+    if (!regionFile.empty() && regionFile.back() == '\r')
+        regionFile.pop_back();
+    if (regionFile.empty())
+    {
+        std::cerr << "Error: Region filename cannot be empty" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::getline(file, line);
+    std::vector<std::string> words = splitWords(line);
+    if (words.size() != 1 || !parseNumber(words[0], threadCount) || threadCount <= 0)
+    {
+        std::cerr << "Error: Thread count must be a positive number on sweep line 2" << std::endl;
+        return false;
+    }
+
+    variants.clear();
+    int lineNumber = 2;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        words = splitWords(line);
+        if (words.empty())
+            continue; // blank line
+        if (words.size() != 1 && words.size() != 5)
+        {
+            std::cerr << "Error: Expected 1 or 5 values on sweep line " << lineNumber << std::endl;
+            return false;
+        }
+
+        SweepVariant variant;
+        RuleParams &rules = variant.rules;
+        int *fields[5] = {&variant.maxTimeSteps, &rules.workersPerCommercial, &rules.goodsPerCommercial,
+                          &rules.workersPerIndustrial, &rules.plantPollution};
+        for (size_t field = 0; field < words.size(); field++)
+        {
+            if (!parseNumber(words[field], *fields[field]))
+            {
+                std::cerr << "Error: Invalid value '" << words[field] << "' on sweep line " << lineNumber
+                          << std::endl;
+                return false;
+            }
+        }
+
+        if (variant.maxTimeSteps <= 0 || rules.workersPerCommercial < 0 || rules.goodsPerCommercial < 0 ||
+            rules.workersPerIndustrial < 0 || rules.plantPollution < 0 || rules.plantPollution > MAX_PLANT_POLLUTION)
+        {
+            std::cerr << "Error: Invalid variant on sweep line " << lineNumber << std::endl;
+            return false;
+        }
+        variants.push_back(variant);
+    }
+
+    if (variants.empty())
+    {
+        std::cerr << "Error: Sweep file contains no variants" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SweepRunner::displayResults(const std::vector<SweepVariant> &variants,
+                                 const std::vector<SweepResult> &results) const
+{
+    std::cout << "\nSweep Results (" << layout->getWidth() << "x" << layout->getHeight() << "):" << std::endl;
+    std::cout << std::setw(4) << "#" << std::setw(7) << "Steps" << std::setw(6) << "Rules"
+              << std::setw(12) << "Residential" << std::setw(12) << "Industrial"
+              << std::setw(12) << "Commercial" << std::setw(11) << "Pollution"
+              << std::setw(12) << "State KiB" << std::endl;
+
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const RuleParams &rules = variants[i].rules;
+        const SweepResult &result = results[i];
+        std::stringstream ruleText;
+        ruleText << rules.workersPerCommercial << rules.goodsPerCommercial
+                 << rules.workersPerIndustrial << "/" << rules.plantPollution;
+
+        std::cout << std::setw(4) << i << std::setw(6) << result.steps << (result.converged ? "*" : " ")
+                  << std::setw(6) << ruleText.str()
+                  << std::setw(12) << result.residentialPopulation
+                  << std::setw(12) << result.industrialPopulation
+                  << std::setw(12) << result.commercialPopulation
+                  << std::setw(11) << result.totalPollution
+                  << std::setw(12) << (result.stateBytes + 1023) / 1024 << std::endl;
+        totalBytes += result.stateBytes;
+    }
+
+    std::cout << "(* = no further changes possible; rules = C workers, C goods, I workers / plant pollution)" << std::endl;
+    std::cout << "Shared layout: " << (layout->getMemoryBytes() + 1023) / 1024 << " KiB, "
+              << "variant state: " << (totalBytes + 1023) / 1024 << " KiB total" << std::endl;
+}
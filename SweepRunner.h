@@ -0,0 +1,74 @@
+// SweepRunner.h
+// Runs many simulation variants (rule parameters / step counts) over one
+// region layout. The layout is loaded once and shared read-only; each variant
+// only owns copy-on-write population and pollution tiles.
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "Layout.h"
+#include "CowPlane.h"
+#include "StepKernel.h"
+
+struct SweepVariant
+{
+    int maxTimeSteps;
+    RuleParams rules;
+};
+
+struct SweepResult
+{
+    int steps;
+    bool converged;
+    int residentialPopulation;
+    int industrialPopulation;
+    int commercialPopulation;
+    int totalPollution;
+    size_t stateBytes;
+};
+
+// Mutable per-variant state: populations fit a byte, pollution a short
+class VariantState
+{
+public:
+    VariantState(int width, int height) : population(width, height), pollution(width, height) {}
+
+    int getPopulation(int index) const { return population.get(index); }
+    int getPollution(int index) const { return pollution.get(index); }
+    void setPopulation(int index, int pop) { population.set(index, static_cast<uint8_t>(pop)); }
+    void setPollution(int index, int pol) { pollution.set(index, static_cast<uint16_t>(pol)); }
+
+    size_t getOwnedBytes() const { return population.getOwnedBytes() + pollution.getOwnedBytes(); }
+
+private:
+    CowPlane<uint8_t> population;
+    CowPlane<uint16_t> pollution;
+};
+
+class SweepRunner
+{
+public:
+    // Largest plant pollution that cannot overflow a 16-bit pollution cell
+    static const int MAX_PLANT_POLLUTION = 255;
+
+    explicit SweepRunner(std::shared_ptr<const Layout> layout);
+
+    // Run all variants on up to threadCount threads; results keep variant order
+    std::vector<SweepResult> run(const std::vector<SweepVariant> &variants, int threadCount) const;
+    SweepResult runVariant(const SweepVariant &variant) const;
+
+    // Sweep file: region file, thread count, then one variant per line:
+    // maxTimeSteps [workersPerCommercial goodsPerCommercial workersPerIndustrial plantPollution]
+    static bool loadSweepFile(const std::string &filename, std::string &regionFile,
+                              int &threadCount, std::vector<SweepVariant> &variants);
+    void displayResults(const std::vector<SweepVariant> &variants,
+                        const std::vector<SweepResult> &results) const;
+
+private:
+    std::shared_ptr<const Layout> layout;
+};
+
+#endif // SWEEP_RUNNER_H
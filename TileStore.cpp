@@ -0,0 +1,336 @@
+// TileStore.cpp
+#include "TileStore.h"
+#include "RegionReader.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static const char TILE_MAGIC[8] = {'S', 'C', 'T', 'I', 'L', 'E', 'S', '1'};
+static const std::streamoff HEADER_BYTES = 24; // Magic, width, height, tile size, reserved
+
+const int TileStore::DEFAULT_TILE_SIZE;
+
+TileStore::TileStore()
+    : width(0), height(0), tileSize(0), tilesX(0), tilesY(0), cacheCapacity(0),
+      tileReads(0), tileWrites(0), failed(false)
+{
+}
+
+TileStore::~TileStore()
+{
+    close();
+}
+
+bool TileStore::open(const std::string &name, size_t cacheBytes)
+{
+    close();
+    file.open(name, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open tile file: " << name << std::endl;
+        return false;
+    }
+
+    char magic[8];
+    int32_t header[4];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file || std::memcmp(magic, TILE_MAGIC, sizeof(magic)) != 0 ||
+        header[0] <= 0 || header[1] <= 0 || header[2] <= 0)
+    {
+        std::cerr << "Error: Not a tile file: " << name << std::endl;
+        file.close();
+        return false;
+    }
+
+    filename = name;
+    width = header[0];
+    height = header[1];
+    tileSize = header[2];
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+
+    // A step touches the tile row being read and the one being written back
+    size_t tileBytes = static_cast<size_t>(tileSize) * tileSize * 4;
+    cacheCapacity = std::max(cacheBytes / tileBytes, static_cast<size_t>(2 * tilesX));
+    tileReads = 0;
+    tileWrites = 0;
+    failed = false;
+    return true;
+}
+
+bool TileStore::flush()
+{
+    for (auto &entry : cache)
+    {
+        Tile &tile = *entry.second;
+        if (tile.dirty && writeTile(entry.first, tile))
+            tile.dirty = false;
+    }
+    file.flush();
+    if (!file)
+        failed = true;
+    return !failed;
+}
+
+void TileStore::close()
+{
+    if (file.is_open())
+    {
+        flush();
+        file.close();
+    }
+    cache.clear();
+    lru.clear();
+}
+
+size_t TileStore::getCacheBytes() const
+{
+    return cache.size() * static_cast<size_t>(tileSize) * tileSize * 4;
+}
+
+std::streamoff TileStore::tileOffset(int index) const
+{
+    return HEADER_BYTES + static_cast<std::streamoff>(index) * tileSize * tileSize * 4;
+}
+
+bool TileStore::readTile(int index, Tile &tile)
+{
+    size_t cells = static_cast<size_t>(tileSize) * tileSize;
+    tile.types.resize(cells);
+    tile.population.resize(cells);
+    tile.pollution.resize(cells);
+
+    file.seekg(tileOffset(index));
+    file.read(tile.types.data(), cells);
+    file.read(reinterpret_cast<char *>(tile.population.data()), cells);
+    file.read(reinterpret_cast<char *>(tile.pollution.data()), cells * sizeof(uint16_t));
+    tileReads++;
+    if (!file)
+    {
+        std::cerr << "Error: Cannot read tile " << index << " from " << filename << std::endl;
+        file.clear();
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool TileStore::writeTile(int index, const Tile &tile)
+{
+    size_t cells = static_cast<size_t>(tileSize) * tileSize;
+    file.seekp(tileOffset(index));
+    file.write(tile.types.data(), cells);
+    file.write(reinterpret_cast<const char *>(tile.population.data()), cells);
+    file.write(reinterpret_cast<const char *>(tile.pollution.data()), cells * sizeof(uint16_t));
+    tileWrites++;
+    if (!file)
+    {
+        std::cerr << "Error: Cannot write tile " << index << " to " << filename << std::endl;
+        file.clear();
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+TileStore::Tile &TileStore::fetch(int tileX, int tileY, bool forWrite)
+{
+    int index = tileY * tilesX + tileX;
+    auto found = cache.find(index);
+    if (found != cache.end())
+    {
+        Tile &tile = *found->second;
+        lru.splice(lru.begin(), lru, tile.position);
+        tile.dirty = tile.dirty || forWrite;
+        return tile;
+    }
+
+    // Reuse the least recently used tile's buffers when the cache is full
+    std::unique_ptr<Tile> tile;
+    if (cache.size() >= cacheCapacity)
+    {
+        int victim = lru.back();
+        lru.pop_back();
+        auto evicted = cache.find(victim);
+        tile = std::move(evicted->second);
+        cache.erase(evicted);
+        if (tile->dirty)
+            writeTile(victim, *tile);
+    }
+    else
+    {
+        tile.reset(new Tile());
+    }
+
+    if (!readTile(index, *tile))
+    {
+        std::fill(tile->types.begin(), tile->types.end(), '-');
+        std::fill(tile->population.begin(), tile->population.end(), 0);
+        std::fill(tile->pollution.begin(), tile->pollution.end(), 0);
+    }
+    lru.push_front(index);
+    tile->position = lru.begin();
+    tile->dirty = forWrite;
+
+    Tile &result = *tile;
+    cache[index] = std::move(tile);
+    return result;
+}
+
+void TileStore::readTypes(int y, char *types)
+{
+    int tileY = y / tileSize;
+    size_t rowOffset = static_cast<size_t>(y % tileSize) * tileSize;
+    for (int tileX = 0; tileX < tilesX; tileX++)
+    {
+        const Tile &tile = fetch(tileX, tileY, false);
+        int x0 = tileX * tileSize;
+        int count = std::min(tileSize, width - x0);
+        std::memcpy(types + x0, tile.types.data() + rowOffset, count);
+    }
+}
+
+void TileStore::readPopulation(int y, uint8_t *population)
+{
+    int tileY = y / tileSize;
+    size_t rowOffset = static_cast<size_t>(y % tileSize) * tileSize;
+    for (int tileX = 0; tileX < tilesX; tileX++)
+    {
+        const Tile &tile = fetch(tileX, tileY, false);
+        int x0 = tileX * tileSize;
+        int count = std::min(tileSize, width - x0);
+        std::memcpy(population + x0, tile.population.data() + rowOffset, count);
+    }
+}
+
+void TileStore::readPollution(int y, uint16_t *pollution)
+{
+    int tileY = y / tileSize;
+    size_t rowOffset = static_cast<size_t>(y % tileSize) * tileSize;
+    for (int tileX = 0; tileX < tilesX; tileX++)
+    {
+        const Tile &tile = fetch(tileX, tileY, false);
+        int x0 = tileX * tileSize;
+        int count = std::min(tileSize, width - x0);
+        std::memcpy(pollution + x0, tile.pollution.data() + rowOffset, count * sizeof(uint16_t));
+    }
+}
+
+void TileStore::writePopulation(int y, const uint8_t *population)
+{
+    int tileY = y / tileSize;
+    size_t rowOffset = static_cast<size_t>(y % tileSize) * tileSize;
+    for (int tileX = 0; tileX < tilesX; tileX++)
+    {
+        Tile &tile = fetch(tileX, tileY, true);
+        int x0 = tileX * tileSize;
+        int count = std::min(tileSize, width - x0);
+        std::memcpy(tile.population.data() + rowOffset, population + x0, count);
+    }
+}
+
+void TileStore::writePollution(int y, const uint16_t *pollution)
+{
+    int tileY = y / tileSize;
+    size_t rowOffset = static_cast<size_t>(y % tileSize) * tileSize;
+    for (int tileX = 0; tileX < tilesX; tileX++)
+    {
+        Tile &tile = fetch(tileX, tileY, true);
+        int x0 = tileX * tileSize;
+        int count = std::min(tileSize, width - x0);
+        std::memcpy(tile.pollution.data() + rowOffset, pollution + x0, count * sizeof(uint16_t));
+    }
+}
+
+bool TileStore::convertRegionFile(const std::string &regionFile, const std::string &tileFile, int tileSize)
+{
+    std::ifstream in(regionFile);
+    if (!in)
+    {
+        std::cerr << "Error: Cannot open region file: " << regionFile << std::endl;
+        return false;
+    }
+
+    try
+    {
+        RegionReader reader(in);
+        TileWriter writer(tileFile, reader.getWidth(), reader.getHeight(), tileSize);
+        if (!writer.isOpen())
+            return false;
+
+        std::vector<char> row;
+        for (int y = 0; y < reader.getHeight(); y++)
+        {
+            reader.readRow(y, row);
+            writer.writeRow(row);
+        }
+        return writer.finish();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading region file: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+TileWriter::TileWriter(const std::string &filename, int width, int height, int tileSize)
+    : file(filename, std::ios::binary), width(width), height(height), tileSize(tileSize),
+      tilesX((width + tileSize - 1) / tileSize), rowsWritten(0), bandRows(0)
+{
+    if (!file)
+    {
+        std::cerr << "Error: Cannot write tile file: " << filename << std::endl;
+        return;
+    }
+
+    int32_t header[4] = {width, height, tileSize, 0};
+    file.write(TILE_MAGIC, sizeof(TILE_MAGIC));
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    band.assign(static_cast<size_t>(tileSize) * tilesX * tileSize, '-');
+}
+
+void TileWriter::writeRow(const std::vector<char> &types)
+{
+    std::copy(types.begin(), types.begin() + width,
+              band.begin() + static_cast<size_t>(bandRows) * tilesX * tileSize);
+    bandRows++;
+    rowsWritten++;
+    if (bandRows == tileSize)
+        flushBand();
+}
+
+void TileWriter::flushBand()
+{
+    size_t cells = static_cast<size_t>(tileSize) * tileSize;
+    size_t stride = static_cast<size_t>(tilesX) * tileSize;
+    std::vector<char> tile(cells * 4, 0);
+
+    for (int tileX = 0; tileX < tilesX; tileX++)
+    {
+        // Types first; population and pollution start at zero
+        for (int row = 0; row < tileSize; row++)
+        {
+            std::memcpy(tile.data() + static_cast<size_t>(row) * tileSize,
+                        band.data() + row * stride + static_cast<size_t>(tileX) * tileSize, tileSize);
+        }
+        file.write(tile.data(), tile.size());
+    }
+
+    std::fill(band.begin(), band.end(), '-');
+    bandRows = 0;
+}
+
+bool TileWriter::finish()
+{
+    if (bandRows > 0)
+        flushBand();
+    if (rowsWritten != height)
+    {
+        std::cerr << "Error: Tile file has " << rowsWritten << " of " << height << " rows" << std::endl;
+        return false;
+    }
+    file.flush();
+    return static_cast<bool>(file);
+}
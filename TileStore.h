@@ -0,0 +1,104 @@
+// TileStore.h
+// File-backed region storage for maps larger than memory. The file holds a
+// small header followed by square tiles in row-major order; each tile keeps
+// its cell types, populations and pollution values. Tiles are paged in and
+// out explicitly through a fixed-size LRU cache, and dirty tiles are written
+// back on eviction or flush. Values are stored in host byte order.
+#ifndef TILE_STORE_H
+#define TILE_STORE_H
+
+#include <vector>
+#include <string>
+#include <list>
+#include <memory>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+class TileStore
+{
+public:
+    static const int DEFAULT_TILE_SIZE = 256;
+
+    TileStore();
+    ~TileStore();
+
+    // Open an existing tile file with a cache of about cacheBytes; the cache
+    // always holds at least two rows of tiles
+    bool open(const std::string &filename, size_t cacheBytes);
+    bool flush();
+    void close();
+    bool good() const { return !failed; }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getTileSize() const { return tileSize; }
+    int getTilesX() const { return tilesX; }
+    int getTilesY() const { return tilesY; }
+
+    // Whole-row access across all tiles the row passes through
+    void readTypes(int y, char *types);
+    void readPopulation(int y, uint8_t *population);
+    void readPollution(int y, uint16_t *pollution);
+    void writePopulation(int y, const uint8_t *population);
+    void writePollution(int y, const uint16_t *pollution);
+
+    // Paging statistics since open()
+    long long getTileReads() const { return tileReads; }
+    long long getTileWrites() const { return tileWrites; }
+    size_t getCacheBytes() const;
+
+    // Convert a region layout file into a tile file, streaming one band of
+    // tile rows at a time
+    static bool convertRegionFile(const std::string &regionFile, const std::string &tileFile,
+                                  int tileSize = DEFAULT_TILE_SIZE);
+
+private:
+    struct Tile
+    {
+        std::vector<char> types;
+        std::vector<uint8_t> population;
+        std::vector<uint16_t> pollution;
+        std::list<int>::iterator position; // Place in the LRU order
+        bool dirty;
+    };
+
+    Tile &fetch(int tileX, int tileY, bool forWrite);
+    bool readTile(int index, Tile &tile);
+    bool writeTile(int index, const Tile &tile);
+    std::streamoff tileOffset(int index) const;
+
+    std::fstream file;
+    std::string filename;
+    int width, height, tileSize, tilesX, tilesY;
+    size_t cacheCapacity;
+    std::unordered_map<int, std::unique_ptr<Tile>> cache;
+    std::list<int> lru; // Most recently used first
+    long long tileReads, tileWrites;
+    bool failed;
+
+    friend class TileWriter;
+};
+
+// Writes a tile file row by row with zero population and pollution.
+// Buffers one band of tileSize rows; used by the converter and generator.
+class TileWriter
+{
+public:
+    TileWriter(const std::string &filename, int width, int height, int tileSize);
+
+    bool isOpen() const { return static_cast<bool>(file); }
+    void writeRow(const std::vector<char> &types);
+    bool finish();
+
+private:
+    void flushBand();
+
+    std::ofstream file;
+    int width, height, tileSize, tilesX;
+    int rowsWritten, bandRows;
+    std::vector<char> band; // tileSize rows of tilesX * tileSize types
+};
+
+#endif // TILE_STORE_H
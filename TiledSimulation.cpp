@@ -0,0 +1,277 @@
+// TiledSimulation.cpp
+#include "TiledSimulation.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+
+const int TiledSimulation::RING_ROWS;
+const int TiledSimulation::BUCKETS;
+const int TiledSimulation::POLLUTION_RADIUS;
+const int TiledSimulation::PLANT_POLLUTION;
+
+TiledSimulation::TiledSimulation(TileStore &store)
+    : store(store), width(store.getWidth()), height(store.getHeight()), countsValid(false),
+      totalPollution(0), availableWorkers(0), availableGoods(0)
+{
+    size_t ringCells = static_cast<size_t>(RING_ROWS) * width;
+    types.assign(ringCells, '-');
+    oldPopulation.assign(ringCells, 0);
+    newPopulation.assign(ringCells, 0);
+    pollution.assign(ringCells, 0);
+    storedPollution.assign(width, 0);
+    rowGrew.assign(RING_ROWS, 0);
+    resetCounts();
+}
+
+void TiledSimulation::loadRow(int y)
+{
+    store.readTypes(y, typeRow(y));
+    store.readPopulation(y, oldRow(y));
+}
+
+// Growth rules and priority bucket of (x, y) over the ring rows of population
+int TiledSimulation::candidateBucket(const std::vector<uint8_t> &population, int x, int y)
+{
+    auto typeAt = [this](int cellX, int cellY) { return typeRow(cellY)[cellX]; };
+    auto populationAt = [&](int cellX, int cellY)
+    { return population[(cellY & (RING_ROWS - 1)) * static_cast<size_t>(width) + cellX]; };
+    return CandidateBuckets::bucket(x, y, width, height, typeAt, populationAt);
+}
+
+void TiledSimulation::resetCounts()
+{
+    std::fill(commercialCounts, commercialCounts + BUCKETS, 0);
+    std::fill(industrialCounts, industrialCounts + BUCKETS, 0);
+    totals[0] = totals[1] = totals[2] = 0;
+}
+
+// Record candidates and totals of row y for the next step
+void TiledSimulation::countRow(int y, const std::vector<uint8_t> &population)
+{
+    const char *row = typeRow(y);
+    const uint8_t *popRow = &population[(y & (RING_ROWS - 1)) * static_cast<size_t>(width)];
+    for (int x = 0; x < width; x++)
+    {
+        char type = row[x];
+        if (type == 'R')
+            totals[0] += popRow[x];
+        else if (type == 'C' || type == 'I')
+        {
+            int bucket = candidateBucket(population, x, y);
+            if (type == 'C')
+            {
+                totals[1] += popRow[x];
+                if (bucket >= 0)
+                    commercialCounts[bucket]++;
+            }
+            else
+            {
+                totals[2] += popRow[x];
+                if (bucket >= 0)
+                    industrialCounts[bucket]++;
+            }
+        }
+    }
+}
+
+void TiledSimulation::countAll()
+{
+    resetCounts();
+    totalPollution = 0;
+    for (int y = 0; y <= height; y++)
+    {
+        if (y < height)
+        {
+            loadRow(y);
+            store.readPollution(y, storedPollution.data());
+            for (int x = 0; x < width; x++)
+                totalPollution += storedPollution[x];
+        }
+        if (y > 0)
+            countRow(y - 1, oldPopulation);
+    }
+    countsValid = true;
+}
+
+TiledSimulation::Selection TiledSimulation::select(const long long *counts, long long grown) const
+{
+    Selection selection = {-1, 0, 0};
+    selection.cutoffBucket = CandidateBuckets::cutoff(counts, grown, selection.cutoffQuota);
+    return selection;
+}
+
+bool TiledSimulation::takes(Selection &selection, int bucket) const
+{
+    return CandidateBuckets::takes(bucket, selection.cutoffBucket, selection.cutoffQuota, selection.cutoffTaken);
+}
+
+bool TiledSimulation::growRow(int y, Selection &commercial, Selection &industrial, StateHash *hash)
+{
+    const char *row = typeRow(y);
+    uint8_t *next = newRow(y);
+    std::copy(oldRow(y), oldRow(y) + width, next);
+
+    bool grew = false;
+    for (int x = 0; x < width; x++)
+    {
+        char type = row[x];
+        if (type != 'R' && type != 'C' && type != 'I')
+            continue;
+
+        int bucket = candidateBucket(oldPopulation, x, y);
+        if (bucket < 0)
+            continue;
+        if ((type == 'C' && !takes(commercial, bucket)) || (type == 'I' && !takes(industrial, bucket)))
+            continue;
+
+        next[x]++;
+        grew = true;
+        if (hash)
+            hash->updatePopulation(x, y, next[x] - 1, next[x]);
+        PROFILE_COUNT(COUNTER_CELLS_GROWN, 1);
+        PROFILE_COUNT(COUNTER_VALUES_CHANGED, 1);
+    }
+    return grew;
+}
+
+// Add the pollution of row y's industry and plants to the rows they reach
+void TiledSimulation::spreadRow(int y)
+{
+    const char *row = typeRow(y);
+    const uint8_t *pop = newRow(y);
+    for (int x = 0; x < width; x++)
+    {
+        int source = row[x] == 'I' ? pop[x] : (row[x] == 'P' ? PLANT_POLLUTION : 0);
+        if (source <= 0)
+            continue;
+
+        for (int dy = -POLLUTION_RADIUS; dy <= POLLUTION_RADIUS; dy++)
+        {
+            int newY = y + dy;
+            if (newY < 0 || newY >= height)
+                continue;
+            int *target = pollutionRow(newY);
+            for (int dx = -POLLUTION_RADIUS; dx <= POLLUTION_RADIUS; dx++)
+            {
+                int newX = x + dx;
+                if (newX < 0 || newX >= width)
+                    continue;
+                int distance = std::max(std::abs(dx), std::abs(dy));
+                target[newX] += std::max(0, source - distance);
+            }
+        }
+    }
+}
+
+bool TiledSimulation::writeBackRow(int y, bool populationChanged, StateHash *hash)
+{
+    if (populationChanged)
+        store.writePopulation(y, newRow(y));
+
+    const int *next = pollutionRow(y);
+    store.readPollution(y, storedPollution.data());
+    bool changed = false;
+    for (int x = 0; x < width; x++)
+    {
+        totalPollution += next[x];
+        if (storedPollution[x] == next[x])
+            continue;
+        if (hash)
+            hash->updatePollution(x, y, storedPollution[x], next[x]);
+        PROFILE_COUNT(COUNTER_VALUES_CHANGED, 1);
+        storedPollution[x] = next[x];
+        changed = true;
+    }
+    if (changed)
+        store.writePollution(y, storedPollution.data());
+    return changed;
+}
+
+bool TiledSimulation::step(StateHash *hash)
+{
+    if (!countsValid)
+        countAll();
+
+    // Resources pooled from the previous state, consumed in priority order
+    long long workers = totals[0];
+    long long goods = totals[2];
+    long long candidatesC = 0, candidatesI = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++)
+    {
+        candidatesC += commercialCounts[bucket];
+        candidatesI += industrialCounts[bucket];
+    }
+    PROFILE_COUNT(COUNTER_CANDIDATES, candidatesC + candidatesI);
+
+    long long grownC = std::min(candidatesC, std::min(workers, goods));
+    workers -= grownC;
+    goods -= grownC;
+    long long grownI = std::min(candidatesI, workers / 2);
+    workers -= 2 * grownI;
+    goods += grownI;
+    availableWorkers = workers;
+    availableGoods = goods;
+    PROFILE_COUNT(COUNTER_WORKERS_CONSUMED, grownC + 2 * grownI);
+    PROFILE_COUNT(COUNTER_GOODS_CONSUMED, grownC);
+
+    Selection commercial = select(commercialCounts, grownC);
+    Selection industrial = select(industrialCounts, grownI);
+    resetCounts();
+    totalPollution = 0;
+
+    // Row r is grown from old rows r-1..r+1, row r-1 is counted for the next
+    // step and row r-3 has all its pollution sources and is written back
+    bool changed = false;
+    loadRow(0);
+    for (int r = 0; r < height + POLLUTION_RADIUS; r++)
+    {
+        if (r < height)
+        {
+            if (r + 1 < height)
+                loadRow(r + 1);
+            std::fill(pollutionRow(r + POLLUTION_RADIUS), pollutionRow(r + POLLUTION_RADIUS) + width, 0);
+            if (r == 0)
+            {
+                for (int y = 0; y < POLLUTION_RADIUS; y++)
+                    std::fill(pollutionRow(y), pollutionRow(y) + width, 0);
+            }
+            rowGrew[r & (RING_ROWS - 1)] = growRow(r, commercial, industrial, hash);
+            changed = changed || rowGrew[r & (RING_ROWS - 1)];
+            spreadRow(r);
+        }
+        if (r >= 1 && r <= height)
+            countRow(r - 1, newPopulation);
+
+        int done = r - POLLUTION_RADIUS;
+        if (done >= 0)
+        {
+            bool pollutionChanged = writeBackRow(done, rowGrew[done & (RING_ROWS - 1)], hash);
+            changed = changed || pollutionChanged;
+        }
+    }
+
+    countsValid = true;
+    return changed;
+}
+
+long long TiledSimulation::getTotalPopulation(char type) const
+{
+    return type == 'R' ? totals[0] : (type == 'C' ? totals[1] : (type == 'I' ? totals[2] : 0));
+}
+
+uint64_t TiledSimulation::computeStateHash()
+{
+    StateHash hash;
+    for (int y = 0; y < height; y++)
+    {
+        store.readPopulation(y, oldRow(y));
+        store.readPollution(y, storedPollution.data());
+        const uint8_t *pop = oldRow(y);
+        for (int x = 0; x < width; x++)
+        {
+            hash.updatePopulation(x, y, 0, pop[x]);
+            hash.updatePollution(x, y, 0, storedPollution[x]);
+        }
+    }
+    return hash.getHash();
+}
@@ -0,0 +1,87 @@
+// TiledSimulation.h
+// Out-of-core step engine over a TileStore. Each step makes one pass over
+// the rows in order and keeps only a ring of rows resident: the 1-row
+// neighbourhood around the row being grown and the 3-row pollution radius
+// around the row being written back. Results are identical to Region's
+// reference step.
+//
+// Growth candidates of each zone type depend only on the populations of
+// that type, so all of a step's decisions follow from the previous state.
+// The priority order (population, adjacent population, y, x) is resolved
+// without a sorted list: candidates are counted per (population, adjacent
+// population) bucket, which fixes a cut-off bucket and how many of its
+// cells, taken in row order, still get resources. The counts for the next
+// step are gathered while rows are written back.
+#ifndef TILED_SIMULATION_H
+#define TILED_SIMULATION_H
+
+#include <vector>
+#include <cstdint>
+#include "TileStore.h"
+#include "StateHash.h"
+#include "StepKernel.h"
+
+class TiledSimulation
+{
+public:
+    explicit TiledSimulation(TileStore &store);
+
+    // Advance one time step; returns true if any value changed
+    bool step(StateHash *hash = nullptr);
+
+    // Totals and leftover resources are those after the last step
+    long long getTotalPopulation(char type) const;
+    long long getTotalPollution() const { return totalPollution; }
+    long long getAvailableWorkers() const { return availableWorkers; }
+    long long getAvailableGoods() const { return availableGoods; }
+
+    // Zobrist hash of the stored state, for comparison with Region::getStateHash
+    uint64_t computeStateHash();
+
+private:
+    static const int RING_ROWS = 8; // Power of two covering rows y-4..y+3
+    static const int BUCKETS = CandidateBuckets::COUNT;
+    static const int POLLUTION_RADIUS = 3;
+    static const int PLANT_POLLUTION = 4;
+
+    // Which candidates of one zone type receive resources this step
+    struct Selection
+    {
+        int cutoffBucket; // Buckets above grow in full, buckets below not at all
+        long long cutoffQuota;
+        long long cutoffTaken;
+    };
+
+    char *typeRow(int y) { return &types[(y & (RING_ROWS - 1)) * static_cast<size_t>(width)]; }
+    uint8_t *oldRow(int y) { return &oldPopulation[(y & (RING_ROWS - 1)) * static_cast<size_t>(width)]; }
+    uint8_t *newRow(int y) { return &newPopulation[(y & (RING_ROWS - 1)) * static_cast<size_t>(width)]; }
+    int *pollutionRow(int y) { return &pollution[(y & (RING_ROWS - 1)) * static_cast<size_t>(width)]; }
+
+    void loadRow(int y);
+    int candidateBucket(const std::vector<uint8_t> &population, int x, int y);
+    Selection select(const long long *counts, long long grown) const;
+    bool takes(Selection &selection, int bucket) const;
+    bool growRow(int y, Selection &commercial, Selection &industrial, StateHash *hash);
+    void spreadRow(int y);
+    bool writeBackRow(int y, bool populationChanged, StateHash *hash);
+    void countRow(int y, const std::vector<uint8_t> &population);
+    void resetCounts();
+    void countAll();
+
+    TileStore &store;
+    int width, height;
+    std::vector<char> types;
+    std::vector<uint8_t> oldPopulation, newPopulation;
+    std::vector<int> pollution;
+    std::vector<uint16_t> storedPollution;
+    std::vector<uint8_t> rowGrew; // Per ring row: population needs writing back
+
+    bool countsValid;
+    long long commercialCounts[BUCKETS];
+    long long industrialCounts[BUCKETS];
+    long long totals[3]; // Residential, commercial, industrial population
+    long long totalPollution;
+    long long availableWorkers, availableGoods;
+};
+
+#endif // TILED_SIMULATION_H
@@ -0,0 +1,214 @@
+// TrajectoryCache.cpp
+#include "TrajectoryCache.h"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// File layout: magic, key, step count, one record per step, HistoryStore
+// image, then a checksum of everything before it
+static const char MAGIC[8] = {'S', 'I', 'M', 'T', 'R', 'A', 'J', '2'};
+
+struct StepRecord
+{
+    int32_t changed;
+    int32_t period;
+    int64_t changes;
+    int32_t workers, goods;
+    int32_t workersUsed, goodsUsed;
+    int32_t availableWorkers, availableGoods;
+    int32_t engine; // Engine that ran the step, for adaptive runs
+    int32_t reserved;
+    uint64_t hash;
+};
+
+TrajectoryCache TrajectoryCache::fromEnvironment()
+{
+    const char *directory = std::getenv("SIMCITY_CACHE");
+    return TrajectoryCache(directory ? directory : "");
+}
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static void mix(uint64_t &hash, uint64_t value)
+{
+    // FNV-1a over the bytes of value
+    for (int i = 0; i < 8; i++)
+    {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+}
+
+static uint64_t checksum(const std::string &bytes, size_t length)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t TrajectoryCache::keyFor(const Simulation &simulation)
+{
+    uint64_t hash = FNV_OFFSET;
+    mix(hash, simulation.getWidth());
+    mix(hash, simulation.getHeight());
+    mix(hash, simulation.getCycleWindow());
+    mix(hash, simulation.getCommuteDistance());
+    const LandValue *landValue = simulation.getLandValue();
+    mix(hash, landValue ? 1 : 0);
+    mix(hash, landValue ? landValue->getMinimumValue() : 0);
+
+    PlaneView types = simulation.types();
+    for (int y = 0; y < types.getHeight(); y++)
+    {
+        for (int x = 0; x < types.getWidth(); x++)
+        {
+            hash ^= static_cast<unsigned char>(types(x, y));
+            hash *= FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+std::string TrajectoryCache::pathFor(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.traj", static_cast<unsigned long long>(key));
+    return directory + "/" + name;
+}
+
+static bool readHeader(std::istream &in, uint64_t key, int32_t &steps)
+{
+    char magic[sizeof(MAGIC)];
+    uint64_t storedKey;
+    return in.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), MAGIC) &&
+           in.read(reinterpret_cast<char *>(&storedKey), sizeof(storedKey)) && storedKey == key &&
+           in.read(reinterpret_cast<char *>(&steps), sizeof(steps)) && steps >= 0;
+}
+
+int TrajectoryCache::storedSteps(uint64_t key) const
+{
+    std::ifstream in(pathFor(key), std::ios::binary);
+    int32_t steps;
+    return in && readHeader(in, key, steps) ? steps : -1;
+}
+
+bool TrajectoryCache::resume(Simulation &simulation, int maxSteps, std::vector<StepSummary> &taken) const
+{
+    taken.clear();
+    if (!isEnabled() || simulation.getStepCount() != 0)
+        return false;
+    uint64_t key = keyFor(simulation);
+    std::string path = pathFor(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    std::vector<StepSummary> stored;
+    std::unique_ptr<HistoryStore> history(new HistoryStore());
+    if (!parse(bytes, key, stored, *history))
+    {
+        // Damaged or from another layout with the same key; the next store replaces it
+        std::remove(path.c_str());
+        return false;
+    }
+
+    if (static_cast<int>(stored.size()) > maxSteps)
+        stored.resize(maxSteps);
+    if (stored.empty() || !simulation.resume(std::move(history), stored))
+        return false;
+    taken.swap(stored);
+    return true;
+}
+
+bool TrajectoryCache::parse(const std::string &bytes, uint64_t key, std::vector<StepSummary> &steps,
+                            HistoryStore &history)
+{
+    uint64_t storedChecksum;
+    if (bytes.size() < sizeof(storedChecksum))
+        return false;
+    size_t length = bytes.size() - sizeof(storedChecksum);
+    std::memcpy(&storedChecksum, bytes.data() + length, sizeof(storedChecksum));
+    if (storedChecksum != checksum(bytes, length))
+        return false;
+
+    std::istringstream in(bytes.substr(0, length));
+    int32_t count;
+    if (!readHeader(in, key, count) || static_cast<size_t>(count) > length / sizeof(StepRecord))
+        return false;
+    for (int32_t i = 0; i < count; i++)
+    {
+        StepRecord record;
+        if (!in.read(reinterpret_cast<char *>(&record), sizeof(record)) ||
+            (record.engine != ENGINE_REFERENCE && record.engine != ENGINE_SPARSE))
+            return false;
+        StepSummary summary = {};
+        summary.step = i;
+        summary.changed = record.changed != 0;
+        summary.period = record.period;
+        summary.changes = record.changes;
+        summary.workers = record.workers;
+        summary.goods = record.goods;
+        summary.workersUsed = record.workersUsed;
+        summary.goodsUsed = record.goodsUsed;
+        summary.availableWorkers = record.availableWorkers;
+        summary.availableGoods = record.availableGoods;
+        summary.engine = static_cast<StepEngine>(record.engine);
+        summary.hash = record.hash;
+        steps.push_back(summary);
+    }
+    return history.read(in) && history.getNewestStep() == count && in.peek() == EOF;
+}
+
+bool TrajectoryCache::store(const Simulation &simulation, const std::vector<StepSummary> &taken) const
+{
+    const HistoryStore *history = simulation.getHistory();
+    if (!isEnabled() || !history || !history->hasStep(0) ||
+        history->getNewestStep() != static_cast<int>(taken.size()))
+        return false;
+    uint64_t key = keyFor(simulation);
+    if (storedSteps(key) >= static_cast<int>(taken.size()))
+        return false;
+
+    std::ostringstream out;
+    int32_t steps = taken.size();
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(&key), sizeof(key));
+    out.write(reinterpret_cast<const char *>(&steps), sizeof(steps));
+    for (const StepSummary &summary : taken)
+    {
+        StepRecord record = {summary.changed ? 1 : 0, summary.period, summary.changes,
+                             summary.workers, summary.goods, summary.workersUsed, summary.goodsUsed,
+                             summary.availableWorkers, summary.availableGoods, summary.engine, 0, summary.hash};
+        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+    history->write(out);
+    std::string bytes = out.str();
+    uint64_t sum = checksum(bytes, bytes.size());
+    bytes.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+
+    // Write a temporary file and rename it, so concurrent runs never read a partial file
+    std::string path = pathFor(key);
+    std::string temporary = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.write(bytes.data(), bytes.size()))
+        {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,52 @@
+// TrajectoryCache.h
+// On-disk cache of simulated runs, so a layout that was simulated before
+// only needs stepping past the longest stored prefix of its trajectory.
+// Files are named by a hash of the layout and of the settings that change
+// results (commute distance, minimum land value and cycle window); the
+// engine is not part of the key since all engines agree. A file holds the
+// summary of every step, including the engine that ran it, and the run's
+// HistoryStore, so every stored step can be shown, queried and resumed from
+// without simulating it.
+#ifndef TRAJECTORY_CACHE_H
+#define TRAJECTORY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Simulation.h"
+
+class TrajectoryCache
+{
+public:
+    // An empty directory turns the cache off
+    explicit TrajectoryCache(const std::string &directory) : directory(directory) {}
+
+    // The directory named by SIMCITY_CACHE, or none
+    static TrajectoryCache fromEnvironment();
+
+    bool isEnabled() const { return !directory.empty(); }
+
+    // Key of the trajectory a freshly loaded simulation will follow
+    static uint64_t keyFor(const Simulation &simulation);
+
+    // Resume a freshly loaded simulation after the stored steps, at most
+    // maxSteps of them; taken receives their summaries. False if nothing
+    // usable is stored, leaving the simulation as it was.
+    bool resume(Simulation &simulation, int maxSteps, std::vector<StepSummary> &taken) const;
+
+    // Store the run so far, whose steps are summarized in taken, unless a
+    // run at least as long is stored already or the history no longer
+    // reaches back to the loaded layout
+    bool store(const Simulation &simulation, const std::vector<StepSummary> &taken) const;
+
+private:
+    std::string pathFor(uint64_t key) const;
+    static bool parse(const std::string &bytes, uint64_t key, std::vector<StepSummary> &steps, HistoryStore &history);
+
+    // Number of steps in the stored trajectory, or -1
+    int storedSteps(uint64_t key) const;
+
+    std::string directory;
+};
+
+#endif // TRAJECTORY_CACHE_H
@@ -0,0 +1,207 @@
+// Transport.cpp
+#include "Transport.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+const int SharedMemoryChannel::SLOTS;
+const int SharedMemoryChannel::SLOT_BYTES;
+
+std::unique_ptr<Channel> Channel::create(const std::string &transport)
+{
+    if (transport == "socket")
+    {
+        std::unique_ptr<SocketChannel> channel(new SocketChannel());
+        if (channel->isOpen())
+            return channel;
+    }
+    else if (transport == "shm")
+    {
+        std::unique_ptr<SharedMemoryChannel> channel(new SharedMemoryChannel());
+        if (channel->isOpen())
+            return channel;
+    }
+    else
+    {
+        std::cerr << "Error: Unknown transport: " << transport << std::endl;
+        return nullptr;
+    }
+
+    std::cerr << "Error: Cannot create " << transport << " channel: " << std::strerror(errno) << std::endl;
+    return nullptr;
+}
+
+bool Channel::isValidTransport(const std::string &transport)
+{
+    return transport == "socket" || transport == "shm";
+}
+
+SocketChannel::SocketChannel() : fd(-1)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        fds[0] = fds[1] = -1;
+}
+
+SocketChannel::~SocketChannel()
+{
+    detach();
+}
+
+void SocketChannel::attach(int side)
+{
+    fd = fds[side];
+    ::close(fds[1 - side]);
+    fds[1 - side] = -1;
+}
+
+void SocketChannel::detach()
+{
+    for (int side = 0; side < 2; side++)
+    {
+        if (fds[side] >= 0)
+            ::close(fds[side]);
+        fds[side] = -1;
+    }
+    fd = -1;
+}
+
+bool SocketChannel::send(const void *data, size_t bytes)
+{
+    const char *next = static_cast<const char *>(data);
+    while (bytes > 0)
+    {
+        ssize_t written = ::send(fd, next, bytes, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        next += written;
+        bytes -= written;
+    }
+    return true;
+}
+
+bool SocketChannel::receive(void *data, size_t bytes)
+{
+    char *next = static_cast<char *>(data);
+    while (bytes > 0)
+    {
+        ssize_t received = ::recv(fd, next, bytes, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        next += received;
+        bytes -= received;
+    }
+    return true;
+}
+
+struct SharedMemoryChannel::Ring
+{
+    sem_t filled; // Slots ready to read
+    sem_t empty;  // Slots ready to write
+    uint32_t sizes[SLOTS];
+    char slots[SLOTS][SLOT_BYTES];
+};
+
+struct SharedMemoryChannel::Shared
+{
+    Ring rings[2]; // rings[side] carries data sent from that side
+};
+
+static void waitSemaphore(sem_t *semaphore)
+{
+    while (sem_wait(semaphore) != 0 && errno == EINTR)
+    {
+    }
+}
+
+SharedMemoryChannel::SharedMemoryChannel() : shared(nullptr), side(0), writeSlot(0), readSlot(0), readOffset(0)
+{
+    void *memory = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return;
+
+    shared = static_cast<Shared *>(memory);
+    for (Ring &ring : shared->rings)
+    {
+        sem_init(&ring.filled, 1, 0);
+        sem_init(&ring.empty, 1, SLOTS);
+    }
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+    detach();
+}
+
+void SharedMemoryChannel::attach(int newSide)
+{
+    side = newSide;
+}
+
+void SharedMemoryChannel::detach()
+{
+    if (shared)
+        munmap(shared, sizeof(Shared));
+    shared = nullptr;
+}
+
+bool SharedMemoryChannel::send(const void *data, size_t bytes)
+{
+    if (!shared)
+        return false;
+
+    Ring &ring = shared->rings[side];
+    const char *next = static_cast<const char *>(data);
+    while (bytes > 0)
+    {
+        size_t chunk = std::min(bytes, static_cast<size_t>(SLOT_BYTES));
+        waitSemaphore(&ring.empty);
+        std::memcpy(ring.slots[writeSlot], next, chunk);
+        ring.sizes[writeSlot] = chunk;
+        sem_post(&ring.filled);
+
+        writeSlot = (writeSlot + 1) % SLOTS;
+        next += chunk;
+        bytes -= chunk;
+    }
+    return true;
+}
+
+bool SharedMemoryChannel::receive(void *data, size_t bytes)
+{
+    if (!shared)
+        return false;
+
+    Ring &ring = shared->rings[1 - side];
+    char *next = static_cast<char *>(data);
+    while (bytes > 0)
+    {
+        // Wait for a new slot only once the current one is used up
+        if (readOffset == 0)
+            waitSemaphore(&ring.filled);
+
+        size_t available = ring.sizes[readSlot] - readOffset;
+        size_t chunk = std::min(bytes, available);
+        std::memcpy(next, ring.slots[readSlot] + readOffset, chunk);
+        readOffset += chunk;
+        next += chunk;
+        bytes -= chunk;
+
+        if (readOffset == ring.sizes[readSlot])
+        {
+            sem_post(&ring.empty);
+            readSlot = (readSlot + 1) % SLOTS;
+            readOffset = 0;
+        }
+    }
+    return true;
+}
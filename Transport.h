@@ -0,0 +1,81 @@
+// Transport.h
+// Point-to-point byte channels between the processes of a distributed run.
+// A channel is created before fork(); each process that uses it then
+// attaches to one of its two ends, and every other process detaches.
+// Sends block while the peer's buffer is full, so peers must agree on the
+// order of their sends and receives.
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+class Channel
+{
+public:
+    virtual ~Channel() {}
+
+    // Use end 0 or 1 in this process
+    virtual void attach(int side) = 0;
+
+    // Release both ends in a process that does not use this channel
+    virtual void detach() = 0;
+
+    // Transfer exactly bytes; false if the peer is gone
+    virtual bool send(const void *data, size_t bytes) = 0;
+    virtual bool receive(void *data, size_t bytes) = 0;
+
+    // "socket" (Unix domain socket pair) or "shm" (shared memory ring);
+    // returns null and prints an error on failure
+    static std::unique_ptr<Channel> create(const std::string &transport);
+    static bool isValidTransport(const std::string &transport);
+};
+
+class SocketChannel : public Channel
+{
+public:
+    SocketChannel();
+    ~SocketChannel();
+
+    bool isOpen() const { return fds[0] >= 0; }
+    void attach(int side);
+    void detach();
+    bool send(const void *data, size_t bytes);
+    bool receive(void *data, size_t bytes);
+
+private:
+    int fds[2];
+    int fd; // The attached end
+};
+
+// Two single-producer, single-consumer rings of fixed-size slots in
+// anonymous shared memory, one per direction, guarded by process-shared
+// semaphores. A crashed peer is not detected here; the coordinator's
+// socket control channel takes care of that.
+class SharedMemoryChannel : public Channel
+{
+public:
+    static const int SLOTS = 16;
+    static const int SLOT_BYTES = 16 * 1024;
+
+    SharedMemoryChannel();
+    ~SharedMemoryChannel();
+
+    bool isOpen() const { return shared != nullptr; }
+    void attach(int side);
+    void detach();
+    bool send(const void *data, size_t bytes);
+    bool receive(void *data, size_t bytes);
+
+private:
+    struct Ring;
+    struct Shared;
+
+    Shared *shared;
+    int side;
+    int writeSlot, readSlot;
+    size_t readOffset; // Bytes of readSlot already consumed
+};
+
+#endif // TRANSPORT_H
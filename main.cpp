@@ -1,188 +1,328 @@
-// SimCity Project - Team 8
-/*
-Arnav Verma     - av0967
-Donovan Smith   -
-Rishi Parekh    -
-Aditya Moturi   -
-
-*/
-
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <limits>
-#include "Region.h"
-
-void clearInputBuffer()
-{
-    std::cin.clear();
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-}
-
-bool verifyConfigFile(const std::string &filename,
-                      std::string &regionFile,
-                      int &maxSteps,
-                      int &refreshRate)
-{
-    std::ifstream file(filename);
-    if (!file)
-    {
-        std::cerr << "Error: Cannot open configuration file '" << filename << "'" << std::endl;
-        return false;
-    }
-
-    // Read and verify region filename
-    std::getline(file, regionFile);
-    if (regionFile.empty())
-    {
-        std::cerr << "Error: Region filename cannot be empty" << std::endl;
-        return false;
-    }
-
-    // Read and verify max steps and refresh rate
-    if (!(file >> maxSteps >> refreshRate))
-    {
-        std::cerr << "Error: Invalid format for max steps or refresh rate" << std::endl;
-        return false;
-    }
-
-    if (maxSteps <= 0)
-    {
-        std::cerr << "Error: Maximum time steps must be positive" << std::endl;
-        return false;
-    }
-
-    if (refreshRate <= 0)
-    {
-        std::cerr << "Error: Refresh rate must be positive" << std::endl;
-        return false;
-    }
-
-    if (refreshRate > maxSteps)
-    {
-        std::cerr << "Error: Refresh rate cannot be larger than maximum time steps" << std::endl;
-        return false;
-    }
-
-    file.close();
-    return true;
-}
-
-void runSimulation()
-{
-    std::string configFilename;
-    bool validConfig = false;
-    Region region;
-
-    while (!validConfig)
-    {
-        std::cout << "\nEnter configuration file name (or 'quit' to return to menu): ";
-        std::getline(std::cin, configFilename);
-
-        if (configFilename == "quit")
-        {
-            return;
-        }
-
-        std::string regionFilename;
-        int maxTimeSteps, refreshRate;
-
-        if (verifyConfigFile(configFilename, regionFilename, maxTimeSteps, refreshRate))
-        {
-            if (region.loadFromFile(regionFilename))
-            {
-                // Run simulation
-                region.simulate(maxTimeSteps, refreshRate);
-
-                // Area analysis
-                bool validArea = false;
-                while (!validArea)
-                {
-                    std::cout << "\nEnter coordinates for area analysis (x1 y1 x2 y2): ";
-                    int x1, y1, x2, y2;
-
-                    if (std::cin >> x1 >> y1 >> x2 >> y2)
-                    {
-                        region.analyzeArea(x1, y1, x2, y2);
-                        validArea = true;
-                    }
-                    else
-                    {
-                        std::cerr << "Error: Please enter four numbers separated by spaces" << std::endl;
-                        clearInputBuffer();
-                    }
-                }
-                clearInputBuffer();
-                validConfig = true;
-            }
-        }
-
-        if (!validConfig)
-        {
-            std::cout << "Would you like to try again? (y/n): ";
-            std::string response;
-            std::getline(std::cin, response);
-            if (response != "y" && response != "Y")
-            {
-                return;
-            }
-        }
-    }
-}
-
-void displayBanner()
-{
-    std::cout << "\n";
-    std::cout << "+--------------------------------------------+" << std::endl;
-    std::cout << "|              SimCity - Group 8             |" << std::endl;
-    std::cout << "|                                            |" << std::endl;
-    std::cout << "|          City Simulation Project           |" << std::endl;
-    std::cout << "|               CSCE 2110.501                |" << std::endl;
-    std::cout << "|              ----------------              |" << std::endl;
-    std::cout << "|          Arnav Verma, Rishi Parekh         |" << std::endl;
-    std::cout << "|         Donovan Smith, Aditya Moturi       | " << std::endl;
-    std::cout << "+--------------------------------------------+" << std::endl;
-    std::cout << "\n";
-}
-
-void displayMenu()
-{
-    std::cout << "\n=== Main Menu ===" << std::endl;
-    std::cout << "1. Run new simulation" << std::endl;
-    std::cout << "2. Exit program" << std::endl;
-    std::cout << "\nEnter your choice (1-2): ";
-}
-
-int main()
-{
-    displayBanner(); // Show the banner at startup
-
-    std::string input;
-    bool running = true;
-
-    while (running)
-    {
-        displayMenu();
-        std::getline(std::cin, input);
-
-        if (input == "1")
-        {
-            runSimulation();
-        }
-        else if (input == "2")
-        {
-            std::cout << "\n+--------------------------------------------+" << std::endl;
-            std::cout << "|        Thank you for using SimCity!         |" << std::endl;
-            std::cout << "|              See you again!                 |" << std::endl;
-            std::cout << "+---------------------------------------------+\n"
-                      << std::endl;
-            running = false;
-        }
-        else
-        {
-            std::cout << "Invalid choice. Please enter 1 or 2." << std::endl;
-        }
-    }
-
-    return 0;
+// SimCity Project - Team 8
+/*
+Arnav Verma     - av0967
+Donovan Smith   -
+Rishi Parekh    -
+Aditya Moturi   -
+
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <limits>
+#include <sstream>
+#include "Region.h"
+#include "SweepRunner.h"
+
+void clearInputBuffer()
+{
+    std::cin.clear();
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
+
+// All of text as one value. Optional config lines are read as words, so a
+// malformed line is reported rather than failing every later read.
+template <typename T>
+bool parseConfigValue(const std::string &text, T &value)
+{
+    std::istringstream in(text);
+    return in >> value && in.peek() == EOF;
+}
+
+bool verifyConfigFile(const std::string &filename,
+                      std::string &regionFile,
+                      int &maxSteps,
+                      int &refreshRate,
+                      int &cycleWindow,
+                      StepEngine &engine,
+                      int &commuteDistance,
+                      bool &useLandValue,
+                      int &minimumLandValue,
+                      double &ticksPerSecond)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open configuration file '" << filename << "'" << std::endl;
+        return false;
+    }
+
+    // Read and verify region filename
+    std::getline(file, regionFile);
+    if (regionFile.empty())
+    {
+        std::cerr << "Error: Region filename cannot be empty" << std::endl;
+        return false;
+    }
+
+    // Read and verify max steps and refresh rate
+    if (!(file >> maxSteps >> refreshRate))
+    {
+        std::cerr << "Error: Invalid format for max steps or refresh rate" << std::endl;
+        return false;
+    }
+
+    if (maxSteps <= 0)
+    {
+        std::cerr << "Error: Maximum time steps must be positive" << std::endl;
+        return false;
+    }
+
+    if (refreshRate <= 0)
+    {
+        std::cerr << "Error: Refresh rate must be positive" << std::endl;
+        return false;
+    }
+
+    if (refreshRate > maxSteps)
+    {
+        std::cerr << "Error: Refresh rate cannot be larger than maximum time steps" << std::endl;
+        return false;
+    }
+
+    // Optional fourth line: how many past steps to search for repeating states
+    cycleWindow = Region::DEFAULT_CYCLE_WINDOW;
+    std::string cycleWindowText;
+    if (file >> cycleWindowText && !parseConfigValue(cycleWindowText, cycleWindow))
+    {
+        std::cerr << "Error: Invalid cycle window '" << cycleWindowText << "'" << std::endl;
+        return false;
+    }
+    if (cycleWindow <= 0)
+    {
+        std::cerr << "Error: Cycle window must be positive" << std::endl;
+        return false;
+    }
+
+    // Optional fifth line: step engine (reference or sparse)
+    engine = ENGINE_REFERENCE;
+    std::string engineName;
+    if (file >> engineName && !Region::parseEngine(engineName, engine))
+    {
+        std::cerr << "Error: Unknown engine '" << engineName << "'" << std::endl;
+        return false;
+    }
+
+    // Optional sixth line: commute distance over roads (0 shares workers region-wide)
+    commuteDistance = 0;
+    std::string commuteText;
+    if (file >> commuteText && !parseConfigValue(commuteText, commuteDistance))
+    {
+        std::cerr << "Error: Invalid commute distance '" << commuteText << "'" << std::endl;
+        return false;
+    }
+    if (commuteDistance < 0)
+    {
+        std::cerr << "Error: Commute distance cannot be negative" << std::endl;
+        return false;
+    }
+
+    // Optional seventh line: minimum land value for growth, or "off"
+    useLandValue = false;
+    std::string landValueText;
+    if (file >> landValueText && landValueText != "off")
+    {
+        if (!parseConfigValue(landValueText, minimumLandValue))
+        {
+            std::cerr << "Error: Invalid minimum land value '" << landValueText << "'" << std::endl;
+            return false;
+        }
+        useLandValue = true;
+    }
+
+    // Optional eighth line: ticks per second for a real-time run (0 runs flat out)
+    ticksPerSecond = 0;
+    std::string tickRateText;
+    if (file >> tickRateText && !parseConfigValue(tickRateText, ticksPerSecond))
+    {
+        std::cerr << "Error: Invalid tick rate '" << tickRateText << "'" << std::endl;
+        return false;
+    }
+    if (ticksPerSecond < 0)
+    {
+        std::cerr << "Error: Tick rate cannot be negative" << std::endl;
+        return false;
+    }
+
+    // Anything after the last optional line is a mistake, not a comment
+    std::string extra;
+    if (file >> extra)
+    {
+        std::cerr << "Error: Unexpected '" << extra << "' after the last configuration line" << std::endl;
+        return false;
+    }
+
+    file.close();
+    return true;
+}
+
+void runSimulation()
+{
+    std::string configFilename;
+    bool validConfig = false;
+    Region region;
+
+    while (!validConfig)
+    {
+        std::cout << "\nEnter configuration file name (or 'quit' to return to menu): ";
+        std::getline(std::cin, configFilename);
+
+        if (configFilename == "quit")
+        {
+            return;
+        }
+
+        std::string regionFilename;
+        int maxTimeSteps, refreshRate, cycleWindow, commuteDistance, minimumLandValue;
+        bool useLandValue;
+        double ticksPerSecond;
+        StepEngine engine;
+
+        if (verifyConfigFile(configFilename, regionFilename, maxTimeSteps, refreshRate, cycleWindow, engine,
+                             commuteDistance, useLandValue, minimumLandValue, ticksPerSecond))
+        {
+            if (region.loadFromFile(regionFilename))
+            {
+                region.setCycleWindow(cycleWindow);
+                region.setEngine(engine);
+                region.setCommuteDistance(commuteDistance);
+                if (useLandValue)
+                    region.setMinimumLandValue(minimumLandValue);
+
+                // Run simulation
+                region.simulate(maxTimeSteps, refreshRate, ticksPerSecond);
+
+                // Area analysis
+                bool validArea = false;
+                while (!validArea)
+                {
+                    std::cout << "\nEnter coordinates for area analysis (x1 y1 x2 y2 [time step]): ";
+                    int x1, y1, x2, y2;
+
+                    if (std::cin >> x1 >> y1 >> x2 >> y2)
+                    {
+                        // An optional fifth number asks about an earlier time step
+                        std::string rest;
+                        std::getline(std::cin, rest);
+                        std::istringstream extra(rest);
+                        int timeStep;
+                        if (!(extra >> timeStep))
+                            timeStep = -1;
+                        region.analyzeArea(x1, y1, x2, y2, timeStep);
+                        validArea = true;
+                    }
+                    else
+                    {
+                        std::cerr << "Error: Please enter four numbers separated by spaces" << std::endl;
+                        clearInputBuffer();
+                    }
+                }
+                validConfig = true;
+            }
+        }
+
+        if (!validConfig)
+        {
+            std::cout << "Would you like to try again? (y/n): ";
+            std::string response;
+            std::getline(std::cin, response);
+            if (response != "y" && response != "Y")
+            {
+                return;
+            }
+        }
+    }
+}
+
+void runSweep()
+{
+    std::cout << "\nEnter sweep file name (or 'quit' to return to menu): ";
+    std::string sweepFilename;
+    std::getline(std::cin, sweepFilename);
+    if (sweepFilename == "quit")
+    {
+        return;
+    }
+
+    std::string regionFilename;
+    int threadCount;
+    std::vector<SweepVariant> variants;
+    if (!SweepRunner::loadSweepFile(sweepFilename, regionFilename, threadCount, variants))
+    {
+        return;
+    }
+
+    // Layout is loaded once and shared by every variant
+    std::shared_ptr<const Layout> layout = Layout::load(regionFilename);
+    if (!layout)
+    {
+        return;
+    }
+
+    SweepRunner runner(layout);
+    std::vector<SweepResult> results = runner.run(variants, threadCount);
+    runner.displayResults(variants, results);
+}
+
+void displayBanner()
+{
+    std::cout << "\n";
+    std::cout << "+--------------------------------------------+" << std::endl;
+    std::cout << "|              SimCity - Group 8             |" << std::endl;
+    std::cout << "|                                            |" << std::endl;
+    std::cout << "|          City Simulation Project           |" << std::endl;
+    std::cout << "|               CSCE 2110.501                |" << std::endl;
+    std::cout << "|              ----------------              |" << std::endl;
+    std::cout << "|          Arnav Verma, Rishi Parekh         |" << std::endl;
+    std::cout << "|         Donovan Smith, Aditya Moturi       | " << std::endl;
+    std::cout << "+--------------------------------------------+" << std::endl;
+    std::cout << "\n";
+}
+
+void displayMenu()
+{
+    std::cout << "\n=== Main Menu ===" << std::endl;
+    std::cout << "1. Run new simulation" << std::endl;
+    std::cout << "2. Exit program" << std::endl;
+    std::cout << "3. Run parameter sweep" << std::endl;
+    std::cout << "\nEnter your choice (1-3): ";
+}
+
+int main()
+{
+    displayBanner(); // Show the banner at startup
+
+    std::string input;
+    bool running = true;
+
+    while (running)
+    {
+        displayMenu();
+        std::getline(std::cin, input);
+
+        if (input == "1")
+        {
+            runSimulation();
+        }
+        else if (input == "2")
+        {
+            std::cout << "\n+--------------------------------------------+" << std::endl;
+            std::cout << "|        Thank you for using SimCity!         |" << std::endl;
+            std::cout << "|              See you again!                 |" << std::endl;
+            std::cout << "+---------------------------------------------+\n"
+                      << std::endl;
+            running = false;
+        }
+        else if (input == "3")
+        {
+            runSweep();
+        }
+        else
+        {
+            std::cout << "Invalid choice. Please enter 1, 2 or 3." << std::endl;
+        }
+    }
+
+    return 0;
 }
\ No newline at end of file
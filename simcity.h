@@ -0,0 +1,156 @@
+/* simcity.h
+ * C interface to the simulation engine, for programs that are not written
+ * in C++. Build libsimcity.so with make and link against it; see
+ * tools/capi_demo.c for a complete client.
+ *
+ * All functions that can fail return SIMCITY_OK or an error code, and the
+ * message of the last failure on a handle is available from
+ * simcity_last_error. Handles are not thread-safe; snapshots are immutable
+ * and may be read from any thread.
+ *
+ * The ABI is stable within a major version: functions and struct fields
+ * are only ever added at the end, and SIMCITY_ABI_VERSION changes when
+ * anything else does. Structs the caller passes in start with struct_size,
+ * which the caller sets to sizeof the struct; the library rejects sizes
+ * below this version's and writes no further than struct_size, so a
+ * client built against an older header keeps working.
+ */
+#ifndef SIMCITY_C_H
+#define SIMCITY_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIMCITY_ABI_VERSION 2
+
+/* The library is built with hidden visibility; only these functions are exported */
+#if defined(__GNUC__)
+#define SIMCITY_API __attribute__((visibility("default")))
+#else
+#define SIMCITY_API
+#endif
+
+enum
+{
+    SIMCITY_OK = 0,
+    SIMCITY_ERROR_ARGUMENT = 1, /* Bad handle, position, name or value */
+    SIMCITY_ERROR_LOAD = 2,     /* Region file missing or malformed */
+    SIMCITY_ERROR_STATE = 3,    /* Nothing loaded, or history is off */
+    SIMCITY_ERROR_INTERNAL = 4  /* Out of memory or another unexpected failure */
+};
+
+typedef enum
+{
+    SIMCITY_PLANE_TYPE = 0,       /* Cell type characters, 1 byte per cell */
+    SIMCITY_PLANE_POPULATION = 1, /* int32_t per cell */
+    SIMCITY_PLANE_POLLUTION = 2   /* int32_t per cell */
+} simcity_plane_field;
+
+typedef struct simcity_sim simcity_sim;
+typedef struct simcity_snapshot simcity_snapshot;
+
+typedef struct
+{
+    uint32_t struct_size; /* sizeof(simcity_step_summary), set by the caller */
+    int32_t step;         /* Index of the step, counted from the load */
+    int32_t changed; /* Nonzero if any population or pollution value changed */
+    int32_t period;  /* > 0 if the state repeats with this period */
+    int32_t workers; /* Resources at the start of the step */
+    int32_t goods;
+    int32_t workers_used;
+    int32_t goods_used;
+    int32_t available_workers; /* Resources left over after the step */
+    int32_t available_goods;
+    int64_t changes;     /* Population and pollution values changed */
+    int64_t duration_ns; /* Wall time of the step */
+    uint64_t hash;       /* State hash after the step */
+} simcity_step_summary;
+
+typedef struct
+{
+    uint32_t struct_size; /* sizeof(simcity_area), set by the caller */
+    int64_t residential;
+    int64_t industrial;
+    int64_t commercial;
+    int64_t pollution;
+} simcity_area;
+
+/* Read-only view of one field of the live grid, without copying. Cell
+ * (x, y) is at (const char *)rows[y] + x * stride and is element_size
+ * bytes wide. Each row is contiguous in this sense, but rows are separate
+ * blocks, so wrap them one row at a time. Valid until the next call that
+ * steps, loads or edits the simulation. */
+typedef struct
+{
+    uint32_t struct_size; /* sizeof(simcity_plane), set by the caller */
+    int32_t width;
+    int32_t height;
+    int32_t element_size; /* 1 for SIMCITY_PLANE_TYPE, 4 otherwise */
+    int32_t stride;       /* Bytes from one cell to the next within a row */
+    const void *const *rows;
+} simcity_plane;
+
+SIMCITY_API int simcity_abi_version(void);
+
+SIMCITY_API simcity_sim *simcity_create(void);
+SIMCITY_API void simcity_destroy(simcity_sim *sim);
+
+/* Message of the last failed call on sim; empty if there was none */
+SIMCITY_API const char *simcity_last_error(const simcity_sim *sim);
+
+/* Load a region file, or a region in the same format from memory */
+SIMCITY_API int simcity_load(simcity_sim *sim, const char *path);
+SIMCITY_API int simcity_load_buffer(simcity_sim *sim, const char *data, size_t length);
+
+/* "reference", "sparse" or "adaptive"; results are the same for all */
+SIMCITY_API int simcity_set_engine(simcity_sim *sim, const char *engine);
+SIMCITY_API int simcity_set_cycle_window(simcity_sim *sim, int32_t steps);
+
+/* Keep every step from now on, for simcity_analyze_area_at;
+   SIMCITY_ERROR_STATE if the region is too large for the history budget */
+SIMCITY_API int simcity_enable_history(simcity_sim *sim);
+
+/* Take one step; summary may be NULL */
+SIMCITY_API int simcity_step(simcity_sim *sim, simcity_step_summary *summary);
+
+/* Take up to max_steps steps, stopping early once the region stops
+ * changing or repeats. *steps_taken and *last may be NULL. */
+SIMCITY_API int simcity_run(simcity_sim *sim, int32_t max_steps, int32_t *steps_taken, simcity_step_summary *last);
+
+/* Rezone, bulldoze ('-') or place roads and power between steps */
+SIMCITY_API int simcity_set_cell_type(simcity_sim *sim, int32_t x, int32_t y, char type);
+
+SIMCITY_API int32_t simcity_width(const simcity_sim *sim);
+SIMCITY_API int32_t simcity_height(const simcity_sim *sim);
+SIMCITY_API int32_t simcity_step_count(const simcity_sim *sim);
+
+/* Totals over the whole region; type is 'R', 'I' or 'C' */
+SIMCITY_API int64_t simcity_total_population(const simcity_sim *sim, char type);
+SIMCITY_API int64_t simcity_total_pollution(const simcity_sim *sim);
+
+SIMCITY_API int simcity_get_plane(simcity_sim *sim, simcity_plane_field field, simcity_plane *plane);
+
+/* Totals over the inclusive rectangle; corners may be given in any order */
+SIMCITY_API int simcity_analyze_area(simcity_sim *sim, int32_t x1, int32_t y1, int32_t x2, int32_t y2, simcity_area *area);
+
+/* The same as of the state after step steps (0 is the loaded layout) */
+SIMCITY_API int simcity_analyze_area_at(simcity_sim *sim, int32_t step, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                            simcity_area *area);
+
+/* Immutable copy of the current state with constant-time area queries;
+ * NULL on failure. Independent of sim once taken. */
+SIMCITY_API simcity_snapshot *simcity_snapshot_create(simcity_sim *sim);
+SIMCITY_API void simcity_snapshot_destroy(simcity_snapshot *snapshot);
+SIMCITY_API int32_t simcity_snapshot_step(const simcity_snapshot *snapshot);
+SIMCITY_API int simcity_snapshot_area(const simcity_snapshot *snapshot, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                          simcity_area *area);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMCITY_C_H */
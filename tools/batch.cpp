@@ -0,0 +1,258 @@
+// batch.cpp
+// Many-small-regions throughput: packs random regions (or the given region
+// files) into BatchSimulation blocks, one per thread, and sweeps them until
+// every region converged or the step limit is reached. With --check every
+// region is also run alone through Simulation, the way it runs outside a
+// batch, and the results are compared and the two timed on the same
+// number of threads.
+//
+// Usage:
+//   batch [--regions N] [--seed S] [--min-size N] [--max-size N] [--steps N]
+//         [--threads N] [--check] [REGION.csv ...]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <chrono>
+#include "BatchSimulation.h"
+#include "DifferentialChecker.h"
+#include "Layout.h"
+#include "Simulation.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: batch [--regions N] [--seed S] [--min-size N] [--max-size N] [--steps N]\n"
+              << "             [--threads N] [--check] [REGION.csv ...]" << std::endl;
+}
+
+static std::shared_ptr<const Layout> toLayout(const LayoutRows &rows)
+{
+    std::vector<std::vector<Cell>> grid(rows.size(), std::vector<Cell>(rows[0].size()));
+    for (size_t y = 0; y < rows.size(); y++)
+    {
+        for (size_t x = 0; x < rows[y].size(); x++)
+            grid[y][x].setType(rows[y][x]);
+    }
+    return Layout::fromGrid(grid);
+}
+
+// Run job(slice, first, last) over threadCount contiguous slices of count items
+template <typename Job>
+static void runSlices(int count, int threadCount, Job job)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        int first = static_cast<int>(static_cast<long long>(count) * t / threadCount);
+        int last = static_cast<int>(static_cast<long long>(count) * (t + 1) / threadCount);
+        threads.emplace_back(job, t, first, last);
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+// Run one region alone through Simulation, as outside a batch
+static BatchResult runAlone(const LayoutRows &rows, int maxSteps)
+{
+    Simulation simulation;
+    std::string error;
+    std::istringstream in(DifferentialChecker::toRegionText(rows));
+    simulation.load(in, error);
+
+    BatchResult result = {0, false, 0, 0, 0, 0, 0, 0};
+    StepGenerator generator(simulation, maxSteps);
+    for (const StepSummary &summary : generator)
+    {
+        result.steps++;
+        result.converged = !summary.changed;
+    }
+    result.residentialPopulation = simulation.getTotalPopulation('R');
+    result.industrialPopulation = simulation.getTotalPopulation('I');
+    result.commercialPopulation = simulation.getTotalPopulation('C');
+    result.totalPollution = simulation.getTotalPollution();
+    result.availableWorkers = simulation.getAvailableWorkers();
+    result.availableGoods = simulation.getAvailableGoods();
+    return result;
+}
+
+static bool sameResult(const BatchResult &a, const BatchResult &b)
+{
+    return a.steps == b.steps && a.converged == b.converged &&
+           a.residentialPopulation == b.residentialPopulation &&
+           a.industrialPopulation == b.industrialPopulation &&
+           a.commercialPopulation == b.commercialPopulation && a.totalPollution == b.totalPollution &&
+           a.availableWorkers == b.availableWorkers && a.availableGoods == b.availableGoods;
+}
+
+static void printResult(const std::string &engine, const BatchResult &result)
+{
+    std::cout << "  " << engine << ": " << result.steps << " steps" << (result.converged ? " (converged)" : "")
+              << ", R " << result.residentialPopulation << ", I " << result.industrialPopulation << ", C "
+              << result.commercialPopulation << ", pollution " << result.totalPollution << ", workers "
+              << result.availableWorkers << ", goods " << result.availableGoods << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int regions = 10000;
+    uint64_t seed = 1;
+    int minSize = 8;
+    int maxSize = 16;
+    int maxSteps = 100;
+    int threadCount = 1;
+    bool check = false;
+    std::vector<std::string> regionFiles;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--check")
+        {
+            check = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            regionFiles.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--regions")
+            regions = std::atoi(value.c_str());
+        else if (arg == "--seed")
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--min-size")
+            minSize = std::atoi(value.c_str());
+        else if (arg == "--max-size")
+            maxSize = std::atoi(value.c_str());
+        else if (arg == "--steps")
+            maxSteps = std::atoi(value.c_str());
+        else if (arg == "--threads")
+            threadCount = std::atoi(value.c_str());
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    if (regions <= 0 || maxSteps < 0 || minSize <= 0 || maxSize < minSize || threadCount <= 0)
+    {
+        std::cerr << "Error: --regions and --threads must be positive, --steps must not be negative and "
+                  << "0 < --min-size <= --max-size" << std::endl;
+        return 2;
+    }
+
+    std::vector<LayoutRows> layouts;
+    if (!regionFiles.empty())
+    {
+        for (const std::string &filename : regionFiles)
+        {
+            LayoutRows rows;
+            if (!DifferentialChecker::readLayout(filename, rows))
+                return 1;
+            layouts.push_back(rows);
+        }
+    }
+    else
+    {
+        for (int region = 0; region < regions; region++)
+            layouts.push_back(DifferentialChecker::generate(
+                DifferentialChecker::randomParams(seed, region, minSize, maxSize)));
+    }
+    int count = static_cast<int>(layouts.size());
+    if (threadCount > count)
+        threadCount = count;
+
+    long long cells = 0;
+    std::vector<std::shared_ptr<const Layout>> shared;
+    for (const LayoutRows &rows : layouts)
+    {
+        cells += static_cast<long long>(rows.size()) * rows[0].size();
+        shared.push_back(toLayout(rows));
+    }
+
+    // One batch per thread, each over a contiguous slice of the regions
+    std::vector<BatchResult> results(count);
+    std::vector<long long> regionSteps(threadCount, 0);
+    std::vector<size_t> memoryBytes(threadCount, 0);
+    int tileWidth = 0, tileHeight = 0;
+    auto start = std::chrono::steady_clock::now();
+    runSlices(count, threadCount, [&](int slice, int first, int last) {
+        BatchSimulation batch;
+        batch.load(std::vector<std::shared_ptr<const Layout>>(shared.begin() + first, shared.begin() + last));
+        batch.run(maxSteps);
+        for (int region = first; region < last; region++)
+        {
+            results[region] = batch.getResult(region - first);
+            regionSteps[slice] += results[region].steps;
+        }
+        memoryBytes[slice] = batch.getMemoryBytes();
+        if (slice == 0)
+        {
+            tileWidth = batch.getTileWidth();
+            tileHeight = batch.getTileHeight();
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long totalSteps = 0;
+    size_t totalBytes = 0;
+    for (int t = 0; t < threadCount; t++)
+    {
+        totalSteps += regionSteps[t];
+        totalBytes += memoryBytes[t];
+    }
+    int convergedCount = 0;
+    long long population[3] = {0, 0, 0};
+    long long pollution = 0;
+    for (const BatchResult &result : results)
+    {
+        convergedCount += result.converged;
+        population[0] += result.residentialPopulation;
+        population[1] += result.industrialPopulation;
+        population[2] += result.commercialPopulation;
+        pollution += result.totalPollution;
+    }
+
+    std::cout << count << (count == 1 ? " region" : " regions") << " (" << cells << " cells) in " << threadCount
+              << (threadCount == 1 ? " batch" : " batches") << " of " << tileWidth << "x" << tileHeight
+              << " tiles, " << totalBytes / 1024 << " KB" << std::endl;
+    std::cout << totalSteps << " region steps in " << seconds << " s (" << totalSteps / seconds
+              << " region steps/s), " << convergedCount << " converged within " << maxSteps << " steps" << std::endl;
+    std::cout << "Totals: R " << population[0] << ", I " << population[1] << ", C " << population[2]
+              << ", pollution " << pollution << std::endl;
+
+    if (!check)
+        return 0;
+
+    // Each thread profiles into its own state, so these share the batch's threads
+    std::vector<BatchResult> alone(count);
+    start = std::chrono::steady_clock::now();
+    runSlices(count, threadCount, [&](int, int first, int last) {
+        for (int region = first; region < last; region++)
+            alone[region] = runAlone(layouts[region], maxSteps);
+    });
+    double aloneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int region = 0; region < count; region++)
+    {
+        if (sameResult(results[region], alone[region]))
+            continue;
+        std::cout << "Region " << region << " (" << layouts[region][0].size() << "x" << layouts[region].size()
+                  << ") differs:" << std::endl;
+        printResult("simulation", alone[region]);
+        printResult("batch", results[region]);
+        return 1;
+    }
+    std::cout << "Same results as one Simulation per region, which took " << aloneSeconds << " s on "
+              << threadCount << (threadCount == 1 ? " thread" : " threads") << " (" << aloneSeconds / seconds
+              << "x the batch time)" << std::endl;
+    return 0;
+}
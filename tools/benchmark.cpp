@@ -0,0 +1,287 @@
+// benchmark.cpp
+// Scaling benchmark for the step pipeline. Generates regions of several sizes
+// and zone densities, times every phase of a time step separately and writes
+// one CSV row per (size, density, phase). Two result files can be compared to
+// flag regressions.
+//
+// Usage:
+//   benchmark [--sizes 10,64,...] [--densities 0.2,0.5,...] [--steps N]
+//             [--seed S] [--out results.csv]
+//   benchmark --compare baseline.csv current.csv [--threshold PERCENT]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include "Region.h"
+#include "RegionGenerator.h"
+
+struct PhaseTiming
+{
+    std::string name;
+    long long totalNs = 0;
+    int calls = 0;
+};
+
+struct BenchConfig
+{
+    std::vector<int> sizes = {10, 32, 128, 512, 2048, 8192};
+    std::vector<double> densities = {0.2, 0.5, 0.8};
+    int steps = 10;
+    unsigned seed = 1;
+    std::string outFile;
+};
+
+static long long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Roads every 8th row/column, power lines every 16th, zones at the given density
+static bool writeRegion(const std::string &filename, int size, double density, unsigned seed)
+{
+    GeneratorParams params;
+    params.width = size;
+    params.height = size;
+    params.seed = seed;
+    params.density = density;
+    params.plants = std::max(1, size / 64 * size / 64);
+    params.clustering = 0.0;
+    return RegionGenerator(params).writeCsv(filename);
+}
+
+static std::vector<std::string> split(const std::string &text, char separator)
+{
+    std::vector<std::string> parts;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, separator))
+        parts.push_back(part);
+    return parts;
+}
+
+static void benchmarkOne(const BenchConfig &config, int size, double density, std::ostream &out)
+{
+    std::string regionFile = "bench_region_" + std::to_string(size) + ".csv";
+    if (!writeRegion(regionFile, size, density, config.seed))
+        return;
+
+    std::vector<PhaseTiming> phases(8);
+    const char *names[] = {"loadFromFile", "updateResources", "CommercialSystem::update",
+                           "IndustrialSystem::update", "ResidentialSystem::update",
+                           "updatePollution", "changeDetection", "analyzeArea"};
+    for (int i = 0; i < 8; i++)
+        phases[i].name = names[i];
+
+    Region region;
+    long long start = nowNs();
+    bool loaded = region.loadFromFile(regionFile);
+    phases[0].totalNs += nowNs() - start;
+    phases[0].calls++;
+    std::remove(regionFile.c_str());
+    if (!loaded)
+        return;
+
+    // Step the systems directly so every phase of performTimeStep can be timed
+    std::vector<std::vector<Cell>> grid = region.getGrid();
+    StateHash hash;
+    hash.reset(grid);
+    int availableWorkers = 0, availableGoods = 0;
+    long long stepNs = 0;
+    int stepsRun = 0;
+
+    for (int step = 0; step < config.steps; step++)
+    {
+        long long t0 = nowNs();
+        hash.clearChanges();
+        long long t1 = nowNs();
+        availableWorkers = ResidentialSystem::getTotalPopulation(grid);
+        availableGoods = IndustrialSystem::getTotalPopulation(grid);
+        long long t2 = nowNs();
+        CommercialSystem::update(grid, availableWorkers, availableGoods, &hash);
+        long long t3 = nowNs();
+        IndustrialSystem::update(grid, availableWorkers, availableGoods, &hash);
+        long long t4 = nowNs();
+        ResidentialSystem::update(grid, &hash);
+        long long t5 = nowNs();
+        IndustrialSystem::updatePollution(grid, &hash);
+        long long t6 = nowNs();
+        bool changed = hash.getChanges() > 0;
+        long long t7 = nowNs();
+
+        long long spans[] = {t2 - t1, t3 - t2, t4 - t3, t5 - t4, t6 - t5, (t1 - t0) + (t7 - t6)};
+        for (int i = 0; i < 6; i++)
+        {
+            phases[i + 1].totalNs += spans[i];
+            phases[i + 1].calls++;
+        }
+        stepNs += t7 - t0;
+        stepsRun++;
+        if (!changed)
+            break;
+    }
+
+    // analyzeArea prints its report; keep that out of the measurement
+    std::streambuf *saved = std::cout.rdbuf();
+    std::ostringstream sink;
+    std::cout.rdbuf(sink.rdbuf());
+    start = nowNs();
+    region.analyzeArea(0, 0, size - 1, size - 1);
+    phases[7].totalNs += nowNs() - start;
+    phases[7].calls++;
+    std::cout.rdbuf(saved);
+
+    double cells = static_cast<double>(size) * size;
+    double stepsPerSec = stepNs > 0 ? stepsRun * 1e9 / stepNs : 0.0;
+    long rss = peakRssKb();
+    for (const auto &phase : phases)
+    {
+        double nsPerCell = phase.calls > 0 ? phase.totalNs / (cells * phase.calls) : 0.0;
+        out << size << "," << size << "," << density << "," << phase.name << ","
+            << phase.calls << "," << phase.totalNs << "," << nsPerCell << ","
+            << stepsPerSec << "," << rss << "\n";
+    }
+    out.flush();
+
+    std::cerr << size << "x" << size << " density " << density << ": "
+              << stepsRun << " steps, " << stepsPerSec << " steps/s, peak RSS " << rss << " KiB" << std::endl;
+}
+
+// Key -> ns/cell for one results file
+static bool readResults(const std::string &filename, std::map<std::string, double> &results)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Cannot open results file '" << filename << "'" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::getline(file, line); // header
+    while (std::getline(file, line))
+    {
+        std::vector<std::string> fields = split(line, ',');
+        if (fields.size() < 7)
+            continue;
+        std::string key = fields[0] + "x" + fields[1] + " d=" + fields[2] + " " + fields[3];
+        results[key] = std::atof(fields[6].c_str());
+    }
+    return true;
+}
+
+static int compareResults(const std::string &baseline, const std::string &current, double threshold)
+{
+    std::map<std::string, double> before, after;
+    if (!readResults(baseline, before) || !readResults(current, after))
+        return 2;
+
+    int regressions = 0;
+    std::cout << "case,baseline_ns_per_cell,current_ns_per_cell,change_percent,status\n";
+    for (const auto &entry : after)
+    {
+        auto match = before.find(entry.first);
+        if (match == before.end() || match->second <= 0.0)
+            continue;
+
+        double change = (entry.second - match->second) * 100.0 / match->second;
+        const char *status = "ok";
+        if (change > threshold)
+        {
+            status = "REGRESSION";
+            regressions++;
+        }
+        else if (change < -threshold)
+        {
+            status = "improved";
+        }
+        std::cout << entry.first << "," << match->second << "," << entry.second << ","
+                  << change << "," << status << "\n";
+    }
+
+    std::cerr << regressions << " regression(s) above " << threshold << "%" << std::endl;
+    return regressions > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config;
+    double threshold = 10.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--compare" && i + 2 < argc)
+        {
+            std::string baseline = argv[++i];
+            std::string current = argv[++i];
+            if (i + 2 < argc && std::string(argv[i + 1]) == "--threshold")
+                threshold = std::atof(argv[i + 2]);
+            return compareResults(baseline, current, threshold);
+        }
+        else if (arg == "--sizes" && hasValue)
+        {
+            config.sizes.clear();
+            for (const auto &part : split(argv[++i], ','))
+                config.sizes.push_back(std::atoi(part.c_str()));
+        }
+        else if (arg == "--densities" && hasValue)
+        {
+            config.densities.clear();
+            for (const auto &part : split(argv[++i], ','))
+                config.densities.push_back(std::atof(part.c_str()));
+        }
+        else if (arg == "--steps" && hasValue)
+            config.steps = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            config.seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--out" && hasValue)
+            config.outFile = argv[++i];
+        else
+        {
+            std::cerr << "Usage: benchmark [--sizes LIST] [--densities LIST] [--steps N] [--seed S] [--out FILE]\n"
+                      << "       benchmark --compare BASELINE CURRENT [--threshold PERCENT]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::ofstream outFile;
+    if (!config.outFile.empty())
+    {
+        outFile.open(config.outFile);
+        if (!outFile)
+        {
+            std::cerr << "Error: Cannot write results file '" << config.outFile << "'" << std::endl;
+            return 2;
+        }
+    }
+    std::ostream &out = config.outFile.empty() ? std::cout : outFile;
+
+    out << "width,height,density,phase,calls,total_ns,ns_per_cell,steps_per_sec,peak_rss_kb\n";
+    for (int size : config.sizes)
+    {
+        for (double density : config.densities)
+        {
+            if (size > 0)
+                benchmarkOne(config, size, density, out);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+// diffcheck.cpp
+// Differential check of the optimized step engines: steps the reference
+// engine and each checked engine in lockstep over random regions (or one
+// given region) and compares every cell after every step. On the first
+// difference it prints the step and cell, shrinks the region to a small
+// reproducer and writes it as a region file. --edits, --defer, --commute
+// and --land-value check the engines behind Simulation under random edits
+// and the optional rules.
+//
+// Usage:
+//   diffcheck [--engines sparse,adaptive,kernel,tiled,fixed,batch] [--regions N] [--seed S]
+//             [--min-size N] [--max-size N] [--square] [--steps N] [--region FILE]
+//             [--out REPRO.csv] [--work DIR] [--edits N] [--defer] [--commute N]
+//             [--land-value N]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include "DifferentialChecker.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: diffcheck [--engines sparse,adaptive,kernel,tiled,fixed,batch] [--regions N] [--seed S]\n"
+              << "                 [--min-size N] [--max-size N] [--square] [--steps N] [--region FILE]\n"
+              << "                 [--out REPRO.csv] [--work DIR] [--edits N] [--defer] [--commute N]\n"
+              << "                 [--land-value N]" << std::endl;
+}
+
+// The options as command line flags, to rerun a reproducer under them
+static std::string optionFlags(const CheckOptions &options)
+{
+    std::string flags;
+    if (options.editsPerStep > 0)
+        flags += " --edits " + std::to_string(options.editsPerStep) + " --seed " + std::to_string(options.editSeed);
+    if (options.deferPollution)
+        flags += " --defer";
+    if (options.commuteDistance > 0)
+        flags += " --commute " + std::to_string(options.commuteDistance);
+    if (options.landValue)
+        flags += " --land-value " + std::to_string(options.minimumLandValue);
+    return flags;
+}
+
+static bool parseEngines(const std::string &list, std::vector<std::string> &engines)
+{
+    engines.clear();
+    std::stringstream stream(list);
+    std::string name;
+    while (std::getline(stream, name, ','))
+    {
+        if (!DifferentialChecker::isKnownEngine(name))
+        {
+            std::cerr << "Error: Unknown engine " << name << std::endl;
+            return false;
+        }
+        engines.push_back(name);
+    }
+    return !engines.empty();
+}
+
+static void printCell(const std::string &engine, const Cell &cell)
+{
+    std::cout << "  " << engine << ": type " << cell.getType() << ", population " << cell.getPopulation()
+              << ", pollution " << cell.getPollution() << std::endl;
+}
+
+static void printDivergence(const std::string &engine, const Divergence &divergence)
+{
+    std::cout << engine << " differs from reference after " << divergence.step << " steps at ("
+              << divergence.x << ", " << divergence.y << "):" << std::endl;
+    printCell("reference", divergence.expected);
+    printCell(engine, divergence.actual);
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> engines = DifferentialChecker::engineNames();
+    int regions = 200;
+    uint64_t seed = 1;
+    int minSize = 4;
+    int maxSize = 96;
+    int maxSteps = 40;
+    std::string regionFile;
+    std::string reproFile = "diffcheck_repro.csv";
+    std::string workDir = ".";
+    bool square = false;
+    bool enginesGiven = false;
+    CheckOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--square")
+        {
+            square = true;
+            continue;
+        }
+        if (arg == "--defer")
+        {
+            options.deferPollution = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--engines")
+        {
+            if (!parseEngines(value, engines))
+                return 2;
+            enginesGiven = true;
+        }
+        else if (arg == "--regions")
+            regions = std::atoi(value.c_str());
+        else if (arg == "--seed")
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--min-size")
+            minSize = std::atoi(value.c_str());
+        else if (arg == "--max-size")
+            maxSize = std::atoi(value.c_str());
+        else if (arg == "--steps")
+            maxSteps = std::atoi(value.c_str());
+        else if (arg == "--region")
+            regionFile = value;
+        else if (arg == "--out")
+            reproFile = value;
+        else if (arg == "--work")
+            workDir = value;
+        else if (arg == "--edits")
+            options.editsPerStep = std::atoi(value.c_str());
+        else if (arg == "--commute")
+            options.commuteDistance = std::atoi(value.c_str());
+        else if (arg == "--land-value")
+        {
+            options.landValue = true;
+            options.minimumLandValue = std::atoi(value.c_str());
+        }
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    if (regions <= 0 || maxSteps < 0 || minSize <= 0 || maxSize < minSize || options.editsPerStep < 0 ||
+        options.commuteDistance < 0)
+    {
+        std::cerr << "Error: --regions must be positive, --steps, --edits and --commute must not be negative "
+                  << "and 0 < --min-size <= --max-size" << std::endl;
+        return 2;
+    }
+
+    // Edits and optional rules only apply to the engines behind Simulation
+    std::vector<std::string> usable;
+    for (const std::string &engine : engines)
+    {
+        if (DifferentialChecker::supports(engine, options))
+            usable.push_back(engine);
+        else if (enginesGiven)
+        {
+            std::cerr << "Error: " << engine << " does not take --edits, --defer, --commute or --land-value"
+                      << std::endl;
+            return 2;
+        }
+    }
+    engines = usable;
+    options.editSeed = seed;
+
+    LayoutRows fixed;
+    if (!regionFile.empty())
+    {
+        if (!DifferentialChecker::readLayout(regionFile, fixed))
+            return 1;
+        regions = 1;
+    }
+
+    std::vector<DifferentialChecker> checkers;
+    for (const std::string &engine : engines)
+        checkers.emplace_back(engine, workDir);
+    std::vector<int> checked(engines.size(), 0);
+
+    auto start = std::chrono::steady_clock::now();
+    long long cells = 0;
+    for (int region = 0; region < regions; region++)
+    {
+        GeneratorParams params = DifferentialChecker::randomParams(seed, region, minSize, maxSize, square);
+        LayoutRows rows = regionFile.empty() ? DifferentialChecker::generate(params) : fixed;
+        cells += static_cast<long long>(rows.size()) * rows[0].size();
+
+        // Each random region gets its own edits; a given region uses --seed as is
+        CheckOptions regionOptions = options;
+        regionOptions.editSeed = regionFile.empty() ? params.seed : seed;
+
+        for (size_t engine = 0; engine < checkers.size(); engine++)
+        {
+            DifferentialChecker &checker = checkers[engine];
+            checker.setOptions(regionOptions);
+            if (!DifferentialChecker::supports(checker.getEngine(), rows[0].size(), rows.size()))
+                continue;
+            checked[engine]++;
+
+            Divergence divergence;
+            std::string error;
+            if (!checker.compare(rows, maxSteps, divergence, error))
+            {
+                std::cerr << "Error: " << checker.getEngine() << ": " << error << std::endl;
+                return 1;
+            }
+            if (!divergence.found)
+                continue;
+
+            if (regionFile.empty())
+            {
+                std::cout << "Region " << region << " (seed " << seed << ", " << rows[0].size() << "x"
+                          << rows.size() << "):" << std::endl;
+            }
+            printDivergence(checker.getEngine(), divergence);
+
+            std::cout << "Minimizing..." << std::endl;
+            LayoutRows repro = checker.minimize(rows, divergence);
+            std::cout << "Reproducer is " << repro[0].size() << "x" << repro.size() << ", found in "
+                      << checker.getComparisons() << " runs:" << std::endl;
+            for (const std::string &row : repro)
+                std::cout << "  " << row << std::endl;
+            printDivergence(checker.getEngine(), divergence);
+            if (!DifferentialChecker::writeLayout(reproFile, repro))
+                return 1;
+            std::cout << "Wrote " << reproFile << "; rerun with: diffcheck --region " << reproFile
+                      << " --engines " << checker.getEngine() << " --steps " << divergence.step
+                      << optionFlags(regionOptions) << std::endl;
+            return 1;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "No differences in " << regions << (regions == 1 ? " region" : " regions") << " (" << cells
+              << " cells) over " << maxSteps << " steps";
+    if (!options.isPlain())
+        std::cout << " with" << optionFlags(options);
+    std::cout << " for:";
+    for (size_t engine = 0; engine < engines.size(); engine++)
+    {
+        std::cout << " " << engines[engine];
+        if (checked[engine] < regions)
+            std::cout << " (" << checked[engine] << " of them)";
+    }
+    std::cout << " (" << seconds << " s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+// generate.cpp
+// Seeded procedural region generator. Streams a layout in the format
+// Region::loadFromFile reads, one row at a time, so maps far larger than
+// memory can be produced. With --tiles the layout is written as a tile
+// file for the out-of-core `tiled` runner instead.
+//
+// Usage:
+//   generate --width W --height H [--seed S] [--density D] [--mix R,C,I]
+//            [--road-spacing N] [--power-spacing N] [--plants N]
+//            [--clustering C] [--cluster-size N] [--out FILE]
+//            [--tiles FILE] [--tile-size N]
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include "RegionGenerator.h"
+#include "TileStore.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: generate --width W --height H [--seed S] [--density D] [--mix R,C,I]\n"
+              << "                [--road-spacing N] [--power-spacing N] [--plants N]\n"
+              << "                [--clustering C] [--cluster-size N] [--out FILE]\n"
+              << "                [--tiles FILE] [--tile-size N]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    GeneratorParams params;
+    std::string outFile;
+    std::string tileFile;
+    int tileSize = TileStore::DEFAULT_TILE_SIZE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 2;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--width")
+            params.width = std::atoi(value.c_str());
+        else if (arg == "--height")
+            params.height = std::atoi(value.c_str());
+        else if (arg == "--seed")
+            params.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--density")
+            params.density = std::atof(value.c_str());
+        else if (arg == "--mix")
+        {
+            char comma1 = 0, comma2 = 0;
+            if (std::sscanf(value.c_str(), "%d%c%d%c%d", &params.residentialWeight, &comma1,
+                            &params.commercialWeight, &comma2, &params.industrialWeight) != 5 ||
+                comma1 != ',' || comma2 != ',')
+            {
+                std::cerr << "Error: --mix expects three comma separated weights (R,C,I)" << std::endl;
+                return 2;
+            }
+        }
+        else if (arg == "--road-spacing")
+            params.roadSpacing = std::atoi(value.c_str());
+        else if (arg == "--power-spacing")
+            params.powerSpacing = std::atoi(value.c_str());
+        else if (arg == "--plants")
+            params.plants = std::atoi(value.c_str());
+        else if (arg == "--clustering")
+            params.clustering = std::atof(value.c_str());
+        else if (arg == "--cluster-size")
+            params.clusterSize = std::atoi(value.c_str());
+        else if (arg == "--out")
+            outFile = value;
+        else if (arg == "--tiles")
+            tileFile = value;
+        else if (arg == "--tile-size")
+            tileSize = std::atoi(value.c_str());
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::string error;
+    if (!RegionGenerator::validate(params, error))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return 2;
+    }
+
+    if (tileSize <= 0 || tileSize > 4096)
+    {
+        std::cerr << "Error: --tile-size must be between 1 and 4096" << std::endl;
+        return 2;
+    }
+
+    RegionGenerator generator(params);
+    bool written;
+    if (!tileFile.empty())
+        written = generator.writeTiles(tileFile, tileSize) && (outFile.empty() || generator.writeCsv(outFile));
+    else
+        written = outFile.empty() ? generator.writeCsv(std::cout) : generator.writeCsv(outFile);
+    if (!written)
+    {
+        std::cerr << "Error: Failed while writing the region" << std::endl;
+        return 1;
+    }
+    return 0;
+}
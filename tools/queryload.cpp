@@ -0,0 +1,204 @@
+// queryload.cpp
+// Load generator for `serve`: several clients send random area and total
+// queries as fast as they get answers, and the round-trip latencies are
+// reported as percentiles. The range of steps seen in the answers shows
+// how far the simulation advanced while under load.
+//
+// Usage:
+//   queryload [--socket PATH] [--clients N] [--queries N] [--seed S]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+struct ClientResult
+{
+    std::vector<long long> latenciesNs;
+    int firstStep = INT_MAX;
+    int lastStep = -1;
+    int errors = 0;
+    bool connected = false;
+};
+
+static long long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static int connectTo(const std::string &socketPath)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        return -1;
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// Send one request line and read one reply line; false if the server went away
+static bool query(int fd, const std::string &request, std::string &reply)
+{
+    std::string line = request + "\n";
+    if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(line.size()))
+        return false;
+
+    // Only one request is outstanding, so the reply ends the received data
+    reply.clear();
+    char buffer[256];
+    while (reply.empty() || reply.back() != '\n')
+    {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            return false;
+        reply.append(buffer, received);
+    }
+    reply.pop_back();
+    return true;
+}
+
+static void runClient(const std::string &socketPath, int queries, int width, int height, unsigned seed,
+                      ClientResult &result)
+{
+    int fd = connectTo(socketPath);
+    if (fd < 0)
+        return;
+    result.connected = true;
+    result.latenciesNs.reserve(queries);
+
+    std::mt19937 rng(seed);
+    std::string reply;
+    for (int i = 0; i < queries; i++)
+    {
+        std::string request = "TOTALS";
+        if (i % 10 != 0)
+        {
+            request = "AREA " + std::to_string(rng() % width) + " " + std::to_string(rng() % height) + " " +
+                      std::to_string(rng() % width) + " " + std::to_string(rng() % height);
+        }
+
+        long long start = nowNs();
+        if (!query(fd, request, reply))
+        {
+            result.errors++;
+            break;
+        }
+        result.latenciesNs.push_back(nowNs() - start);
+
+        if (reply.compare(0, 3, "OK ") != 0)
+        {
+            result.errors++;
+            continue;
+        }
+        int step = std::atoi(reply.c_str() + 3);
+        result.firstStep = std::min(result.firstStep, step);
+        result.lastStep = std::max(result.lastStep, step);
+    }
+    ::close(fd);
+}
+
+static double percentileUs(const std::vector<long long> &sorted, double percentile)
+{
+    size_t index = static_cast<size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index] / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string socketPath = "simcity.sock";
+    int clients = 4;
+    int queries = 10000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue)
+            socketPath = argv[++i];
+        else if (arg == "--clients" && hasValue)
+            clients = std::atoi(argv[++i]);
+        else if (arg == "--queries" && hasValue)
+            queries = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cerr << "Usage: queryload [--socket PATH] [--clients N] [--queries N] [--seed S]" << std::endl;
+            return 2;
+        }
+    }
+    if (clients <= 0 || queries <= 0)
+    {
+        std::cerr << "Error: --clients and --queries must be positive" << std::endl;
+        return 2;
+    }
+
+    // The region size bounds the random rectangles
+    int fd = connectTo(socketPath);
+    std::string reply;
+    int step = 0, width = 0, height = 0;
+    if (fd < 0 || !query(fd, "INFO", reply) ||
+        std::sscanf(reply.c_str(), "OK %d %d %d", &step, &width, &height) != 3 || width <= 0 || height <= 0)
+    {
+        std::cerr << "Error: Cannot query server on " << socketPath << std::endl;
+        if (fd >= 0)
+            ::close(fd);
+        return 1;
+    }
+    ::close(fd);
+
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    long long start = nowNs();
+    for (int i = 0; i < clients; i++)
+        threads.emplace_back(runClient, socketPath, queries, width, height, seed + i, std::ref(results[i]));
+    for (auto &thread : threads)
+        thread.join();
+    double seconds = (nowNs() - start) / 1e9;
+
+    std::vector<long long> latencies;
+    int firstStep = INT_MAX, lastStep = -1, errors = 0, connected = 0;
+    for (const auto &result : results)
+    {
+        latencies.insert(latencies.end(), result.latenciesNs.begin(), result.latenciesNs.end());
+        firstStep = std::min(firstStep, result.firstStep);
+        lastStep = std::max(lastStep, result.lastStep);
+        errors += result.errors;
+        connected += result.connected;
+    }
+    if (latencies.empty())
+    {
+        std::cerr << "Error: No queries were answered" << std::endl;
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "Clients: " << connected << "/" << clients << "  Queries: " << latencies.size()
+              << "  Errors: " << errors << "  Throughput: " << static_cast<long long>(latencies.size() / seconds)
+              << " queries/s" << std::endl;
+    std::cout << "Latency us: p50 " << percentileUs(latencies, 50) << "  p99 " << percentileUs(latencies, 99)
+              << "  p99.9 " << percentileUs(latencies, 99.9) << "  max " << latencies.back() / 1000.0 << std::endl;
+    if (lastStep >= 0)
+        std::cout << "Steps seen: " << firstStep << " to " << lastStep << std::endl;
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+// serve.cpp
+// Runs a region and answers queries about it over a Unix domain socket
+// while it steps. A snapshot is published after every step; once the steps
+// are done the final state stays queryable until the process is stopped
+// with Ctrl-C or SIGTERM.
+//
+// Usage:
+//   serve REGION.csv [--socket PATH] [--threads N] [--steps N]
+//         [--engine reference|sparse|adaptive] [--metrics-file FILE | --metrics-port PORT]
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <signal.h>
+#include <pthread.h>
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "QueryServer.h"
+#include "Metrics.h"
+
+// Whether one of signals, which are blocked, is pending; takes it if so
+static bool takeSignal(const sigset_t &signals)
+{
+    const timespec noWait = {0, 0};
+    return sigtimedwait(&signals, nullptr, &noWait) > 0;
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: serve REGION.csv [--socket PATH] [--threads N] [--steps N]\n"
+              << "             [--engine reference|sparse|adaptive] [--metrics-file FILE | --metrics-port PORT]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 2;
+    }
+
+    std::string regionFile = argv[1];
+    std::string socketPath = "simcity.sock";
+    int threads = 4;
+    int maxSteps = 1000;
+    StepEngine engine = ENGINE_REFERENCE;
+    std::string metricsFile;
+    int metricsPort = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--socket")
+            socketPath = value;
+        else if (arg == "--threads")
+            threads = std::atoi(value.c_str());
+        else if (arg == "--steps")
+            maxSteps = std::atoi(value.c_str());
+        else if (arg == "--metrics-file")
+            metricsFile = value;
+        else if (arg == "--metrics-port")
+            metricsPort = std::atoi(value.c_str());
+        else if (arg == "--engine")
+        {
+            if (!Simulation::parseEngine(value, engine))
+            {
+                std::cerr << "Error: --engine must be reference, sparse or adaptive" << std::endl;
+                return 2;
+            }
+        }
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    if (maxSteps < 0)
+    {
+        std::cerr << "Error: --steps must not be negative" << std::endl;
+        return 2;
+    }
+
+    Simulation simulation;
+    std::string error;
+    if (!simulation.load(regionFile, error))
+    {
+        std::cerr << "Error loading region file: " << error << std::endl;
+        return 1;
+    }
+    simulation.setEngine(engine);
+
+    SnapshotPublisher publisher;
+    Snapshot *snapshot = publisher.acquire();
+    snapshot->build(simulation);
+    publisher.publish(snapshot);
+
+    // SIGINT and SIGTERM stay blocked in every thread started from here on
+    // and are taken with sigtimedwait and sigwait, so a signal arriving
+    // between a check and the wait is never lost
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    QueryServer server(publisher);
+    if (!server.start(socketPath, threads))
+        return 1;
+
+    Metrics metrics;
+    MetricsExporter exporter(metrics);
+    bool exporting = true;
+    if (!metricsFile.empty())
+        exporting = exporter.startFile(metricsFile, 1000);
+    else if (metricsPort > 0)
+        exporting = exporter.startServer(metricsPort);
+    if (!exporting)
+        return 1;
+    std::cout << "Serving " << regionFile << " (" << simulation.getWidth() << "x" << simulation.getHeight()
+              << ") on " << socketPath << " with " << threads << " query threads" << std::endl;
+
+    // Keep stepping even after the region settles, so queries always run against a live simulation
+    bool interrupted = false;
+    while (!interrupted && simulation.getStepCount() < maxSteps)
+    {
+        StepSummary summary = simulation.step();
+        metrics.recordStep(simulation, summary);
+        snapshot = publisher.acquire();
+        snapshot->build(simulation);
+        publisher.publish(snapshot);
+        interrupted = takeSignal(stopSignals);
+    }
+
+    if (!interrupted)
+    {
+        std::cout << "Simulation ended after " << simulation.getStepCount()
+                  << " steps; serving the final state until interrupted" << std::endl;
+        int signal;
+        sigwait(&stopSignals, &signal);
+    }
+
+    server.stop();
+    exporter.stop();
+    std::cout << "Answered " << server.getQueriesServed() << " queries" << std::endl;
+    return 0;
+}
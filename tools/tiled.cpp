@@ -0,0 +1,133 @@
+// tiled.cpp
+// Out-of-core simulation of regions stored as tile files. Only a bounded
+// cache of tiles is in memory at any time, so maps far larger than RAM can
+// be simulated. The tile file holds the simulation state and is updated in
+// place, so a later run continues where the previous one stopped.
+//
+// Usage:
+//   tiled convert REGION.csv OUT.tiles [--tile-size N]
+//   tiled run MAP.tiles [--steps N] [--refresh N] [--cache-mb M]
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "TileStore.h"
+#include "TiledSimulation.h"
+#include "StateHash.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: tiled convert REGION.csv OUT.tiles [--tile-size N]\n"
+              << "       tiled run MAP.tiles [--steps N] [--refresh N] [--cache-mb M]" << std::endl;
+}
+
+static int convert(int argc, char *argv[])
+{
+    int tileSize = TileStore::DEFAULT_TILE_SIZE;
+    for (int i = 4; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--tile-size" && i + 1 < argc)
+            tileSize = std::atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    if (tileSize <= 0 || tileSize > 4096)
+    {
+        std::cerr << "Error: --tile-size must be between 1 and 4096" << std::endl;
+        return 2;
+    }
+    return TileStore::convertRegionFile(argv[2], argv[3], tileSize) ? 0 : 1;
+}
+
+static void displayTotals(const TiledSimulation &simulation)
+{
+    std::cout << "Residential: " << simulation.getTotalPopulation('R')
+              << "  Commercial: " << simulation.getTotalPopulation('C')
+              << "  Industrial: " << simulation.getTotalPopulation('I')
+              << "  Pollution: " << simulation.getTotalPollution()
+              << "  Workers: " << simulation.getAvailableWorkers()
+              << "  Goods: " << simulation.getAvailableGoods() << std::endl;
+}
+
+static int run(int argc, char *argv[])
+{
+    int maxSteps = 50;
+    int refreshRate = 1;
+    long long cacheMb = 256;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--steps")
+            maxSteps = std::atoi(value.c_str());
+        else if (arg == "--refresh")
+            refreshRate = std::atoi(value.c_str());
+        else if (arg == "--cache-mb")
+            cacheMb = std::atoll(value.c_str());
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    if (maxSteps <= 0 || refreshRate <= 0 || cacheMb <= 0)
+    {
+        std::cerr << "Error: --steps, --refresh and --cache-mb must be positive" << std::endl;
+        return 2;
+    }
+
+    TileStore store;
+    if (!store.open(argv[2], static_cast<size_t>(cacheMb) * 1024 * 1024))
+        return 1;
+
+    std::cout << "Region " << store.getWidth() << "x" << store.getHeight() << " in "
+              << store.getTilesX() * store.getTilesY() << " tiles of " << store.getTileSize() << "x"
+              << store.getTileSize() << std::endl;
+
+    TiledSimulation simulation(store);
+    StateHash hash;
+    int timeStep = 0;
+    bool hasChanged = true;
+    while (timeStep < maxSteps && hasChanged)
+    {
+        hasChanged = simulation.step(&hash);
+        if (!store.good())
+            return 1;
+
+        if (timeStep % refreshRate == 0 || !hasChanged)
+        {
+            std::cout << "Time step " << timeStep << ": ";
+            displayTotals(simulation);
+        }
+        timeStep++;
+    }
+
+    if (!store.flush())
+        return 1;
+    std::cout << "Simulation ended after " << timeStep << " steps"
+              << (hasChanged ? "" : " (no further changes possible)") << std::endl;
+    std::cout << "Tiles read: " << store.getTileReads() << "  written: " << store.getTileWrites()
+              << "  cache: " << store.getCacheBytes() / 1024 << " KB" << std::endl;
+    std::cout << "State hash: " << std::hex << simulation.computeStateHash() << std::dec << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "convert" && argc >= 4)
+        return convert(argc, argv);
+    if (command == "run" && argc >= 3)
+        return run(argc, argv);
+    printUsage();
+    return 2;
+}